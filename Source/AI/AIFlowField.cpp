@@ -0,0 +1,64 @@
+#include "StdAfx.h"
+#include "AIFlowField.h"
+
+const int AIFlowField::dir_x[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+const int AIFlowField::dir_y[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const float AIFlowField::dir_len[8] = { 1, 1.41421356f, 1, 1.41421356f, 1, 1.41421356f, 1, 1.41421356f };
+
+AIFlowField::AIFlowField(int dx_, int dy_, const Vect2i& to)
+: dx(dx_), dy(dy_), to_(to)
+{
+	int size = dx*dy;
+	cost.assign(size, FLT_INF);
+	next.assign(size, -1);
+	state.assign(size, STATE_NONE);
+	expanded = 0;
+
+	xmin = xmax = to.x;
+	ymin = ymax = to.y;
+
+	int index = to.y*dx + to.x;
+	cost[index] = 0;
+	state[index] = STATE_OPEN;
+	open.push(Open(0, index));
+}
+
+void AIFlowField::touch(int x, int y)
+{
+	if(xmin > x)
+		xmin = x;
+	if(xmax < x)
+		xmax = x;
+	if(ymin > y)
+		ymin = y;
+	if(ymax < y)
+		ymax = y;
+}
+
+bool AIFlowField::intersect(int x1, int y1, int x2, int y2) const
+{
+	return x1 <= xmax && x2 >= xmin && y1 <= ymax && y2 >= ymin;
+}
+
+void AIFlowField::path(const Vect2i& from, std::vector<Vect2i>& out_path) const
+{
+	out_path.clear();
+	int index = from.y*dx + from.x;
+	xassert(state[index] == STATE_CLOSED);
+
+	Vect2i p = from;
+	out_path.push_back(p);
+	int prev_dir = -1;
+	// Каждый шаг уменьшает стоимость, длиннее пути быть не может
+	for(int steps = dx*dy; next[index] >= 0 && steps > 0; steps--){
+		int dir = next[index];
+		if(dir != prev_dir && prev_dir >= 0)
+			out_path.push_back(p);
+		prev_dir = dir;
+		p.x += dir_x[dir];
+		p.y += dir_y[dir];
+		index = p.y*dx + p.x;
+	}
+	if(out_path.back() != p)
+		out_path.push_back(p);
+}
@@ -0,0 +1,104 @@
+#ifndef __AIFLOWFIELD_H__
+#define __AIFLOWFIELD_H__
+
+#include <queue>
+
+//////////////////////////////////////////////////////////////////
+//  Поле направлений к одной точке назначения.
+//  Дейкстра по walk_map от точки назначения, для каждого тайла
+//  хранится стоимость пути и соседний тайл, в который надо идти.
+//  Поле раскрывается лениво: только до тайлов, из которых просили
+//  путь, поэтому стоит O(пройденной области) один раз на все юниты,
+//  идущие в эту точку. Координаты - тайлы AITileMap.
+//////////////////////////////////////////////////////////////////
+class AIFlowField
+{
+public:
+	AIFlowField(int dx, int dy, const Vect2i& to);
+
+	const Vect2i& to() const { return to_; }
+
+	// Раскрывает поле до тайла from, false - недостижим
+	template<class Heuristic>
+	bool settle(const Vect2i& from, const uint8_t* walk_map, Heuristic& heuristic)
+	{
+		int from_index = from.y*dx + from.x;
+		while(state[from_index] != STATE_CLOSED && !open.empty()){
+			Open top = open.top();
+			open.pop();
+			if(state[top.index] == STATE_CLOSED || top.cost > cost[top.index])
+				continue;
+			state[top.index] = STATE_CLOSED;
+			expanded++;
+
+			int x = top.index % dx;
+			int y = top.index / dx;
+			uint8_t walk_to = walk_map[top.index];
+			for(int dir = 0; dir < 8; dir++){
+				int xx = x - dir_x[dir];
+				int yy = y - dir_y[dir];
+				if(xx < 0 || xx >= dx || yy < 0 || yy >= dy)
+					continue;
+				int index = yy*dx + xx;
+				if(state[index] == STATE_CLOSED)
+					continue;
+				// Шаг из (xx,yy) в (x,y) в направлении dir
+				float c = top.cost + heuristic(walk_map[index], walk_to)*dir_len[dir];
+				if(c < cost[index]){
+					cost[index] = c;
+					next[index] = dir;
+					state[index] = STATE_OPEN;
+					open.push(Open(c, index));
+					touch(xx, yy);
+				}
+			}
+		}
+		return state[from_index] == STATE_CLOSED;
+	}
+
+	// Путь по полю от раскрытого тайла from до точки назначения,
+	// только тайлы, где меняется направление
+	void path(const Vect2i& from, std::vector<Vect2i>& out_path) const;
+
+	// Задевает ли прямоугольник тайлы, от которых зависит поле
+	bool intersect(int x1, int y1, int x2, int y2) const;
+
+	int expandedTiles() const { return expanded; }
+
+private:
+	enum {
+		STATE_NONE,
+		STATE_OPEN,
+		STATE_CLOSED
+	};
+
+	struct Open
+	{
+		float cost;
+		int index;
+
+		Open(float c, int i) : cost(c), index(i) {}
+		// Для priority_queue: меньшая стоимость, затем меньший индекс - первым
+		bool operator < (const Open& o) const { return cost != o.cost ? cost > o.cost : index > o.index; }
+	};
+
+	int dx, dy;
+	Vect2i to_;
+
+	std::vector<float> cost;
+	std::vector<signed char> next;
+	std::vector<uint8_t> state;
+	std::priority_queue<Open> open;
+	int expanded;
+
+	// Тайлы, попавшие в поле
+	int xmin, ymin, xmax, ymax;
+
+	static const int dir_x[8];
+	static const int dir_y[8];
+	static const float dir_len[8];
+
+	void touch(int x, int y);
+};
+
+#endif //__AIFLOWFIELD_H__
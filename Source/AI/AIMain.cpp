@@ -153,6 +153,9 @@ void AIPlayer::Quant()
 	FrameQuant();
 	BuildingQuant();
 
+	// Бюджет в проверках позиций, не во времени - иначе разойдутся сетевые копии
+	scheduler_.quant(ai_placement_iterations_per_quant);
+
 #ifndef _FINAL_VERSION_
 	XBuffer _queue(256, 1);
 	OrderBuildingActionMap::iterator ai;
@@ -161,6 +164,14 @@ void AIPlayer::Quant()
 	watch_i(_queue, playerID());
 	watch_i(builder_state, playerID());
 	watch_i(BuildingsUnderConstruction(), playerID());
+	int placeCoreQuants = scheduler_.stats(AI_TASK_PLACE_CORE).quantsLast;
+	int placeCoreQuantsMax = scheduler_.stats(AI_TASK_PLACE_CORE).quantsMax;
+	int placeBuildingQuants = scheduler_.stats(AI_TASK_PLACE_BUILDING).quantsLast;
+	int placeBuildingQuantsMax = scheduler_.stats(AI_TASK_PLACE_BUILDING).quantsMax;
+	watch_i(placeCoreQuants, playerID());
+	watch_i(placeCoreQuantsMax, playerID());
+	watch_i(placeBuildingQuants, playerID());
+	watch_i(placeBuildingQuantsMax, playerID());
 #endif
 
 	orderBuildingActions.clear();
@@ -190,6 +201,7 @@ void AIPlayer::TerrainWorkingComplete(int x1,int y1,int sx,int sy)
 		for(int x = x1;x < x2;x++)
 			if((*ai_tile_map)(x,y).update(x,y)) 
 				changeTileState(x,y);
+	ai_tile_map->invalidateSums(x1, y1);
 }
 
 ////////////////////////////////////////////
@@ -6,6 +6,7 @@
 #include "NetIncludes.h"
 #include "Universe.h"
 #include "Player.h"
+#include "AIScheduler.h"
 
 class PlaceScanOp;
 
@@ -114,11 +115,14 @@ protected:
 	Vect2i placement_coords;
 	Vect2i scanMin_, scanMax_; // world's scale
 	int scanStep_;
+	std::vector<Vect2i> placement_candidates; // позиции текущего кванта
 	class terBuildingInstaller* building_installer;
 	PlaceScanOp* place_scan_op;
 	Vect2f best_position;
 	DurationTimer building_pause;
 
+	AIScheduler scheduler_;
+
 	bool installingFrame_;
 	DurationTimer automaticUsingFieldTimer_;
 	bool onlyIfCoreDamaged_;
@@ -142,12 +146,15 @@ protected:
 	const Vect2f& bestPosition() const { return best_position; }
 
 	int calcWork(const Vect2i& left_top, const Vect2i& size);
+	// Работа для многих позиций сразу, -1 - нельзя копать
+	void calcWork(const std::vector<Vect2i>& left_tops, const Vect2i& size, std::vector<int>& works);
 	void changeTileState(int x,int y);//x,y в масштабе сетки
 
 	//----------------------
 	int calcWork(Circle& c);
 	void startPlace(PlaceScanOp* scan_op, const Vect2i& scan_min_, const Vect2i& scan_max_, int scan_step_);
-	void findWhereToDigQuant();
+	// Проверяет до budget позиций, возвращает потраченное
+	int findWhereToDigQuant(int budget);
 
 	void MoveBrigadiersToPoint(const Vect2f& pos,float radius);
 
@@ -159,6 +166,7 @@ protected:
 	//		Friends
 	friend class AITileMap;
 	friend PlaceScanOp;
+	friend class AIPlacementTask;
 	friend CircleShape;
 	friend struct AIRegionOrderOperation;
 };
@@ -0,0 +1,106 @@
+#include "StdAfx.h"
+#include "AIScheduler.h"
+
+AIScheduler::AIScheduler()
+{
+	next_ = 0;
+	running_ = false;
+}
+
+AIScheduler::~AIScheduler()
+{
+	clear();
+}
+
+void AIScheduler::add(AITask* task)
+{
+	xassert(task);
+	tasks_.push_back(task);
+}
+
+void AIScheduler::cancel(AITaskType type)
+{
+	TaskList::iterator i;
+	FOR_EACH(tasks_, i)
+		if((*i)->type() == type)
+			(*i)->cancelled_ = true;
+	// Из quant задачи удаляются после обхода
+	if(!running_)
+		removeFinished();
+}
+
+void AIScheduler::clear()
+{
+	xassert(!running_);
+	TaskList::iterator i;
+	FOR_EACH(tasks_, i)
+		delete *i;
+	tasks_.clear();
+	next_ = 0;
+}
+
+bool AIScheduler::active(AITaskType type) const
+{
+	TaskList::const_iterator i;
+	FOR_EACH(tasks_, i)
+		if((*i)->type() == type && !(*i)->cancelled_)
+			return true;
+	return false;
+}
+
+void AIScheduler::finish(AITask* task)
+{
+	Stats& s = stats_[task->type()];
+	s.decisions++;
+	s.quantsLast = task->quants();
+	s.quantsMax = max(s.quantsMax, task->quants());
+	s.quantsTotal += task->quants();
+	s.workTotal += task->work();
+	delete task;
+}
+
+void AIScheduler::removeFinished()
+{
+	for(int i = 0; i < tasks_.size();){
+		AITask* task = tasks_[i];
+		if(task->cancelled_ || task->done()){
+			if(task->cancelled_)
+				delete task;
+			else
+				finish(task);
+			tasks_.erase(tasks_.begin() + i);
+			if(next_ > i)
+				next_--;
+		}
+		else
+			i++;
+	}
+}
+
+void AIScheduler::quant(int budget)
+{
+	if(tasks_.empty())
+		return;
+	if(next_ >= tasks_.size())
+		next_ = 0;
+
+	// Поровну между задачами, недобранное переходит к следующим
+	TaskList queue(tasks_.begin() + next_, tasks_.end());
+	queue.insert(queue.end(), tasks_.begin(), tasks_.begin() + next_);
+	next_++;
+
+	running_ = true;
+	for(int i = 0; i < queue.size(); i++){
+		AITask* task = queue[i];
+		if(task->cancelled_ || task->done())
+			continue;
+		int share = max(budget/int(queue.size() - i), 1);
+		int used = task->quant(share);
+		task->quants_++;
+		task->work_ += used;
+		budget = max(budget - used, 0);
+	}
+	running_ = false;
+
+	removeFinished();
+}
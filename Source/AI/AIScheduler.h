@@ -0,0 +1,91 @@
+#ifndef __AISCHEDULER_H__
+#define __AISCHEDULER_H__
+
+//////////////////////////////////////////////////////////////////
+//  Кооперативный планировщик работы AI.
+//  Долгие поиски (место для здания, место копания) выполняются
+//  порциями в течение нескольких квантов. Бюджет кванта задается
+//  в единицах работы, а не во времени: на всех машинах сетевой
+//  игры задачи продвигаются одинаково.
+//  Кластерный анализ сюда не входит: граф кластеров (AITileMap,
+//  ClusterFind) общий для всех игроков и отрядов, строится из
+//  terUniverse::Quant и уже растянут на rebuildQuants квантов через
+//  ClusterFind::SetLater. Делить его бюджет между AIPlayer'ами значило
+//  бы оставить поиск пути отрядов на недостроенном графе.
+//////////////////////////////////////////////////////////////////
+
+enum AITaskType
+{
+	AI_TASK_PLACE_CORE,		// поиск места для ядра
+	AI_TASK_PLACE_BUILDING,	// поиск места для здания
+	AI_TASK_TYPE_MAX
+};
+
+class AITask
+{
+public:
+	AITask(AITaskType type) : type_(type), quants_(0), work_(0), cancelled_(false) {}
+	virtual ~AITask() {}
+
+	// Выполняет работу не больше budget единиц, возвращает потраченное
+	virtual int quant(int budget) = 0;
+	virtual bool done() const = 0;
+
+	AITaskType type() const { return type_; }
+	int quants() const { return quants_; }
+	int work() const { return work_; }
+
+private:
+	AITaskType type_;
+	int quants_;
+	int work_;
+	bool cancelled_;
+
+	friend class AIScheduler;
+};
+
+class AIScheduler
+{
+public:
+	// Сколько квантов и работы заняли завершенные задачи
+	struct Stats
+	{
+		int decisions;
+		int quantsLast;
+		int quantsMax;
+		int quantsTotal;
+		int workTotal;
+
+		Stats() : decisions(0), quantsLast(0), quantsMax(0), quantsTotal(0), workTotal(0) {}
+		float quantsAverage() const { return decisions ? (float)quantsTotal/decisions : 0; }
+	};
+
+	AIScheduler();
+	~AIScheduler();
+
+	// Задача переходит во владение планировщика
+	void add(AITask* task);
+	// Снимает незавершенные задачи типа, в статистику не попадают
+	void cancel(AITaskType type);
+	void clear();
+
+	// Задачи получают бюджет по очереди, начиная со следующей за
+	// первой обслуженной в прошлом кванте
+	void quant(int budget);
+
+	bool active(AITaskType type) const;
+	bool empty() const { return tasks_.empty(); }
+	const Stats& stats(AITaskType type) const { return stats_[type]; }
+
+private:
+	typedef std::vector<AITask*> TaskList;
+	TaskList tasks_;
+	int next_;
+	bool running_;
+	Stats stats_[AI_TASK_TYPE_MAX];
+
+	void finish(AITask* task);
+	void removeFinished();
+};
+
+#endif //__AISCHEDULER_H__
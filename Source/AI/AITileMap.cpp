@@ -2,6 +2,7 @@
 #include "AITileMap.h"
 #include "AIMain.h"
 #include "ClusterFind.h"
+#include "AIFlowField.h"
 #include "ForceField.h"
 #include "AIPrm.h"
 #include "Runtime.h"
@@ -59,6 +60,13 @@ AITileMap::AITileMap(int hsize,int vsize)
 	path_finder2 = new ClusterFind(sizeX(), sizeY(), terrainPathFind.clusterSize);
 	path_hard_map = new ClusterFind(sizeX(), sizeY(), terrainPathFind.clusterSize);
 
+	work_sum.assign((sizeX() + 1)*(sizeY() + 1), 0);
+	dig_less_sum.assign((sizeX() + 1)*(sizeY() + 1), 0);
+	sums_dirty_x = sizeX();
+	sums_dirty_y = sizeY();
+
+	path_quant = 0;
+
 	InitialUpdate(); 
 }
 AITileMap::~AITileMap()
@@ -67,6 +75,7 @@ AITileMap::~AITileMap()
 	delete path_finder;
 	delete path_finder2;
 	delete path_hard_map;
+	clearFlowFields();
 }
 
 void AITileMap::InitialUpdate()
@@ -74,6 +83,9 @@ void AITileMap::InitialUpdate()
 	for(int y=0;y < sizeY();y++)
 		for(int x=0;x < sizeX();x++)
 			(*this)(x,y).update(x,y);
+	invalidateSums(0, 0);
+
+	clearFlowFields();
 
 	rebuildWalkMap(path_finder->GetWalkMap());
 	path_finder->Set(terrainPathFind.enableSmoothing);
@@ -100,6 +112,50 @@ void AITileMap::UpdateRect(int x1,int y1,int dx,int dy)
 			FOR_EACH(call_back,it)
 				(*it)->changeTileState(x,y);
 		}
+
+	invalidateSums(x1, y1);
+}
+
+void AITileMap::invalidateSums(int x,int y)
+{
+	sums_dirty_x = min(sums_dirty_x, max(x, 0));
+	sums_dirty_y = min(sums_dirty_y, max(y, 0));
+}
+
+void AITileMap::updateSums()
+{
+	if(sums_dirty_x >= sizeX() || sums_dirty_y >= sizeY())
+		return;
+
+	// Меняются только суммы правее и ниже измененного угла,
+	// строки и столбцы на его границе остаются верными
+	int stride = sizeX() + 1;
+	for(int y = sums_dirty_y; y < sizeY(); y++){
+		const AITile* tile = &(*this)(sums_dirty_x, y);
+		int* work = &work_sum[sumIndex(sums_dirty_x + 1, y + 1)];
+		int* dig_less = &dig_less_sum[sumIndex(sums_dirty_x + 1, y + 1)];
+		for(int x = sums_dirty_x; x < sizeX(); x++, tile++, work++, dig_less++){
+			*work = tile->dig_work + work[-1] + work[-stride] - work[-stride - 1];
+			*dig_less = (tile->dig_less ? 1 : 0) + dig_less[-1] + dig_less[-stride] - dig_less[-stride - 1];
+		}
+	}
+
+	sums_dirty_x = sizeX();
+	sums_dirty_y = sizeY();
+}
+
+int AITileMap::workRect(int x1,int y1,int x2,int y2)
+{
+	updateSums();
+	x2++; y2++;
+	return work_sum[sumIndex(x2, y2)] - work_sum[sumIndex(x1, y2)] - work_sum[sumIndex(x2, y1)] + work_sum[sumIndex(x1, y1)];
+}
+
+int AITileMap::digLessRect(int x1,int y1,int x2,int y2)
+{
+	updateSums();
+	x2++; y2++;
+	return dig_less_sum[sumIndex(x2, y2)] - dig_less_sum[sumIndex(x1, y2)] - dig_less_sum[sumIndex(x2, y1)] + dig_less_sum[sumIndex(x1, y1)];
 }
 
 void AITileMap::placeBuilding(const Vect2i& v1, const Vect2i& size, bool place)
@@ -250,6 +306,93 @@ bool AITileMap::findPath(const Vect2i& from_w, const Vect2i& to_w, std::vector<V
 	return b;
 }
 
+bool AITileMap::findSharedPath(const Vect2i& from_w, const Vect2i& to_w, std::vector<Vect2i>& out_path, PathType type)
+{
+	Vect2i from = w2m(from_w);
+	Vect2i to = w2m(to_w);
+
+	if(!inside(from) || !inside(to))
+		return false;
+
+	std::list<FlowFieldEntry>::iterator it;
+	FOR_EACH(flow_fields,it)
+		if(it->to == to && it->type == type)
+			break;
+
+	if(it == flow_fields.end()){
+		// Первый запрос к точке - обычный поиск, поле строится, только если
+		// туда же пойдет кто-то еще
+		if(flow_fields.size() >= FLOW_FIELDS_MAX){
+			std::list<FlowFieldEntry>::iterator oldest = flow_fields.begin();
+			FOR_EACH(flow_fields,it)
+				if(oldest->last_quant > it->last_quant)
+					oldest = it;
+			delete oldest->field;
+			flow_fields.erase(oldest);
+		}
+		flow_fields.push_back(FlowFieldEntry(to, type));
+		flow_fields.back().last_quant = path_quant;
+		return findPath(from_w, to_w, out_path, type);
+	}
+
+	start_timer_auto(flowFieldPath,STATISTICS_GROUP_TOTAL);
+
+	FlowFieldEntry& entry = *it;
+	entry.last_quant = path_quant;
+	if(!entry.field)
+		entry.field = new AIFlowField(sizeX(), sizeY(), to);
+
+	// Стоимости те же, что и у findPath
+	bool b = false;
+	out_path.clear();
+	if(type == PATH_NORMAL){
+		ClusterHeuristic ch;
+		uint8_t* walk_map = path_finder->GetWalkMap();
+		if((b = entry.field->settle(from, walk_map, ch))){
+			entry.field->path(from, out_path);
+			SoftPath2(out_path, sizeX(), sizeY(), walk_map, ch);
+		}
+	}
+	else if(type == PATH_HARD){
+		ClusterHeuristicHard chh;
+		uint8_t* walk_map = path_hard_map->GetWalkMap();
+		if((b = entry.field->settle(from, walk_map, chh))){
+			entry.field->path(from, out_path);
+			SoftPath2(out_path, sizeX(), sizeY(), walk_map, chh);
+		}
+	}
+
+	if(out_path.size() > 1)
+		out_path.erase(out_path.begin());
+
+	std::vector<Vect2i>::iterator pi;
+	FOR_EACH(out_path,pi)
+		*pi = m2w(*pi);
+
+	if(!out_path.empty())
+		out_path.back() = to_w;
+
+	return b;
+}
+
+void AITileMap::clearFlowFields()
+{
+	std::list<FlowFieldEntry>::iterator it;
+	FOR_EACH(flow_fields,it)
+		delete it->field;
+	flow_fields.clear();
+}
+
+void AITileMap::invalidateFlowFields(int x1,int y1,int x2,int y2,PathType type)
+{
+	std::list<FlowFieldEntry>::iterator it;
+	FOR_EACH(flow_fields,it)
+		if(it->type == type && it->field && it->field->intersect(x1, y1, x2, y2)){
+			delete it->field;
+			it->field = 0;
+		}
+}
+
 void AITileMap::rebuildWalkMap(uint8_t* walk_map)
 {
 	int size = sizeY()*sizeX();
@@ -359,9 +502,37 @@ void AITileMap::recalcPathFind()
 {
 	start_timer_auto(calcPathMap,STATISTICS_GROUP_TOTAL);
 
+	path_quant++;
+	std::list<FlowFieldEntry>::iterator it;
+	for(it = flow_fields.begin(); it != flow_fields.end();){
+		if(path_quant - it->last_quant > FLOW_FIELD_LIFETIME){
+			delete it->field;
+			it = flow_fields.erase(it);
+		}
+		else
+			++it;
+	}
+
 	if(path_finder2->SetLaterQuant()){
 		std::swap(path_finder2,path_finder);
 
+		// Поля строились по старой карте, сбрасываем задетые изменениями
+		if(!flow_fields.empty()){
+			const uint8_t* walk_new = path_finder->GetWalkMap();
+			const uint8_t* walk_old = path_finder2->GetWalkMap();
+			int x1 = sizeX(), y1 = sizeY(), x2 = -1, y2 = -1;
+			for(int y = 0; y < sizeY(); y++)
+				for(int x = 0; x < sizeX(); x++, walk_new++, walk_old++)
+					if(*walk_new != *walk_old){
+						x1 = min(x1, x);
+						x2 = max(x2, x);
+						y1 = min(y1, y);
+						y2 = max(y2, y);
+					}
+			if(x2 >= 0)
+				invalidateFlowFields(x1, y1, x2, y2, PATH_NORMAL);
+		}
+
 		rebuildWalkMap(path_finder2->GetWalkMap());
 		path_finder2->SetLater(terrainPathFind.enableSmoothing,terrainPathFind.rebuildQuants);
 	}
@@ -414,11 +585,22 @@ void AITileMap::drawWalkMap()
 void AITileMap::updateHardMap()
 {
 	uint8_t* walk_map=path_hard_map->GetWalkMap();
-	int size = sizeY()*sizeX();
-	for(int i = 0;i < size;i++)
-	{
-		walk_map[i]=map()[i].dig_less?1:0;
-	}
+	// Поля PATH_HARD строились по старой карте, сбрасываем задетые изменениями
+	int x1 = sizeX(), y1 = sizeY(), x2 = -1, y2 = -1;
+	for(int y = 0; y < sizeY(); y++)
+		for(int x = 0; x < sizeX(); x++){
+			int i = y*sizeX() + x;
+			uint8_t walk = map()[i].dig_less?1:0;
+			if(walk_map[i] != walk){
+				walk_map[i] = walk;
+				x1 = min(x1, x);
+				x2 = max(x2, x);
+				y1 = min(y1, y);
+				y2 = max(y2, y);
+			}
+		}
+	if(x2 >= 0)
+		invalidateFlowFields(x1, y1, x2, y2, PATH_HARD);
 
 	path_hard_map->Set(terrainPathFind.enableSmoothing);
 	if(terrainPathFind.showMap==2)
@@ -5,6 +5,7 @@
 #include "Map2D.h"
 
 class ClusterFind;
+class AIFlowField;
 
 struct AITile
 {
@@ -38,6 +39,13 @@ public:
 	void InitialUpdate();
 	void UpdateRect(int x,int y,int dx,int dy); // world coords
 
+	// Суммы по прямоугольнику за O(1), map coords, границы включительно
+	int workRect(int x1,int y1,int x2,int y2); // сумма dig_work
+	int digLessRect(int x1,int y1,int x2,int y2); // количество некопаемых тайлов
+	// Тайлы правее и ниже (x,y) изменились, суммы пересчитаются при следующем запросе
+	void invalidateSums(int x,int y);
+	void updateSums();
+
 	// Установка зданий 
 	void placeBuilding(const Vect2i& v1, const Vect2i& size, bool place); // map coords
 	bool readyForBuilding(const Vect2i& v1, const Vect2i& size); // map coords
@@ -50,6 +58,9 @@ public:
 
 	// Поиск пути
 	bool findPath(const Vect2i& from, const Vect2i& to, std::vector<Vect2i>& out_path, PathType type);
+	// Путь к точке, куда идут многие юниты. Со второго запроса к тому же
+	// тайлу пути берутся из общего поля направлений, а не ищутся заново.
+	bool findSharedPath(const Vect2i& from, const Vect2i& to, std::vector<Vect2i>& out_path, PathType type);
 	void recalcPathFind();
 
 	// Debug
@@ -66,6 +77,35 @@ protected:
 	void updateWalkMap(uint8_t* walk_map);
 
 	void updateHardMap();
+
+	// Интегральные изображения dig_work и dig_less, (sizeX + 1)*(sizeY + 1).
+	// sum(x,y) - сумма по тайлам [0,x)*[0,y)
+	std::vector<int> work_sum;
+	std::vector<int> dig_less_sum;
+	int sums_dirty_x, sums_dirty_y; // левый верхний измененный тайл, sizeX(),sizeY() - актуальны
+
+	int sumIndex(int x,int y) const { return y*(sizeX() + 1) + x; }
+
+	enum {
+		FLOW_FIELDS_MAX = 8,
+		FLOW_FIELD_LIFETIME = 300 // кванты без запросов, после которых точка забывается
+	};
+
+	struct FlowFieldEntry
+	{
+		Vect2i to; // map coords
+		PathType type;
+		int last_quant;
+		AIFlowField* field; // 0 - к точке был только один запрос
+
+		FlowFieldEntry(const Vect2i& to_, PathType type_) : to(to_), type(type_), last_quant(0), field(0) {}
+	};
+	std::list<FlowFieldEntry> flow_fields;
+	int path_quant;
+
+	void clearFlowFields();
+	// Сбрасывает поля, зависящие от изменившихся тайлов walk_map
+	void invalidateFlowFields(int x1,int y1,int x2,int y2,PathType type);
 };
 
 
@@ -105,7 +105,7 @@ void AIPlayer::BuildingQuant()
 		break;
 
 	case FindingWhereToDig:
-		findWhereToDigQuant();
+		// Поиск идет в планировщике
 		break;
 
 	case Digging: {
@@ -166,10 +166,28 @@ bool AIPlayer::installFrameQuant()
 	return false;
 }
 
+// Поиск места под здание, от placeBuilding до FoundWhereToDig/UnableToFindWhereToDig
+class AIPlacementTask : public AITask
+{
+public:
+	AIPlacementTask(AIPlayer& aiPlayer, PlaceScanOp* scanOp)
+		: AITask(scanOp->attributeID() == UNIT_ATTRIBUTE_CORE ? AI_TASK_PLACE_CORE : AI_TASK_PLACE_BUILDING),
+		aiPlayer_(aiPlayer), scanOp_(scanOp) {}
+
+	int quant(int budget) { return aiPlayer_.findWhereToDigQuant(budget); }
+	bool done() const { return aiPlayer_.builder_state != AIPlayer::FindingWhereToDig || aiPlayer_.place_scan_op != scanOp_; }
+
+private:
+	AIPlayer& aiPlayer_;
+	PlaceScanOp* scanOp_;
+};
+
 void AIPlayer::placeBuilding(PlaceScanOp* scan_op)
 {
 	int offset = vMap.m2w(ai_border_offset);
 	startPlace(scan_op, Vect2i(offset, offset), Vect2i((int)vMap.H_SIZE - offset, (int)vMap.V_SIZE - offset), ai_scan_step);
+	if(scan_op)
+		scheduler_.add(new AIPlacementTask(*this, scan_op));
 	//log((char*)0);
 }
 
@@ -187,13 +205,15 @@ void AIPlayer::startPlace(PlaceScanOp* scan_op, const Vect2i& scanMin, const Vec
 	placement_coords = scanMin_ - Vect2i(scanStep_, 0);
 }
 
-void AIPlayer::findWhereToDigQuant()
+int AIPlayer::findWhereToDigQuant(int budget)
 {
 	start_timer_auto(findWhereToDigQuant, STATISTICS_GROUP_AI);
-	for(int i = 0; i < ai_placement_iterations_per_quant; i++) {
+	placement_candidates.clear();
+	for(int i = 0; i < budget; i++) {
 		if((placement_coords.x += scanStep_) >= scanMax_.x) {
 			placement_coords.x = scanMin_.x;
 			if((placement_coords.y += scanStep_) >= scanMax_.y) {
+				place_scan_op->checkPositions(placement_candidates);
 				if(place_scan_op->found()) {
 					if(scanStep_ > ai_scan_step_min) {
 						Vect2i pos = place_scan_op->bestPosition(); 
@@ -216,11 +236,13 @@ void AIPlayer::findWhereToDigQuant()
 						//log("UnableToFindWhereToDig");
 					}
 				}
-				return;
+				return i + 1;
 			}
 		}
-		place_scan_op->checkPosition(placement_coords);
+		placement_candidates.push_back(placement_coords);
 	}
+	place_scan_op->checkPositions(placement_candidates);
+	return budget;
 }
 
 void AIPlayer::startDigging(RegionDispatcher* region_disp)
@@ -256,6 +278,8 @@ void AIPlayer::clearPlaceOp()
 	building_pause.start(ai_building_pause + difficultyPrm().aiDelay);
 	builder_state = BuildingPause;
 
+	scheduler_.cancel(AI_TASK_PLACE_CORE);
+	scheduler_.cancel(AI_TASK_PLACE_BUILDING);
 	delete place_scan_op;
 	place_scan_op = 0;
 	if(currentOrder){
@@ -317,18 +341,18 @@ int AIPlayer::calcWork(const Vect2i& left_top_, const Vect2i& size)
 	  right_bottom.x >= clear_map.sizeX() - ai_border_offset || right_bottom.y >= clear_map.sizeY() - ai_border_offset)
 		return -1;
 
-	int work = 0;
-	for(int y = left_top.y; y <= right_bottom.y; y++)
-	{
-		for(int x = left_top.x; x <= right_bottom.x; x++)
-		{
-			AITile& ai_tile = (*ai_tile_map)(x,y);
-			if(ai_tile.dig_less)
-				return -1;
-			work += ai_tile.dig_work;
-		}
-	}
-	return work;
+	if(ai_tile_map->digLessRect(left_top.x, left_top.y, right_bottom.x, right_bottom.y))
+		return -1;
+	return ai_tile_map->workRect(left_top.x, left_top.y, right_bottom.x, right_bottom.y);
+}
+
+void AIPlayer::calcWork(const std::vector<Vect2i>& left_tops, const Vect2i& size, std::vector<int>& works)
+{
+	// Суммы пересчитываются один раз на всю пачку
+	ai_tile_map->updateSums();
+	works.resize(left_tops.size());
+	for(int i = 0; i < left_tops.size(); i++)
+		works[i] = calcWork(left_tops[i], size);
 }
 
 void AIPlayer::changeTileState(int x,int y)
@@ -38,6 +38,23 @@ public:
 	const Vect2f& boundMax() const { return bound_max; }
 
 	void checkPosition(const Vect2f& pos)
+	{
+		checkPosition(pos, aiPlayer_.calcWork(pos + bound_min, structureSize()));
+	}
+
+	// Пачка позиций: работа считается сразу для всех,
+	// некопаемые позиции отбрасываются до сканирования юнитов
+	void checkPositions(const std::vector<Vect2i>& positions)
+	{
+		left_tops_.resize(positions.size());
+		for(int i = 0; i < positions.size(); i++)
+			left_tops_[i] = Vect2f(positions[i]) + bound_min;
+		aiPlayer_.calcWork(left_tops_, structureSize(), works_);
+		for(int i = 0; i < positions.size(); i++)
+			checkPosition(positions[i], works_[i]);
+	}
+
+	void checkPosition(const Vect2f& pos, int work)
 	{
 		if(zeroLayerConnection_){
 			shapeOp_.shape().move(pos - position_);
@@ -54,50 +71,50 @@ public:
 		good_factor = 0; 
 		invalidPosition_ = false;
 
+		if(work < 0)
+			return;
+
 		universe()->UnitGrid.Scan(position_.x, position_.y, scan_radius, *this);
 		
-		if(!invalidPosition_ && connected_){
-			int work = aiPlayer_.calcWork(position_ + bound_min, structureSize());
-			
-			if(work >= 0){
-				good_factor += work*prm_.workFactor;
-				
-				if(prm_.frameDistanceFactor && aiPlayer_.frame())
-					good_factor += aiPlayer_.frame()->position2D().distance(position_)*prm_.frameDistanceFactor;
-				
-				if(prm_.enemyDistanceFactor)
-					good_factor += calcNearestEnemyDistance(position_)*prm_.enemyDistanceFactor;
-				
-				if(prm_.filthDistanceFactor){
-					terUnitBase* unit = universe()->worldPlayer()->findUnit(UNIT_ATTRIBUTE_FILTH_SPOT, position_);
-					if(unit)
-						good_factor += unit->position2D().distance(position_)*prm_.filthDistanceFactor;
-				}
-				
-				if(prm_.worldBuildingDistanceFactor){
-					terUnitBase* unit = universe()->worldPlayer()->findUnitByUnitClass(UNIT_CLASS_STRUCTURE | UNIT_CLASS_STRUCTURE_GUN, position_);
-					if(unit)
-						good_factor += unit->position2D().distance(position_)*prm_.worldBuildingDistanceFactor;
-					else
-						return;
-				}
-
-				if(prm_.corridorDistanceFactor){
-					terUnitBase* unit = universe()->worldPlayer()->findUnitByUnitClass(UNIT_CLASS_CORRIDOR, position_);
-					if(!unit)
-						unit = aiPlayer_.enemyPlayer()->findUnitByUnitClass(UNIT_CLASS_CORRIDOR, position_);
-					if(unit)
-						good_factor += unit->position2D().distance(position_)*prm_.corridorDistanceFactor;
-				}
-
-
-				if(best_factor < good_factor || !foundPosition_){
-					best_factor = good_factor;
-					best_position = position_;
-					best_connecting_building = good_connecting_building;
-					foundPosition_ = true;
-				}
-			}
+		if(invalidPosition_ || !connected_)
+			return;
+
+		good_factor += work*prm_.workFactor;
+		
+		if(prm_.frameDistanceFactor && aiPlayer_.frame())
+			good_factor += aiPlayer_.frame()->position2D().distance(position_)*prm_.frameDistanceFactor;
+		
+		if(prm_.enemyDistanceFactor)
+			good_factor += calcNearestEnemyDistance(position_)*prm_.enemyDistanceFactor;
+		
+		if(prm_.filthDistanceFactor){
+			terUnitBase* unit = universe()->worldPlayer()->findUnit(UNIT_ATTRIBUTE_FILTH_SPOT, position_);
+			if(unit)
+				good_factor += unit->position2D().distance(position_)*prm_.filthDistanceFactor;
+		}
+		
+		if(prm_.worldBuildingDistanceFactor){
+			terUnitBase* unit = universe()->worldPlayer()->findUnitByUnitClass(UNIT_CLASS_STRUCTURE | UNIT_CLASS_STRUCTURE_GUN, position_);
+			if(unit)
+				good_factor += unit->position2D().distance(position_)*prm_.worldBuildingDistanceFactor;
+			else
+				return;
+		}
+
+		if(prm_.corridorDistanceFactor){
+			terUnitBase* unit = universe()->worldPlayer()->findUnitByUnitClass(UNIT_CLASS_CORRIDOR, position_);
+			if(!unit)
+				unit = aiPlayer_.enemyPlayer()->findUnitByUnitClass(UNIT_CLASS_CORRIDOR, position_);
+			if(unit)
+				good_factor += unit->position2D().distance(position_)*prm_.corridorDistanceFactor;
+		}
+
+
+		if(best_factor < good_factor || !foundPosition_){
+			best_factor = good_factor;
+			best_position = position_;
+			best_connecting_building = good_connecting_building;
+			foundPosition_ = true;
 		}
 	}
 
@@ -235,6 +252,9 @@ protected:
 	bool zeroLayerConnection_;
 	GenShapeLineOp shapeOp_;
 
+	std::vector<Vect2i> left_tops_;
+	std::vector<int> works_;
+
 	int buildDuration_;
 };
 
@@ -131,12 +131,18 @@ void findGameContent() {
 
     //Path for content in preferences path
     std::string prefPath;
+    //Listing of content dirs from previous launch to avoid full scan
+    std::string scanCachePath;
     const char* prefPath_ptr = GET_PREF_PATH();
     if (prefPath_ptr) {
         prefPath = prefPath_ptr;
+        scanCachePath = prefPath + "ContentScan.cache";
         prefPath += "Content";
         SDL_free((void*) prefPath_ptr);
     }
+    int contentCache = 1;
+    check_command_line_parameter("content_cache", contentCache);
+    if (!contentCache) scanCachePath.clear();
     
 #ifndef _WIN32
     //On other OS data is usually separated from executable so is wise to check there first
@@ -198,7 +204,7 @@ void findGameContent() {
             //Set current path to game directory to allow relative paths inside
             //This is specially needed for MacOS as it forbids writing inside .app
             std::filesystem::current_path(rootPath);
-            if (scan_resource_paths("./")) {
+            if (scan_resource_paths_cached(scanCachePath)) {
                 if (convert_path_content("Perimeter.ini").empty()) {
                     fprintf(stderr, "Path for content doesn't contain game: %s\n", rootPathStr.c_str());
                 } else {
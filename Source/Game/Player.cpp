@@ -250,12 +250,8 @@ void terPlayer::setAI(bool isAI)
 int terPlayer::registerUnitID(int unitID) 
 { 
 	UnitCount = max(unitID, UnitCount); 
-	UnitList::iterator ui;
-	for (auto unit : Units) {
-        if (unitID == unit->unitID()) {
-            return ++UnitCount;
-        }
-    }
+	if(unitRegistry_.find(unitID))
+		return ++UnitCount;
 	return unitID;
 }
 
@@ -364,7 +360,8 @@ void terPlayer::DeleteQuant()
 			}
 			else{
 				CUNITS_LOCK(this);
-				ui = Units.erase(ui);
+				//removeUnit удаляет из Units сам
+				ui++;
 				removeUnit(unit);
 
 				unit->DeleteInterpolator();
@@ -464,6 +461,7 @@ void terPlayer::addUnit(terUnitBase* unit)
 
 	CUNITS_LOCK(this);
 	Units.push_back(unit);
+	unitRegistry_.add(unit, --Units.end());
 
 	if(unit->attr()->isBuilding()){// && unit->isBuilding()
 		BuildingList[unit->attr()->ID].push_back(safe_cast<terBuilding*>(unit));
@@ -496,12 +494,22 @@ void terPlayer::removeUnit(terUnitBase* unit)
 	}
 
 	CUNITS_LOCK(this);
-	Units.erase(remove(Units.begin(), Units.end(), unit), Units.end());
+	UnitList::iterator position;
+	if(unitRegistry_.remove(unit, position))
+		Units.erase(position);
+	else
+		Units.erase(remove(Units.begin(), Units.end(), unit), Units.end());
 
 	if(frame_ == unit)
 		clearFrame();
 }
 
+void terPlayer::updateUnitIndex(terUnitBase* unit)
+{
+	CUNITS_LOCK(this);
+	unitRegistry_.update(unit);
+}
+
 void terPlayer::clearFrame() 
 { 
 	if(!frame())
@@ -771,72 +779,31 @@ void terPlayer::ScanAbyssRegion(RegionDispatcher* region)
 terUnitBase* terPlayer::findUnit(terUnitAttributeID id)
 {
 	MTL();
-	UnitList::iterator ui;
-	FOR_EACH(Units,ui)
-		if((*ui)->attr()->ID == id)
-			return (*ui);
-		
-	return 0;
+	return unitRegistry_.find(id);
 }
 
 terUnitBase* terPlayer::findUnit(terUnitAttributeID id, const Vect2f& nearPosition, float distanceMin)
 {
 	MTL();
-	terUnitBase* bestUnit = 0;
-	float dist, bestDist = FLT_INF;
-	UnitList::iterator ui;
-	if(id != UNIT_ATTRIBUTE_ANY){
-		FOR_EACH(Units,ui)
-			if((*ui)->attr()->ID == id && bestDist > (dist = nearPosition.distance2((*ui)->position2D())) && dist > sqr(distanceMin)){
-				bestDist = dist;
-				bestUnit = *ui;
-			}
-	}
-	else{
-		FOR_EACH(Units,ui)
-			if((*ui)->attr()->ID < UNIT_ATTRIBUTE_LEGIONARY_MAX && bestDist > (dist = nearPosition.distance2((*ui)->position2D())) && dist > sqr(distanceMin)){
-				bestDist = dist;
-				bestUnit = *ui;
-			}
-	}
-	return bestUnit;
+	return unitRegistry_.findNearest(id, nearPosition, distanceMin);
 }
 
 terUnitBase* terPlayer::findUnitByUnitClass(int unitClass, const Vect2f& nearPosition, float distanceMin)
 {
 	MTL();
-	terUnitBase* bestUnit = 0;
-	float dist, bestDist = FLT_INF;
-	UnitList::iterator ui;
-	FOR_EACH(Units,ui)
-		if(((*ui)->unitClass() & unitClass) && bestDist > (dist = nearPosition.distance2((*ui)->position2D())) 
-		  && ((*ui)->isConstructed() || (*ui)->isUpgrading()) && dist > sqr(distanceMin)){
-			bestDist = dist;
-			bestUnit = *ui;
-		}
-	return bestUnit;
+	return unitRegistry_.findNearestByClass(unitClass, nearPosition, distanceMin);
 }
 
 terUnitBase* terPlayer::findUnit(unsigned int unit_id)
 {
 	MTL();
-	UnitList::iterator ui;
-	FOR_EACH(Units,ui)
-		if((*ui)->unitID() == unit_id)
-			return (*ui);
-
-	return 0;
+	return unitRegistry_.find(unit_id);
 }
 
 terUnitBase* terPlayer::findUnitByLabel(const char* label)
 {
 	MTAuto lock(UnitsLock());
-	UnitList::iterator ui;
-	FOR_EACH(Units,ui)
-		if(!strcmp((*ui)->label(), label))
-			return (*ui);
-		
-		return 0;
+	return unitRegistry_.findByLabel(label);
 }
 
 
@@ -1236,13 +1203,7 @@ int terPlayer::countUnits(terUnitAttributeID id) const
 	if(id < UNIT_ATTRIBUTE_STRUCTURE_MAX)
 		return buildingList(id).size();
 
-	int count  = 0;
-	UnitList::const_iterator ui;
-	FOR_EACH(Units, ui)
-		if((*ui)->attr()->ID == id)
-			++count;
-	
-	return count;
+	return unitRegistry_.count(id);
 }
 
 int terPlayer::countBuildingsConstructed(terUnitAttributeID id) const
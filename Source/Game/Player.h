@@ -6,6 +6,7 @@
 #include "IronBuilding.h"
 #include "FrameField.h"
 #include "DefenceMap.h"
+#include "UnitRegistry.h"
 #include "Save.h"
 #include "SelectManager.h"
 #include "PerimeterSound.h"
@@ -402,6 +403,8 @@ public:
     terUnitBase* loadUnit(SaveUnitData* data, bool auto_load = true);
 	virtual void addUnit(terUnitBase* p);
 	virtual void removeUnit(terUnitBase* p);
+	//Вызывать при смене ID, класса или метки юнита
+	void updateUnitIndex(terUnitBase* p);
 	
 	void killAllUnits();
 	void removeUnits();
@@ -542,6 +545,7 @@ public:
 protected:
 	MTSection units_lock;
 	UnitList Units;
+	UnitRegistry unitRegistry_;
 	SquadList squads;
 
 	std::list<double> begin_time_burn_zeroplast;
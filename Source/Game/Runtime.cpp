@@ -50,6 +50,8 @@
 
 #include "../HT/mt_config.h"
 #include "../HT/ht.h"
+#include "../HT/Telemetry.h"
+#include "xjobs.h"
 #include "GraphicsOptions.h"
 #include "GameContent.h"
 
@@ -311,6 +313,9 @@ void HTManager::init()
 
 	allocation_tracking("PerimeterLogicInit");
 
+	frame_telemetry.init();
+	parallel_init();
+
 	start_timer=false;
 };
 
@@ -334,7 +339,7 @@ void HTManager::done()
 bool HTManager::LogicQuant()
 {
 	{
-		MTAuto lock(&lock_logic);
+		TelemetryAutoLock lock(&lock_logic, TELEMETRY_LOCK_LOGIC_WAIT);
 		if(universe())
 		{
 			terVisGeneric->SetLogicQuant(universe()->quantCounter()+2);
@@ -352,14 +357,26 @@ bool HTManager::LogicQuant()
 
 	bool b;
 	{
-		MTAuto lock(&lock_logic);
+		TelemetryAutoLock lock(&lock_logic, TELEMETRY_LOCK_LOGIC_WAIT);
+		uint64_t quant_start=clock_us();
 		b=gameShell->LogicQuant();
+		if(b)
+		{
+			frame_telemetry.add(TELEMETRY_LOGIC_QUANT, (clock_us()-quant_start)*1e-3f);
+			if(universe() && universe()->multiPlayer())
+				frame_telemetry.add(TELEMETRY_CONFIRM_LAG, int(universe()->getCurrentGameQuant()-universe()->getConfirmQuant()));
+			SlabAllocator::Stats slab_stats=SlabAllocator::quantStats();
+			frame_telemetry.add(TELEMETRY_SLAB_ALLOCS, slab_stats.allocs);
+			frame_telemetry.add(TELEMETRY_SLAB_FREES, slab_stats.frees);
+			frame_telemetry.add(TELEMETRY_SLAB_USED, slab_stats.used);
+		}
 	}
 
 	if(b)
 	{
 		MTAuto lock(&lock_fps);
 		logic_fps.quant();
+		frame_telemetry.logicQuantDone();
 	}
 
 	return b;
@@ -367,6 +384,8 @@ bool HTManager::LogicQuant()
 
 void HTManager::GraphQuant()
 {
+	uint64_t frame_start=clock_us();
+
 	if(universe())
 	{
 		int quant_counter=universe()->quantCounter();
@@ -384,6 +403,9 @@ void HTManager::GraphQuant()
 	gb_VisGeneric->SetInterpolationFactor(interpolation_factor_);
 	stream_interpolator.ProcessData();
 	gameShell->GraphQuant();
+
+	if(universe())
+		frame_telemetry.graphFrameDone((clock_us()-frame_start)*1e-3f, interpolation_factor_);
 }
 
 //--------------------------------
@@ -820,6 +842,15 @@ void SoundQuant()
 
 	snd_listener.Update();
 
+	if(frame_telemetry.enabled())
+	{
+		const SNDVoiceStats& stats=SNDGetVoiceStats();
+		frame_telemetry.add(TELEMETRY_SOUND_UPDATE, stats.update_ms);
+		frame_telemetry.add(TELEMETRY_SOUND_VOICES, stats.active);
+		frame_telemetry.add(TELEMETRY_SOUND_VIRTUAL, stats.virtual_voices);
+		frame_telemetry.add(TELEMETRY_SOUND_MIXING, stats.mixing);
+	}
+
 	MusicQuant();
 }
 
@@ -889,12 +920,28 @@ void show_help() {
             "    stack_frames/stack_reference - Parameters provided by crash dumps to allow reconstructing stacktrace using same binary\n"
             "    xprm_compiler - Enables runtime XPrm compilation and compiler for .prm files\n"
             "    not_triggerchains_binary=1 - Disallows loading triggerchain stored in .bin instead of .spg\n"
+            "    save_text=1 - Writes user saves and network save data as text instead of compressed binary\n"
+            "    save_stats=1 - Prints size and save/load time of text and binary formats on each save\n"
+            "    ground_sample_bench=1 - Prints terrain sampling rate of ground units in bodies/ms after mission load\n"
+            "    contact_stress=N - Spawns N touching soldiers of active player and prints contact resolve time every 100 quants\n"
+            "    unit_registry_bench=N - Fills each player up to N units on load and prints unit ID lookup rate of index and list scan\n"
             "    debug_key_handler=1 - Enables debug key handler\n"
             "    explore=1 - Opens Debug.prm editor and closes game\n"
             "    compress_worlds=0/1 - Attempts to decompress or compress all worlds\n"
             "    start_splash=0/1 - Enables or disables intro movies\n"
             "    show_fps=0/1 - Displays FPS counter\n"
+            "    render_merge_commands=0 - Disables joining of consecutive draw commands with same state in Sokol renderer\n"
+            "    render_parallel_predraw=0 - Disables parallel visibility test and node matrices update of models\n"
+            "    render_grid_culling=0 - Disables culling of models by scene grid cells before visibility test\n"
+            "    render_parallel_effects=0 - Disables parallel update of particle emitters\n"
+            "    render_asset_streaming=0 - Disables background loading of model files and textures\n"
+            "    render_library_bench=1 - Prints lookup rate of loaded models and textures by index and by list scan after mission load\n"
+            "    render_mesh_instancing=0 - Disables drawing of meshes with same material as single batch in Sokol renderer\n"
+            "    effect_bench=N - Places N looped volcano effects in camera view after mission start and prints particles/ms of effect update and draw with parallel effects on and off\n"
+            "    render_instancing_bench=N - Places N soldiers in camera view after mission start and prints draw calls and submit time with mesh instancing on and off\n"
             "    convert=1 - Saves opened map and closes game\n"
+            "    save_quant_crc=file - Writes CRC of logic log of every quant into file, run the same replay to compare builds\n"
+            "    verify_quant_crc=file - Compares CRC of every quant with file from save_quant_crc and stops at first desync\n"
             "\n"
             "    More info and source code: https://github.com/KD-lab-Open-Source/Perimeter\n"
             "\n"
@@ -922,6 +969,8 @@ void show_help() {
             "    disable_sound=1 - Disables sound in this launch\n"
             "    initial_menu= - Tells game to load this menu screen as initial menu, examples can be SINGLE, MULTIPLAYER_LIST, BATTLE...\n"
             "    content=path/of/game - Use this path for game data/content (must contain Resource, Scripts...)\n"
+            "    content_cache=0 - Scans all game content dirs instead of using listing cached from previous launch\n"
+            "    influence_map_async=1 - Updates squad threat maps on a worker thread while units move\n"
             "    clearlocale=1 - Clears current default and displays language dialog\n"
             "    locale=Russian - Use different language than current default\n"
             "    --version -v - Shows version\n"
@@ -69,6 +69,7 @@
 
 #include "XPrmArchive.h"
 #include "BinaryArchive.h"
+#include "xjobs.h"
 
 #include "BelligerentSelect.h"
 #include "GameContent.h"
@@ -152,6 +153,7 @@ void terUniverse::clear() {
         delete p;
     }    
     Players.clear();
+    influenceMap.clear();
 
     active_player_ = nullptr;
 
@@ -164,6 +166,10 @@ terUniverse::~terUniverse()
 
     clear();
 
+	if (terVisGeneric) {
+		terVisGeneric->ClearPrefetch();
+	}
+
 	delete ai_tile_map;
 	ai_tile_map = 0;
 
@@ -225,14 +231,146 @@ struct terMapGridUpdateOperator
 
 	void operator()(terTerraformGeneral* p)
 	{		
+		terTrustMapStats& stats = dispathcer->GetQuantStats();
+		stats.update_scanned++;
+		// Ячейки сетки крупнее элементов, пересчитываем только задетые
+		if(p->PositionX + TERRAFORM_ELEMENT_SIDE < x0 || p->PositionX - TERRAFORM_ELEMENT_SIDE > x1 ||
+		   p->PositionY + TERRAFORM_ELEMENT_SIDE < y0 || p->PositionY - TERRAFORM_ELEMENT_SIDE > y1)
+			return;
 		if(p->CollisionCount != terRealCollisionCount && p->Type != TERRAFORM_TYPE_GARBAGE){
 			MetaRegionLock lock(dispathcer->GetPlayer()->RegionPoint);
 			p->Quant(dispathcer,false);
 			p->CollisionCount = terRealCollisionCount;
+			stats.update_quants++;
 		}
 	}
 };
 
+//Стресс-тест контактов: contact_stress=N ставит N солдат активного игрока вплотную друг к другу,
+//раз в 100 квантов печатается среднее число контактов, островов и время resolve
+static struct {
+    int bodies = 0;
+    int quants = 0;
+    int64_t contacts = 0;
+    int64_t islands = 0;
+    uint64_t time = 0;
+} contactStress;
+
+static void spawnContactStress(int count) {
+    terPlayer* player = universe()->activePlayer();
+    if (!player || count <= 0) {
+        return;
+    }
+    int side = static_cast<int>(xm::ceil(xm::sqrt(static_cast<float>(count))));
+    Vect2f center(vMap.H_SIZE/2, vMap.V_SIZE/2);
+    float spacing = 0;
+    for (int i = 0; i < count; i++) {
+        terUnitBase* unit = player->buildUnit(UNIT_ATTRIBUTE_SOLDIER);
+        if (!unit) {
+            break;
+        }
+        //Центры ближе двух радиусов, соседи касаются с первого кванта
+        if (!spacing) {
+            spacing = unit->radius()*1.5f;
+        }
+        Vect2f position = center + Vect2f(i % side - side/2, i/side - side/2)*spacing;
+        unit->setPose(Se3f(QuatF::ID, To3D(position)), true);
+        unit->Start();
+    }
+    contactStress.bodies = count;
+}
+
+//Плотная армия: render_instancing_bench=N ставит N одинаковых солдат в точку, куда смотрит камера,
+//когда ролик начала миссии уже отыгран, и запускает замер отрисовки с инстансингом мешей и без
+static struct {
+    int units = 0;
+    int quants = 0;
+} instancingBench;
+
+static void instancingBenchQuant() {
+    const int START_QUANT = 50;
+    if (++instancingBench.quants != START_QUANT) {
+        return;
+    }
+    terPlayer* player = universe()->activePlayer();
+    if (!player || !terCamera) {
+        return;
+    }
+    int side = static_cast<int>(xm::ceil(xm::sqrt(static_cast<float>(instancingBench.units))));
+    Vect2f center(terCamera->coordinate().position());
+    float spacing = 0;
+    for (int i = 0; i < instancingBench.units; i++) {
+        terUnitBase* unit = player->buildUnit(UNIT_ATTRIBUTE_SOLDIER);
+        if (!unit) {
+            break;
+        }
+        //Без перекрытия, чтобы не разлетались в первые кадры замера
+        if (!spacing) {
+            spacing = unit->radius()*2.5f;
+        }
+        Vect2f position = center + Vect2f(i % side - side/2, i/side - side/2)*spacing;
+        position.x = clamp(position.x, 0, vMap.H_SIZE - 1);
+        position.y = clamp(position.y, 0, vMap.V_SIZE - 1);
+        unit->setPose(Se3f(QuatF::ID, To3D(position)), true);
+        unit->Start();
+    }
+    if (terRenderDevice) {
+        terRenderDevice->StartInstancingBenchmark(100);
+    }
+}
+
+//Тяжелые эффекты: effect_bench=N ставит N зацикленных эффектов вулкана в точку камеры
+//после ролика начала миссии и запускает замер обновления и отрисовки частиц сцены.
+//Эффекты удаляются вместе с прочими автоудаляемыми в clear()
+static struct {
+    int effects = 0;
+    int quants = 0;
+} effectBench;
+
+static void effectBenchQuant() {
+    const int START_QUANT = 50;
+    if (++effectBench.quants != START_QUANT || !terCamera) {
+        return;
+    }
+    EffectLibrary* lib = gb_VisGeneric->GetEffectLibrary("Volcano");
+    EffectKey* key = lib ? lib->Get("effect_23") : nullptr;
+    if (!key) {
+        fprintf(stderr, "Effect bench: Volcano effect_23 not found\n");
+        return;
+    }
+    int side = static_cast<int>(xm::ceil(xm::sqrt(static_cast<float>(effectBench.effects))));
+    Vect2f center(terCamera->coordinate().position());
+    const float spacing = 64;
+    for (int i = 0; i < effectBench.effects; i++) {
+        Vect2f position = center + Vect2f(i % side - side/2, i/side - side/2)*spacing;
+        position.x = clamp(position.x, 0, vMap.H_SIZE - 1);
+        position.y = clamp(position.y, 0, vMap.V_SIZE - 1);
+        cEffect* effect = terScene->CreateEffect(*key, nullptr, 1.0f, true);
+        effect->SetCycled(true);
+        effect->SetPosition(MatXf(Mat3f::ID, To3D(position)));
+    }
+    terScene->StartEffectBenchmark(100);
+}
+
+static void contactStressResolve(MultiBodyDispatcher& dispatcher) {
+    int contacts = dispatcher.contactsCount();
+    uint64_t time_start = clock_us();
+    dispatcher.resolve();
+    contactStress.time += clock_us() - time_start;
+    contactStress.contacts += contacts;
+    contactStress.islands += contacts ? dispatcher.islandsCount() : 0;
+
+    if (++contactStress.quants == 100) {
+        fprintf(stderr, "Contact stress: %d bodies, %d threads, %.1f contacts %.1f islands, resolve %.3f ms per quant\n",
+                contactStress.bodies, parallel_threads(),
+                contactStress.contacts/100.0, contactStress.islands/100.0, contactStress.time*1e-5);
+        contactStress.quants = 0;
+        contactStress.contacts = 0;
+        contactStress.islands = 0;
+        contactStress.time = 0;
+    }
+}
+
 void terUniverse::Quant()
 {
 	start_timer_auto(UniverseQuant,STATISTICS_GROUP_TOTAL);
@@ -261,7 +399,18 @@ void terUniverse::Quant()
 	FOR_EACH(Players, pi)
 		(*pi)->CollisionQuant();
 
-	multibody_dispatcher.resolve();
+	if(instancingBench.units)
+		instancingBenchQuant();
+	if(effectBench.effects)
+		effectBenchQuant();
+
+	if(contactStress.bodies)
+		contactStressResolve(multibody_dispatcher);
+	else
+		multibody_dispatcher.resolve();
+
+	unitQuery.build(Players, quant_counter_, vMap.H_SIZE, vMap.V_SIZE);
+	influenceMap.update(Players, vMap.H_SIZE, vMap.V_SIZE);
 
 	FOR_EACH(Players, pi)
 		(*pi)->MoveQuant();
@@ -289,11 +438,16 @@ void terUniverse::Quant()
 		PlayerVect::iterator it_player;
 		FOR_EACH(Players,it_player)
 		{
+			if((*it_player)->TrustMap->Empty())
+				continue;
 			op.dispathcer=(*it_player)->TrustMap;
 			(*it_player)->TrustMap->TrustGrid.Scan(op.x0, op.y0, op.x1, op.y1, op);
 		}
 	}
 
+	FOR_EACH(Players, pi)
+		(*pi)->TrustMap->StatsQuant();
+
 	terCamera->destroyLink();
 
 	FOR_EACH(Players, pi)
@@ -583,6 +737,83 @@ int terUniverse::SelectUnit(terUnitBase* p)
 
 //---------------------------------------------------------
 
+//Модели юнитов сторон миссии читаются в фоне, пока идет остальная загрузка,
+//чтобы первое появление юнита нового типа не ждало диска
+static void prefetchUnitModels(const MissionDescription& mission) {
+    std::vector<terBelligerent> belligerents = { BELLIGERENT_NONE, BELLIGERENT_EXODUS0 };
+    for (auto& playerData : mission.playersData) {
+        if (playerData.realPlayerType == REAL_PLAYER_TYPE_PLAYER
+            || playerData.realPlayerType == REAL_PLAYER_TYPE_AI
+            || playerData.realPlayerType == REAL_PLAYER_TYPE_PLAYER_AI) {
+            belligerents.push_back(playerData.belligerent);
+        }
+    }
+
+    for (auto& it : attributeLibrary().map()) {
+        if (std::find(belligerents.begin(), belligerents.end(), it.first.belligerent()) == belligerents.end()) {
+            continue;
+        }
+        const AttributeBase* attr = it.second();
+        if (attr->modelData.modelName) {
+            terVisGeneric->PrefetchObject(attr->modelData.modelName);
+        }
+        for (auto& model : attr->additionalModelsData) {
+            if (model.modelName) {
+                terVisGeneric->PrefetchObject(model.modelName);
+            }
+        }
+    }
+}
+
+//Версия бинарных сохранений, для конвертации через ar.laterThan(version)
+static const int SAVE_BINARY_VERSION = 1;
+
+//Пользовательские сохранения и передача сохранений по сети в бинарном виде,
+//миссии редактора остаются текстовыми
+static bool binarySavesEnabled() {
+    return !check_command_line("save_text");
+}
+
+//Сравнение текстового и бинарного формата на текущем сохранении
+static void printSaveStats(const MissionDescription& mission, const SavePrm& savePrm) {
+    uint64_t time_start = clock_us();
+    XPrmOArchive oa;
+    oa << WRAP_NAME(mission, "MissionDescriptionPrm");
+    oa << WRAP_NAME(savePrm, "SavePrm");
+    size_t text_size = oa.buffer().tell();
+
+    uint64_t time_text_saved = clock_us();
+    BinaryOArchive boa(nullptr, SAVE_BINARY_VERSION);
+    boa.setCompression(true);
+    boa << WRAP_NAME(mission, "MissionDescriptionPrm");
+    boa << WRAP_NAME(savePrm, "SavePrm");
+    XBuffer packed(0, true);
+    boa.finalBuffer(packed);
+    size_t binary_size = packed.tell();
+
+    uint64_t time_binary_saved = clock_us();
+    MissionDescription missionLoaded;
+    SavePrm savePrmLoaded;
+    XPrmIArchive ia;
+    std::swap(ia.buffer(), oa.buffer());
+    ia.reset();
+    ia >> WRAP_NAME(missionLoaded, "MissionDescriptionPrm");
+    ia >> WRAP_NAME(savePrmLoaded, "SavePrm");
+
+    uint64_t time_text_loaded = clock_us();
+    BinaryIArchive bia;
+    std::swap(bia.buffer(), packed);
+    if (bia.reset()) {
+        bia >> WRAP_NAME(missionLoaded, "MissionDescriptionPrm");
+        bia >> WRAP_NAME(savePrmLoaded, "SavePrm");
+    }
+    uint64_t time_binary_loaded = clock_us();
+
+    fprintf(stderr, "Save stats: text %" PRIsize " bytes save %.2f ms load %.2f ms, binary %" PRIsize " bytes save %.2f ms load %.2f ms\n",
+            text_size, (time_text_saved - time_start) * 1e-3, (time_text_loaded - time_binary_saved) * 1e-3,
+            binary_size, (time_binary_saved - time_text_saved) * 1e-3, (time_binary_loaded - time_text_loaded) * 1e-3);
+}
+
 void MissionDescription::refresh() {
     //if(gameType_ != GT_PLAY_RELL){
         if (!savePathKey_.empty()) {
@@ -630,7 +861,11 @@ void MissionDescription::loadDescription() {
         getMissionDescriptionInThePlayReelFile(playReelPath().c_str(), *this);
     } else {
         if (!savePathContent_.empty()) {
-            if (getExtension(savePathContent_, true) == "spg") {
+            //Бинарные сохранения могут иметь расширение spg
+            BinaryIArchive bia;
+            if (bia.open(savePathContent_.c_str())) {
+                bia >> WRAP_NAME(*this, "MissionDescriptionPrm");
+            } else if (getExtension(savePathContent_, true) == "spg") {
                 std::string headerName = setExtension(savePathContent_, "sph");
                 XPrmIArchive ia;
                 if (ia.open(headerName.c_str())) {
@@ -640,10 +875,7 @@ void MissionDescription::loadDescription() {
                 }
                 ia >> WRAP_NAME(*this, "MissionDescriptionPrm");
             } else {
-                BinaryIArchive bia;
-                if (!bia.open(savePathContent_.c_str()))
-                    return;
-                bia >> WRAP_NAME(*this, "MissionDescriptionPrm");
+                return;
             }
             
             //Adjust arrays
@@ -714,7 +946,12 @@ bool MissionDescription::loadMission(SavePrm& savePrm) const
 	savePrm = SavePrm();
 	MissionDescription missionDescription;
 	
-	if(getExtension(savePathContent_, true) == "spg"){
+	BinaryIArchive bia;
+	if(bia.open(savePathContent_.c_str())){
+		bia >> WRAP_NAME(missionDescription, "MissionDescriptionPrm");
+		bia >> WRAP_NAME(savePrm, "SavePrm");
+	}
+	else if(getExtension(savePathContent_, true) == "spg"){
 		XPrmIArchive ia;
 		if(!ia.open(savePathContent_.c_str())) {
             return false;
@@ -723,17 +960,12 @@ bool MissionDescription::loadMission(SavePrm& savePrm) const
 		ia >> WRAP_NAME(savePrm, "SavePrm");
 	}
 	else{
-		BinaryIArchive bia;
-		if(!bia.open(savePathContent_.c_str())) {
-            return false;
-        }
-		bia >> WRAP_NAME(missionDescription, "MissionDescriptionPrm");
-		bia >> WRAP_NAME(savePrm, "SavePrm");
+		return false;
 	}
 	return true;
 }
 
-bool MissionDescription::saveMission(const SavePrm& savePrm, bool userSave) const 
+bool MissionDescription::saveMission(const SavePrm& savePrm, bool userSave, bool text) const 
 {
 	MissionDescription data = *this;
     
@@ -752,9 +984,17 @@ bool MissionDescription::saveMission(const SavePrm& savePrm, bool userSave) cons
 		data.originalSaveName = strstr(name.c_str(), "resource");
 	}
 
-//	BinaryOArchive boa(setExtension(saveName(), "spb").c_str());
-//	boa << WRAP_NAME(data, "MissionDescriptionPrm");
-//	boa << WRAP_NAME(savePrm, "SavePrm");
+    if (check_command_line("save_stats")) {
+        printSaveStats(data, savePrm);
+    }
+
+    if (userSave && !text && binarySavesEnabled()) {
+        BinaryOArchive boa(setExtension(savePathContent(), "spg").c_str(), SAVE_BINARY_VERSION);
+        boa.setCompression(true);
+        boa << WRAP_NAME(data, "MissionDescriptionPrm");
+        boa << WRAP_NAME(savePrm, "SavePrm");
+        return boa.close();
+    }
 
     XPrmOArchive oa(setExtension(savePathContent(), "spg").c_str());
     oa << WRAP_NAME(data, "MissionDescriptionPrm");
@@ -768,10 +1008,7 @@ void MissionDescription::loadIntoMemory() {
     //Load saveprm
     SavePrm savePrm;
     loadMission(savePrm);
-    XPrmOArchive oaSavePrm;
-    oaSavePrm.binary_friendly = true;
-    oaSavePrm << WRAP_NAME(savePrm, "SavePrm");
-    std::swap(saveData, oaSavePrm.buffer());
+    setSaveData(savePrm, binarySavesEnabled());
     
     //Load compressed binary data from file
     if (ff.open(setExtension(savePathContent(), "bin"), XS_IN) && 0 < ff.size()) {
@@ -781,6 +1018,33 @@ void MissionDescription::loadIntoMemory() {
     }
 }
 
+void MissionDescription::setSaveData(const SavePrm& savePrm, bool binary) {
+    if (binary) {
+        BinaryOArchive boa(nullptr, SAVE_BINARY_VERSION);
+        boa.setCompression(true);
+        boa << WRAP_NAME(savePrm, "SavePrm");
+        boa.finalBuffer(saveData);
+    } else {
+        XPrmOArchive oa;
+        oa.binary_friendly = true;
+        oa << WRAP_NAME(savePrm, "SavePrm");
+        std::swap(saveData, oa.buffer());
+    }
+}
+
+void MissionDescription::loadSaveData(SavePrm& savePrm) {
+    BinaryIArchive bia;
+    std::swap(bia.buffer(), saveData);
+    if (bia.reset()) {
+        bia >> WRAP_NAME(savePrm, "SavePrm");
+    } else {
+        XPrmIArchive ia;
+        std::swap(ia.buffer(), bia.buffer());
+        ia.reset();
+        ia >> WRAP_NAME(savePrm, "SavePrm");
+    }
+}
+
 void MissionDescription::restart()
 {
     if(originalSaveName) {
@@ -790,6 +1054,68 @@ void MissionDescription::restart()
 
 //---------------------------------------------------------
 
+//Замер поиска юнитов при разрешении команд: unit_registry_bench=N добивает каждого игрока
+//солдатами до N юнитов и сравнивает terUniverse::findUnit с обходом списка Units
+static void benchmarkUnitRegistry(int unitsPerPlayer) {
+    std::vector<terUnitID> ids;
+    for (terPlayer* player : universe()->Players) {
+        if (player->isWorld()) {
+            continue;
+        }
+        for (int i = player->units().size(); i < unitsPerPlayer; i++) {
+            terUnitBase* unit = player->buildUnit(UNIT_ATTRIBUTE_SOLDIER);
+            if (!unit) {
+                break;
+            }
+            Vect2f position((i*7919) % vMap.H_SIZE, (i*104729) % vMap.V_SIZE);
+            unit->setPose(Se3f(QuatF::ID, To3D(position)), true);
+            unit->Start();
+        }
+        for (terUnitBase* unit : player->units()) {
+            ids.push_back(terUnitID(unit->unitID(), unit->playerID()));
+        }
+    }
+    if (ids.empty()) {
+        return;
+    }
+
+    //Команды приходят вперемешку
+    unsigned int seed = 1;
+    for (int i = ids.size() - 1; i > 0; i--) {
+        seed = seed*1103515245 + 12345;
+        std::swap(ids[i], ids[seed % (i + 1)]);
+    }
+
+    const int rounds = 10;
+    std::vector<terUnitBase*> found(ids.size());
+    uint64_t time_start = clock_us();
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < ids.size(); i++) {
+            found[i] = universe()->findUnit(ids[i]);
+        }
+    }
+
+    uint64_t time_index = clock_us();
+    int mismatches = 0;
+    for (int i = 0; i < ids.size(); i++) {
+        terUnitBase* scanned = nullptr;
+        for (terUnitBase* unit : universe()->findPlayer(ids[i].playerID())->units()) {
+            if (unit->unitID() == ids[i].unitID()) {
+                scanned = unit;
+                break;
+            }
+        }
+        mismatches += scanned != found[i];
+    }
+    uint64_t time_scan = clock_us();
+
+    fprintf(stderr, "Unit registry bench: %" PRIsize " units, index %.1f lookups/ms, list scan %.1f lookups/ms, %d mismatches\n",
+            ids.size(),
+            ids.size()*rounds*1e3/std::max<uint64_t>(time_index - time_start, 1),
+            ids.size()*1e3/std::max<uint64_t>(time_scan - time_index, 1),
+            mismatches);
+}
+
 bool terUniverse::universalLoad(MissionDescription& missionToLoad, SavePrm& data, PROGRESSCALLBACK loadProgressUpdate) {
     MTAuto lock(HTManager::instance()->GetLockLogic());
     
@@ -903,6 +1229,7 @@ bool terUniverse::universalLoad(MissionDescription& missionToLoad, SavePrm& data
     bool campaign = mission.isCampaign();
     loadUnitAttributes(campaign, mission.scriptsData.length() ? &mission.scriptsData : nullptr);
     initUnitAttributes();
+    prefetchUnitModels(mission);
 
     if (loadProgressUpdate) loadProgressUpdate(0.7f);
 
@@ -915,11 +1242,7 @@ bool terUniverse::universalLoad(MissionDescription& missionToLoad, SavePrm& data
 
     data = SavePrm();
     if (mission.saveData.length()) {
-        //Load save data into IA and deserialize
-        XPrmIArchive ia;
-        std::swap(ia.buffer(), mission.saveData);
-        ia.reset();
-        ia >> WRAP_NAME(data, "SavePrm");
+        mission.loadSaveData(data);
     } else {
         mission.loadMission(data);
     }
@@ -1072,6 +1395,38 @@ bool terUniverse::universalLoad(MissionDescription& missionToLoad, SavePrm& data
     loadZeroLayer();
     resolveLinks();
 
+    contactStress = {};
+    if (const char* stress = check_command_line("contact_stress")) {
+        spawnContactStress(atoi(stress));
+    }
+    if (const char* bench = check_command_line("render_instancing_bench")) {
+        instancingBench.units = std::max(atoi(bench), 0);
+        instancingBench.quants = 0;
+    }
+    if (const char* bench = check_command_line("effect_bench")) {
+        effectBench.effects = std::max(atoi(bench), 0);
+        effectBench.quants = 0;
+    }
+    if (const char* bench = check_command_line("unit_registry_bench")) {
+        benchmarkUnitRegistry(atoi(bench));
+    }
+    const char* ground_bench = check_command_line("ground_sample_bench");
+    if (ground_bench && atoi(ground_bench)) {
+        std::vector<RigidBody*> bodies;
+        for (terPlayer* player : Players) {
+            for (terUnitBase* unit : player->units()) {
+                if (RigidBody* body = unit->GetRigidBodyPoint()) {
+                    bodies.push_back(body);
+                }
+            }
+        }
+        RigidBody::benchmarkGroundSampling(bodies);
+    }
+    const char* library_bench = check_command_line("render_library_bench");
+    if (terVisGeneric && library_bench && atoi(library_bench)) {
+        terVisGeneric->BenchmarkLibraries();
+    }
+
     ToolzerController::resetActionOp();
 
     //Flush to avoid crashing when hot-loading
@@ -1138,10 +1493,7 @@ bool terUniverse::universalSave(MissionDescription& mission, bool userSave) cons
 
 	gameShell->fillControlState(data.manualData.controls);
 
-    XPrmOArchive oaSavePrm;
-    oaSavePrm.binary_friendly = true;
-    oaSavePrm << WRAP_NAME(data, "SavePrm");
-    std::swap(oaSavePrm.buffer(), mission.saveData);
+    mission.setSaveData(data, binarySavesEnabled());
     
     if (!mission.savePathKey().empty()) {
         if (!mission.saveMission(data, userSave)) {
@@ -10,6 +10,8 @@
 #include "Region.h"
 #include "Player.h"
 #include "MonkManager.h"
+#include "UnitQueryCache.h"
+#include "InfluenceMap.h"
 
 class terPlayer;
 struct TriggerDispatcher;
@@ -113,6 +115,9 @@ public:
 	PlayerVect Players;
 	
 	terUnitGridType UnitGrid;
+
+	UnitQueryCache unitQuery;
+	InfluenceMap influenceMap;
 	
 	cSpriteManager* pSpriteCongregation;
 	cSpriteManager* pSpriteCongregationProtection;
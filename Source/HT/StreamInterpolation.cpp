@@ -11,6 +11,7 @@
 
 #include "StreamInterpolation.h"
 #include "ht.h"
+#include "Telemetry.h"
 
 static float timer;//0..1 - интерполированное время
 float timer_;
@@ -33,6 +34,19 @@ StreamInterpolator::~StreamInterpolator()
 	MTDONE(lock);
 }
 
+void StreamInterpolator::Lock()
+{
+	if(!frame_telemetry.enabled())
+	{
+		MTENTER(lock);
+		return;
+	}
+
+	uint64_t wait_start=clock_us();
+	MTENTER(lock);
+	frame_telemetry.add(TELEMETRY_LOCK_INTERPOLATOR_WAIT, (clock_us()-wait_start)*1e-3f);
+}
+
 bool StreamInterpolator::set(InterpolateFunction func,cUnknownClass* obj)
 {
     MTL();
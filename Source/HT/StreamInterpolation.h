@@ -50,7 +50,7 @@ public:
 	void ProcessData();
 	void ClearData();
 
-	void Lock(){MTENTER(lock);};
+	void Lock();
 	void Unlock(){MTLEAVE(lock);};
 
 	void SetInAvatar(bool in){in_avatar=in;}
@@ -0,0 +1,259 @@
+#include "StdAfx.h"
+#include "Telemetry.h"
+#include "Runtime.h"
+
+FrameTelemetry frame_telemetry;
+
+///////////////////////////////////////////////////////////
+TelemetryHistogram::TelemetryHistogram()
+{
+	name_="";
+	unit_="";
+	range_max_=1;
+	clear();
+}
+
+void TelemetryHistogram::set(const char* name, const char* unit, float range_max)
+{
+	name_=name;
+	unit_=unit;
+	range_max_=range_max;
+	clear();
+}
+
+void TelemetryHistogram::clear()
+{
+	for(int i=0;i<BINS;i++)
+		bins_[i]=0;
+	overflow_=0;
+	count_=0;
+	sum_=0;
+	min_=0;
+	max_=0;
+	last_=0;
+}
+
+void TelemetryHistogram::add(float value)
+{
+	if(value<0)
+		value=0;
+
+	if(!count_ || value<min_)
+		min_=value;
+	if(!count_ || value>max_)
+		max_=value;
+	count_++;
+	sum_+=value;
+	last_=value;
+
+	int i=int(value*BINS/range_max_);
+	if(i<BINS)
+		bins_[i]++;
+	else
+		overflow_++;
+}
+
+float TelemetryHistogram::percentile(float p) const
+{
+	if(!count_)
+		return 0;
+
+	int need=int(ceilf(p*count_));
+	if(need<1)
+		need=1;
+
+	int sum=0;
+	for(int i=0;i<BINS;i++)
+	{
+		sum+=bins_[i];
+		if(sum>=need)
+			return std::min((i+1)*binWidth(),max_);
+	}
+
+	return max_;
+}
+
+///////////////////////////////////////////////////////////
+FrameTelemetry::FrameTelemetry()
+{
+	enabled_=false;
+	show_=false;
+	quants_since_frame_=0;
+
+	histograms_[TELEMETRY_LOGIC_QUANT].set("logic_quant","ms",200);
+	histograms_[TELEMETRY_GRAPH_FRAME].set("graph_frame","ms",100);
+	histograms_[TELEMETRY_INTERPOLATION].set("interpolation_factor","",1.0001f);
+	histograms_[TELEMETRY_QUANTS_PER_FRAME].set("quants_per_frame","quants",16);
+	histograms_[TELEMETRY_LOCK_LOGIC_WAIT].set("lock_logic_wait","ms",50);
+	histograms_[TELEMETRY_LOCK_INTERPOLATOR_WAIT].set("lock_interpolator_wait","ms",50);
+	histograms_[TELEMETRY_CONFIRM_LAG].set("confirm_quant_lag","quants",64);
+	histograms_[TELEMETRY_SOUND_UPDATE].set("sound_update","ms",10);
+	histograms_[TELEMETRY_SOUND_VOICES].set("sound_voices","voices",64);
+	histograms_[TELEMETRY_SOUND_VIRTUAL].set("sound_virtual_voices","voices",512);
+	histograms_[TELEMETRY_SOUND_MIXING].set("sound_mixing_channels","channels",64);
+	histograms_[TELEMETRY_SLAB_ALLOCS].set("slab_allocs","allocs",1024);
+	histograms_[TELEMETRY_SLAB_FREES].set("slab_frees","frees",1024);
+	histograms_[TELEMETRY_SLAB_USED].set("slab_used","chunks",65536);
+}
+
+void FrameTelemetry::init()
+{
+	const char* prefix=check_command_line("telemetry");
+	enabled_=prefix!=nullptr && strcmp(prefix,"0")!=0;
+	if(!enabled_)
+		return;
+
+	dump_prefix_=prefix;
+	if(dump_prefix_.empty() || dump_prefix_=="1")
+		dump_prefix_="telemetry";
+
+	const char* show=check_command_line("telemetry_show");
+	show_=show && atoi(show);
+}
+
+void FrameTelemetry::add(TelemetryChannel channel, float value)
+{
+	if(!enabled_)
+		return;
+
+	MTAuto lock(&lock_telemetry);
+	histograms_[channel].add(value);
+}
+
+void FrameTelemetry::logicQuantDone()
+{
+	if(!enabled_)
+		return;
+
+	MTAuto lock(&lock_telemetry);
+	quants_since_frame_++;
+}
+
+void FrameTelemetry::graphFrameDone(float frame_ms, float interpolation_factor)
+{
+	if(!enabled_)
+		return;
+
+	MTAuto lock(&lock_telemetry);
+	histograms_[TELEMETRY_GRAPH_FRAME].add(frame_ms);
+	histograms_[TELEMETRY_INTERPOLATION].add(interpolation_factor);
+	histograms_[TELEMETRY_QUANTS_PER_FRAME].add(quants_since_frame_);
+	quants_since_frame_=0;
+}
+
+void FrameTelemetry::Show()
+{
+	if(!enabled_ || !show_)
+		return;
+
+	MTAuto lock(&lock_telemetry);
+	int x= xm::round(terScreenSizeX * 0.05f);
+	int y= xm::round(terScreenSizeY * 0.1f);
+
+	Vect2f bmin,bmax;
+	terRenderDevice->OutTextRect(0,0,"A",-1,bmin,bmax);
+	int height= xm::round(bmax.y - bmin.y);
+	char str[256];
+
+	for(int i=0;i<TELEMETRY_CHANNEL_MAX;i++)
+	{
+		const TelemetryHistogram& h=histograms_[i];
+		sprintf(str,"%s: last %2.2f avg %2.2f p95 %2.2f p99 %2.2f max %2.2f %s",
+			h.name(),h.last(),h.average(),h.percentile(0.95f),h.percentile(0.99f),h.maxValue(),h.unit());
+		terRenderDevice->OutText(x,y,str,sColor4f(1,1,1,1));
+		y+=height;
+	}
+}
+
+void FrameTelemetry::Dump()
+{
+	if(!enabled_)
+		return;
+
+	MTAuto lock(&lock_telemetry);
+
+	XBuffer csv(64*1024, true);
+	DumpCSV(csv);
+	XStream fcsv(dump_prefix_ + ".csv", XS_OUT);
+	fcsv.write(csv.address(), csv.tell());
+	fcsv.close();
+
+	XBuffer json(64*1024, true);
+	DumpJSON(json);
+	XStream fjson(dump_prefix_ + ".json", XS_OUT);
+	fjson.write(json.address(), json.tell());
+	fjson.close();
+
+	//Дальше данные не собираются, объект может пережить HTManager
+	enabled_=false;
+}
+
+void FrameTelemetry::DumpCSV(XBuffer& buf)
+{
+	buf.SetDigits(4);
+	buf < "channel,unit,bin_min,bin_max,count\n";
+	for(int i=0;i<TELEMETRY_CHANNEL_MAX;i++)
+	{
+		const TelemetryHistogram& h=histograms_[i];
+		for(int b=0;b<TelemetryHistogram::BINS;b++)
+		{
+			if(!h.bin(b))
+				continue;
+			buf < h.name() < "," < h.unit() < ",";
+			buf <= b*h.binWidth() < "," <= (b+1)*h.binWidth() < "," <= h.bin(b) < "\n";
+		}
+		if(h.overflow())
+		{
+			buf < h.name() < "," < h.unit() < ",";
+			buf <= TelemetryHistogram::BINS*h.binWidth() < ",inf," <= h.overflow() < "\n";
+		}
+	}
+}
+
+void FrameTelemetry::DumpJSON(XBuffer& buf)
+{
+	buf.SetDigits(4);
+	buf < "{\n";
+	for(int i=0;i<TELEMETRY_CHANNEL_MAX;i++)
+	{
+		const TelemetryHistogram& h=histograms_[i];
+		buf < "  \"" < h.name() < "\": {";
+		buf < "\"unit\": \"" < h.unit() < "\"";
+		buf < ", \"count\": " <= h.count();
+		buf < ", \"avg\": " <= h.average();
+		buf < ", \"min\": " <= h.minValue();
+		buf < ", \"max\": " <= h.maxValue();
+		buf < ", \"p50\": " <= h.percentile(0.5f);
+		buf < ", \"p95\": " <= h.percentile(0.95f);
+		buf < ", \"p99\": " <= h.percentile(0.99f);
+		buf < ", \"bin_width\": " <= h.binWidth();
+		buf < ", \"overflow\": " <= h.overflow();
+		buf < ", \"bins\": [";
+		for(int b=0;b<TelemetryHistogram::BINS;b++)
+		{
+			if(b)
+				buf < ",";
+			buf <= h.bin(b);
+		}
+		buf < "]}";
+		if(i+1<TELEMETRY_CHANNEL_MAX)
+			buf < ",";
+		buf < "\n";
+	}
+	buf < "}\n";
+}
+
+///////////////////////////////////////////////////////////
+TelemetryAutoLock::TelemetryAutoLock(MTSection* s_, TelemetryChannel channel)
+: s(s_)
+{
+	if(!frame_telemetry.enabled())
+	{
+		s->Lock();
+		return;
+	}
+
+	uint64_t wait_start=clock_us();
+	s->Lock();
+	frame_telemetry.add(channel,(clock_us()-wait_start)*1e-3f);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+/*
+Телеметрия кадров и квантов.
+Накапливает распределения времени логического кванта, графического кадра,
+ожидания блокировок и сетевого отставания в гистограммы фиксированного размера,
+чтобы можно было понять откуда берутся рывки: логика, графика или блокировки.
+
+Включается из командной строки:
+	telemetry=<prefix>  - сбор данных, при выходе пишутся <prefix>.csv и <prefix>.json
+	telemetry_show=1    - вывод статистики на экран
+*/
+
+enum TelemetryChannel
+{
+	TELEMETRY_LOGIC_QUANT,			//ms, время gameShell->LogicQuant
+	TELEMETRY_GRAPH_FRAME,			//ms, время HTManager::GraphQuant
+	TELEMETRY_INTERPOLATION,		//0..1, interpolation_factor на кадре
+	TELEMETRY_QUANTS_PER_FRAME,		//логических квантов между двумя кадрами
+	TELEMETRY_LOCK_LOGIC_WAIT,		//ms, ожидание lock_logic
+	TELEMETRY_LOCK_INTERPOLATOR_WAIT,//ms, ожидание блокировки stream_interpolator
+	TELEMETRY_CONFIRM_LAG,			//quants, currentQuant - confirmQuant
+	TELEMETRY_SOUND_UPDATE,			//ms, время snd_listener.Update
+	TELEMETRY_SOUND_VOICES,			//3D звуков в каналах микшера
+	TELEMETRY_SOUND_VIRTUAL,		//3D звуков, играющих без канала
+	TELEMETRY_SOUND_MIXING,			//всего занятых каналов микшера
+	TELEMETRY_SLAB_ALLOCS,			//выделений SlabAllocator за логический квант
+	TELEMETRY_SLAB_FREES,			//освобождений SlabAllocator за логический квант
+	TELEMETRY_SLAB_USED,			//кусков SlabAllocator, выданных и не освобожденных
+
+	TELEMETRY_CHANNEL_MAX
+};
+
+class TelemetryHistogram
+{
+public:
+	enum { BINS = 64 };
+
+	TelemetryHistogram();
+
+	void set(const char* name, const char* unit, float range_max);
+	void clear();
+	void add(float value);
+
+	const char* name() const { return name_; }
+	const char* unit() const { return unit_; }
+	int count() const { return count_; }
+	float average() const { return count_ ? float(sum_/count_) : 0; }
+	float minValue() const { return count_ ? min_ : 0; }
+	float maxValue() const { return count_ ? max_ : 0; }
+	float last() const { return last_; }
+	float binWidth() const { return range_max_/BINS; }
+	int bin(int i) const { return bins_[i]; }
+	int overflow() const { return overflow_; }
+
+	//Верхняя граница бина, в который попадает процентиль p (0..1)
+	float percentile(float p) const;
+
+protected:
+	const char* name_;
+	const char* unit_;
+	float range_max_;
+
+	int bins_[BINS];
+	int overflow_;
+	int count_;
+	double sum_;
+	float min_, max_;
+	float last_;
+};
+
+class FrameTelemetry
+{
+public:
+	FrameTelemetry();
+
+	void init();
+	bool enabled() const { return enabled_; }
+
+	void add(TelemetryChannel channel, float value);
+
+	//Для корреляции квантов и кадров
+	void logicQuantDone();
+	void graphFrameDone(float frame_ms, float interpolation_factor);
+
+	void Show();
+	void Dump();
+
+protected:
+	MTSection lock_telemetry;
+	bool enabled_;
+	bool show_;
+	std::string dump_prefix_;
+	int quants_since_frame_;
+	TelemetryHistogram histograms_[TELEMETRY_CHANNEL_MAX];
+
+	void DumpCSV(XBuffer& buf);
+	void DumpJSON(XBuffer& buf);
+};
+
+extern FrameTelemetry frame_telemetry;
+
+//Измеряет время ожидания блокировки и пишет его в канал телеметрии
+class TelemetryAutoLock
+{
+	MTSection* s;
+public:
+	TelemetryAutoLock(MTSection* s_, TelemetryChannel channel);
+	~TelemetryAutoLock() { s->Unlock(); }
+};
@@ -5,6 +5,8 @@
 #include "GenericControls.h"
 #include "Config.h"
 #include "LagStatistic.h"
+#include "Telemetry.h"
+#include "xjobs.h"
 #include <cstdlib>
 #include <thread>
 #include <SDL_thread.h>
@@ -64,7 +66,9 @@ HTManager::HTManager()
 HTManager::~HTManager()
 {
     MT_SET_TYPE(MT_LOGIC_THREAD | MT_GRAPH_THREAD);
+	frame_telemetry.Dump();
 	done();
+	parallel_finit();
 	self=nullptr;
 	delete lag_stat;
 }
@@ -168,7 +172,7 @@ void HTManager::logic_thread()
 				break;
 
 			{
-				MTAuto lock(&lock_logic);
+				TelemetryAutoLock lock(&lock_logic, TELEMETRY_LOCK_LOGIC_WAIT);
 				gameShell->NetQuant();
 			}
 
@@ -313,9 +317,9 @@ void HTManager::ClearDeleteUnit(bool delete_all)
 			continue;
 		}
 
-		std::list<terUnitBase*>& lst=itd->unit;
+		std::vector<terUnitBase*>& lst=itd->unit;
 
-		std::list<terUnitBase*>::iterator it;
+		std::vector<terUnitBase*>::iterator it;
 		FOR_EACH(lst,it)
 		{
 			terUnitBase* p=*it;
@@ -346,6 +350,7 @@ void HTManager::Show()
         lag_stat->Show();
     }
 #endif //_FINAL
+	frame_telemetry.Show();
 }
 
 
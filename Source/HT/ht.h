@@ -69,7 +69,7 @@ protected:
 
 	struct DELETE_DATA
 	{
-		std::list<terUnitBase*> unit;
+		std::vector<terUnitBase*> unit;
 		int quant;
 	};
 	std::list<DELETE_DATA> DeleteList;
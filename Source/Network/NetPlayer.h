@@ -101,7 +101,11 @@ public:
 
 	bool loadMission(SavePrm& savePrm) const;
     void loadIntoMemory();
-	bool saveMission(const SavePrm& savePrm, bool userSave) const; 
+	//text - всегда текстовый формат (дампы рассинхронизации читают глазами и сравнивают diff'ом)
+	bool saveMission(const SavePrm& savePrm, bool userSave, bool text = false) const; 
+	//Сериализация SavePrm в saveData и обратно, формат при загрузке определяется по заголовку
+	void setSaveData(const SavePrm& savePrm, bool binary);
+	void loadSaveData(SavePrm& savePrm);
 	void restart();
 
 	void setSaveName(const char* name);
@@ -956,15 +956,12 @@ end_while_01:;
                     ffb.close();
                 }
 
-                //Load save data into IA and deserialize
+                //Deserialize save data
                 SavePrm savePrm;
                 if (mission.saveData.length()) {
-                    XPrmIArchive ia;
-                    std::swap(ia.buffer(), mission.saveData);
-                    ia.reset();
-                    ia >> WRAP_NAME(savePrm, "SavePrm");
+                    mission.loadSaveData(savePrm);
                 }
-                client->desync_missionDescription->saveMission(savePrm, true);
+                client->desync_missionDescription->saveMission(savePrm, true, true);
             }
 
             //Clear host buffers
@@ -2,6 +2,7 @@
 #include "Runtime.h"
 #include "TypeLibrary.h"
 #include "RigidBody.h"
+#include "xjobs.h"
 
 MultiBodyDispatcher::MultiBodyDispatcher()
 {
@@ -48,9 +49,11 @@ bool MultiBodyDispatcher::test(RigidBody& b1, RigidBody& b2, const MatXf& Xr1r2,
 
 	if(penetration > 0){
 		if(addContact){
-			contacts.push_back(Contact());
-			if(!contacts.back().set(penetration, cp1, cp2, &b1, &b2))
-				contacts.pop_back();
+			Contact& contact = contacts.push();
+			if(contact.set(penetration, cp1, cp2, &b1, &b2))
+				contact.index = contacts.size() - 1;
+			else
+				contacts.pop();
 		}
 
 		//Vect3f p1, p2;
@@ -64,25 +67,121 @@ bool MultiBodyDispatcher::test(RigidBody& b1, RigidBody& b2, const MatXf& Xr1r2,
 	return false;
 }
 
-void MultiBodyDispatcher::resolve()
+int MultiBodyDispatcher::islandRoot(int i)
 {
-	if(contacts.empty())
-		return;
+	while(island_parent_[i] != i)
+		i = island_parent_[i] = island_parent_[island_parent_[i]];
+	return i;
+}
+
+void MultiBodyDispatcher::buildIslands()
+{
+	int size = contacts.size();
+	island_parent_.resize(size);
+	for(int i = 0; i < size; i++)
+		island_parent_[i] = i;
+
+	// Объединяем контакты каждого подвижного тела. Неподвижные тела
+	// не получают импульсов, поэтому острова через них не связываются.
+	// Корень - контакт с наименьшим номером.
+	for(int i = 0; i < size; i++){
+		Contact& c = contacts[i];
+		for(int k = 0; k < 2; k++){
+			if(k ? c.body2_unmovable : c.body1_unmovable)
+				continue;
+			RigidBody* body = k ? c.body2 : c.body1;
+			int r1 = islandRoot(i);
+			int r2 = islandRoot(body->contacts.front()->index);
+			if(r1 < r2)
+				island_parent_[r2] = r1;
+			else
+				island_parent_[r1] = r2;
+			}
+		}
 
-	for(int i = 0; i < contacts.size()*collision_resolve_iterations_per_contact; i++){
+	// Острова нумеруются в порядке первого контакта, корень всегда раньше остальных
+	island_start_.clear();
+	island_contacts_.resize(size);
+	for(int i = 0; i < size; i++){
+		int root = islandRoot(i);
+		if(root == i){
+			island_contacts_[i] = island_start_.size();
+			island_start_.push_back(0);
+			}
+		else
+			island_contacts_[i] = island_contacts_[root];
+		island_start_[island_contacts_[i]]++;
+		}
+
+	int islands = island_start_.size();
+	int sum = 0;
+	for(int i = 0; i < islands; i++){
+		int count = island_start_[i];
+		island_start_[i] = sum;
+		sum += count;
+		}
+	island_start_.push_back(sum);
+
+	// Раскладка по островам с сохранением порядка контактов внутри острова
+	for(int i = 0; i < size; i++)
+		island_parent_[i] = island_contacts_[i];
+	for(int i = 0; i < size; i++)
+		island_contacts_[island_start_[island_parent_[i]]++] = i;
+	for(int i = islands; i > 0; i--)
+		island_start_[i] = island_start_[i - 1];
+	island_start_[0] = 0;
+}
+
+void MultiBodyDispatcher::resolveIsland(int island)
+{
+	int begin = island_start_[island];
+	int end = island_start_[island + 1];
+
+	// Пока лимит итераций не исчерпан, последовательность разрешений внутри
+	// острова та же, что при общем переборе: соседние острова не меняют
+	// скорости его тел. Лимит теперь свой у каждого острова -
+	// (end - begin)*iterations вместо общего contacts.size()*iterations, поэтому
+	// в насыщенных кучах, где лимит исчерпывается, результат отличается
+	// от прежнего: большой остров больше не может занять итерации соседей.
+	for(int i = 0; i < (end - begin)*collision_resolve_iterations_per_contact; i++){
 		float u_n, u_n_min = FLT_INF;
 		Contact* c_min = nullptr;
-		ContactList::iterator ci;
-		FOR_EACH(contacts, ci)
-			if(u_n_min > (u_n = ci->normal_velocity())){
+		for(int k = begin; k < end; k++){
+			Contact& c = contacts[island_contacts_[k]];
+			if(u_n_min > (u_n = c.normal_velocity())){
 				u_n_min = u_n;
-				c_min = &*ci;
+				c_min = &c;
 				}
+			}
 		if(u_n_min > collision_resolve_velocity_tolerance)
 			break;
 
 		if (c_min) c_min->resolve();
     }
+}
+
+void MultiBodyDispatcher::resolve()
+{
+	if(contacts.empty())
+		return;
+
+	start_timer_auto(resolve, STATISTICS_GROUP_PHYSICS);
+
+	buildIslands();
+
+	int islands = island_start_.size() - 1;
+	statistics_add(contacts, STATISTICS_GROUP_NUMERIC, contacts.size());
+	statistics_add(islands, STATISTICS_GROUP_NUMERIC, islands);
+
+	// Острова раздаются непрерывными порциями, результат не зависит
+	// от количества потоков и порядка их выполнения
+	const int PARALLEL_CONTACTS_MIN = 256;
+	int chunks = contacts.size() < PARALLEL_CONTACTS_MIN ? 1 : min(islands, parallel_threads()*4);
+	parallel_for(chunks, [this, islands, chunks](int chunk){
+		int end = islands*(chunk + 1)/chunks;
+		for(int island = islands*chunk/chunks; island < end; island++)
+			resolveIsland(island);
+	});
 
 	//xassert("Unable to resolve collision" && i < contacts.size()*collision_resolve_iterations_per_contact);
 	prepare();
@@ -93,12 +192,12 @@ void MultiBodyDispatcher::resolveSmart()
 	if(contacts.empty())
 		return;
 
-	ContactList::iterator ci;
-	FOR_EACH(contacts, ci)
-		ci->resolveSmart();
+	int size = contacts.size();
+	for(int i = 0; i < size; i++)
+		contacts[i].resolveSmart();
 
-	FOR_EACH(contacts, ci)
-		ci->finalizeResolve();
+	for(int i = 0; i < size; i++)
+		contacts[i].finalizeResolve();
 	
 	//xassert("Unable to resolve collision" && i < contacts.size()*collision_resolve_iterations_per_contact);
 	prepare();
@@ -110,12 +209,28 @@ void MultiBodyDispatcher::prepare()
 //	if(closest_features_ht.size() > closestFeaturesHTsizeMax)
 //		closest_features_ht.clear();
 
-	ContactList::iterator ci;
-	FOR_EACH(contacts, ci)
-		ci->clear();
+	int size = contacts.size();
+	for(int i = 0; i < size; i++)
+		contacts[i].clear();
 
 	contacts.clear();
 }
+
+//////////////////////////////////////////////////////////////
+//	ContactPool
+//////////////////////////////////////////////////////////////
+ContactPool::~ContactPool()
+{
+	for(int i = 0; i < blocks_.size(); i++)
+		delete[] blocks_[i];
+}
+
+Contact& ContactPool::push()
+{
+	if(size_ == blocks_.size() << BLOCK_SHIFT)
+		blocks_.push_back(new Contact[BLOCK_SIZE]);
+	return (*this)[size_++];
+}
   
 //////////////////////////////////////////////////////////////
 //	Contact
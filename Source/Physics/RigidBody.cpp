@@ -193,11 +193,62 @@ void RigidBody::EulerEvolve(float dt)
 	setOrientation(quat);
 }
 
-void RigidBody::ground_analysis(float dt)
+//------------------------------------
+void GroundSampler::sample(const GroundSampleRequest& r, GroundSampleResult& result)
 {
-	start_timer_auto(ground_analysis, STATISTICS_GROUP_PHYSICS);
+	const unsigned char* buf = vMap.GVBuf;
+	int z[CHUNK];
+	int Sz = 0, Sxz = 0, Syz = 0, dz_max = 0, z_max = 0, z_min = 100000, chaos = 0;
+	int nx = 2*r.Dx + 1;
+	int p0x = r.p0x, p0y = r.p0y, p0z = r.p0z;
+	for(int y = -r.Dy; y <= r.Dy; y++){
+		int row_z = 0, row_xz = 0, row_max = 0, row_min = 100000, row_dz = 0, row_chaos = 0;
+		int px = p0x, py = p0y;
+		for(int i0 = 0; i0 < nx; i0 += CHUNK){
+			int n = nx - i0 < CHUNK ? nx - i0 : CHUNK;
+			for(int i = 0; i < n; i++){
+				z[i] = buf[vMap.offsetGBufC(px >> (SHIFT + kmGrid), py >> (SHIFT + kmGrid))];
+				px += r.dpx_x;
+				py += r.dpx_y;
+			}
+			// Внутренний цикл без ветвлений и зависимостей между итерациями
+			for(int i = 0; i < n; i++){
+				int zi = z[i];
+				int zp = (p0z + (i0 + i)*r.dpx_z) >> SHIFT;
+				int dz = zi - zp;
+				row_chaos += zi == 0;
+				row_max = zi > row_max ? zi : row_max;
+				row_min = zi < row_min ? zi : row_min;
+				row_dz = dz > row_dz ? dz : row_dz;
+				row_z += zi;
+				row_xz += (i0 + i - r.Dx)*zi;
+			}
+		}
+		Sz += row_z;
+		Sxz += row_xz;
+		Syz += y*row_z;
+		chaos += row_chaos;
+		z_max = row_max > z_max ? row_max : z_max;
+		z_min = row_min < z_min ? row_min : z_min;
+		dz_max = row_dz > dz_max ? row_dz : dz_max;
+
+		p0x += r.dpy_x;
+		p0y += r.dpy_y;
+		p0z += r.dpy_z;
+	}
+
+	result.Sz = Sz;
+	result.Sxz = Sxz;
+	result.Syz = Syz;
+	result.dz_max = dz_max;
+	result.z_max = z_max;
+	result.z_min = z_min;
+	result.chaos_colliding = chaos;
+}
 
-	int Sz = 0, Sxz = 0, Syz = 0, dz_max = 0, z_max = 0, z_min = 100000;
+//------------------------------------
+void RigidBody::prepareGroundSample(GroundSampleRequest& r) const
+{
 	float kx = (box_max.x - box_min.x)/(2*Dx);
 	float ky = (box_max.y - box_min.y)/(2*Dy);
 	Vect3f dpx, dpy;
@@ -206,57 +257,68 @@ void RigidBody::ground_analysis(float dt)
   	matrix().xformPoint(p0);
 	rotation().xform(Vect3f(kx, 0, 0), dpx);
 	rotation().xform(Vect3f(0, ky, 0), dpy);
-	int obstacle_x = 0, obstacle_y = 0, obstacle_counter = 0;
-	int chaosCollidingCounter = 0;
 
-	const int shl = 12, mul = 1 << shl;
-	int p0x= xm::round(p0.x * mul),
-		p0y= xm::round(p0.y * mul),
-		p0z= xm::round(p0.z * mul);
+	const int mul = 1 << GroundSampler::SHIFT;
+	r.p0x = xm::round(p0.x * mul);
+	r.p0y = xm::round(p0.y * mul);
+	r.p0z = xm::round(p0.z * mul);
 
-	int dpx_x= xm::round(dpx.x * mul),
-		dpx_y= xm::round(dpx.y * mul),
-		dpx_z= xm::round(dpx.z * mul);
+	r.dpx_x = xm::round(dpx.x * mul);
+	r.dpx_y = xm::round(dpx.y * mul);
+	r.dpx_z = xm::round(dpx.z * mul);
 
-	int dpy_x= xm::round(dpy.x * mul),
-		dpy_y= xm::round(dpy.y * mul),
-		dpy_z= xm::round(dpy.z * mul);
+	r.dpy_x = xm::round(dpy.x * mul);
+	r.dpy_y = xm::round(dpy.y * mul);
+	r.dpy_z = xm::round(dpy.z * mul);
 
-	for(int y = -Dy; y <= Dy; y++)
-	{
-		int px=p0x, py=p0y, pz=p0z;
-		for(int x = -Dx; x <= Dx; x++)
-		{
-			int zp = pz >> shl;
-			int z = vMap.GVBuf[vMap.offsetGBufC(px >> (shl+kmGrid),	py >> (shl+kmGrid))];
-			
-			if(z == 0){
-				//obstacle_x += x;
-				//obstacle_y += y;
-				//obstacle_counter++;
-				chaosCollidingCounter++;
-				}
-			if(z_max < z)
-				z_max = z;
-			if(z_min > z)
-				z_min = z;
-
-			int dz = z - zp;
-			if(dz_max < dz)
-				dz_max = dz;
-
-			Sz += z;
-			Sxz += x*z;
-			Syz += y*z;
-
-			px += dpx_x;
-			py += dpx_y;
-			pz += dpx_z;
+	r.Dx = Dx;
+	r.Dy = Dy;
+}
+
+void RigidBody::ground_analysis(float dt)
+{
+	start_timer_auto(ground_analysis, STATISTICS_GROUP_PHYSICS);
+
+	GroundSampleRequest request;
+	prepareGroundSample(request);
+	GroundSampleResult sample;
+	GroundSampler::sample(request, sample);
+	ground_analysis(dt, sample);
+}
+
+void RigidBody::benchmarkGroundSampling(const std::vector<RigidBody*>& bodies)
+{
+	std::vector<GroundSampleRequest> requests;
+	for(int i = 0; i < bodies.size(); i++)
+		if(bodies[i]->prm().unit_type == RigidBodyPrm::UNIT){
+			requests.push_back(GroundSampleRequest());
+			bodies[i]->prepareGroundSample(requests.back());
 		}
-		p0x += dpy_x;
-		p0y += dpy_y;
-		p0z += dpy_z;
-	}
+	if(requests.empty())
+		return;
+
+	const int rounds = 100;
+	GroundSampleResult result;
+	int checksum = 0;
+	uint64_t time_start = clock_us();
+	for(int round = 0; round < rounds; round++)
+		for(int i = 0; i < requests.size(); i++){
+			GroundSampler::sample(requests[i], result);
+			checksum += result.Sz;
+		}
+	uint64_t time = std::max<uint64_t>(clock_us() - time_start, 1);
+
+	fprintf(stderr, "Ground sampling bench: %i bodies, %.1f bodies/ms (checksum %i)\n",
+		(int)requests.size(), requests.size()*rounds*1e3/time, checksum);
+}
+
+void RigidBody::ground_analysis(float dt, const GroundSampleResult& sample)
+{
+	int Sz = sample.Sz, Sxz = sample.Sxz, Syz = sample.Syz, dz_max = sample.dz_max, z_max = sample.z_max, z_min = sample.z_min;
+	float kx = (box_max.x - box_min.x)/(2*Dx);
+	float ky = (box_max.y - box_min.y)/(2*Dy);
+	int obstacle_x = 0, obstacle_y = 0, obstacle_counter = 0;
+	int chaosCollidingCounter = sample.chaos_colliding;
 
 	Vect3f z_axis;
 	float dZ = -box_min.z + deltaZ_ - position().z;
@@ -34,12 +34,69 @@ private:
 	char body1_unmovable;
 	char body2_unmovable;
 
+	int index; // номер в ContactPool
+
 	friend class RigidBody;
 	friend class MultiBodyDispatcher;
 };
-typedef std::list<Contact> ContactList;
 typedef std::vector<Contact*> ContactPtrList;
 
+//------------------------------------
+// Пул контактов: блоки фиксированного размера, память переиспользуется между квантами.
+// Адреса контактов не меняются до clear(), на них ссылаются RigidBody::contacts.
+class ContactPool
+{
+public:
+	ContactPool() : size_(0) {}
+	~ContactPool();
+
+	Contact& push();
+	void pop() { size_--; }
+	void clear() { size_ = 0; }
+
+	int size() const { return size_; }
+	bool empty() const { return !size_; }
+	Contact& operator[](int i) { return blocks_[i >> BLOCK_SHIFT][i & (BLOCK_SIZE - 1)]; }
+
+private:
+	enum { BLOCK_SHIFT = 8, BLOCK_SIZE = 1 << BLOCK_SHIFT };
+
+	std::vector<Contact*> blocks_;
+	int size_;
+
+	ContactPool(const ContactPool&);
+	void operator=(const ContactPool&);
+};
+
+//------------------------------------
+// Выборка рельефа под телом в фиксированной точке (12 бит дробной части).
+// Высоты строки сетки (2Dx+1)x(2Dy+1) собираются кусками по CHUNK в буфер на стеке,
+// затем отдельным проходом без ветвлений считаются суммы и экстремумы.
+// Общих данных нет, можно звать из разных потоков.
+// Результат совпадает побитно с поэлементным обходом.
+struct GroundSampleRequest
+{
+	int p0x, p0y, p0z;
+	int dpx_x, dpx_y, dpx_z;
+	int dpy_x, dpy_y, dpy_z;
+	int Dx, Dy;
+};
+
+struct GroundSampleResult
+{
+	int Sz, Sxz, Syz;
+	int dz_max, z_max, z_min;
+	int chaos_colliding;
+};
+
+class GroundSampler
+{
+public:
+	enum { SHIFT = 12, CHUNK = 64 };
+
+	static void sample(const GroundSampleRequest& request, GroundSampleResult& result);
+};
+
 
 //------------------------------------
 
@@ -134,6 +191,9 @@ public:
 	static void suggestMissileTurnAngels(const RigidBody& firingObject, const Vect3f& firingPosition, const Vect3f& target, float& psi, float& theta);
 	static int testMissileShot(const RigidBodyPrm& prm, const Vect3f box_min, const Vect3f box_max, const RigidBody& firing_object, const Vect3f& position, const Vect3f& direction, RigidBody* target);
 
+	// Замер выборки рельефа под наземными телами, печатает тел в мс (ground_sample_bench=1)
+	static void benchmarkGroundSampling(const std::vector<RigidBody*>& bodies);
+
 	// Rocket, Debris
 	void startRocket(RigidBody& owner);
 	void startDebris(const Vect3f& position, const Vect3f& velocity);
@@ -271,6 +331,8 @@ private:
 	void applyDiggingForce();
 	bool controlled() const { return !way_points.empty(); }
 	void ground_analysis(float dt);
+	void ground_analysis(float dt, const GroundSampleResult& sample);
+	void prepareGroundSample(GroundSampleRequest& request) const;
 	void rocket_analysis(float dt);
 	void obstacle_analysis();
 	void add_obstacle_point(const Vect3f& point);
@@ -305,8 +367,22 @@ public:
 	void resolve(); // call before evolve
 	void resolveSmart(); // call before evolve
 
+	int contactsCount() const { return contacts.size(); }
+	// Острова последнего resolve
+	int islandsCount() const { return island_start_.empty() ? 0 : island_start_.size() - 1; }
+
 private:
-	ContactList contacts;
+	ContactPool contacts;
+
+	// Острова - группы контактов, связанных через подвижные тела.
+	// Острова не влияют друг на друга и разрешаются независимо.
+	std::vector<int> island_parent_;
+	std::vector<int> island_contacts_; // номера контактов по островам, внутри острова - в порядке добавления
+	std::vector<int> island_start_; // начало острова в island_contacts_, последний элемент - общее количество
+
+	int islandRoot(int i);
+	void buildIslands();
+	void resolveIsland(int island);
 	
 	friend RigidBody;
 };
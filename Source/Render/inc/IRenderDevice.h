@@ -185,6 +185,8 @@ public:
     virtual int Done();
     virtual int BeginScene();
     virtual int EndScene();
+    //Prints draw calls and submit time over frames with mesh instancing on and then off
+    virtual void StartInstancingBenchmark(int frames) {}
 
     virtual bool IsFullScreen() { return (RenderMode&RENDERDEVICE_MODE_WINDOW) == 0; }
     
@@ -314,6 +316,8 @@ public:
     virtual void EndDrawMesh() = 0;
     virtual void SetSimplyMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data) = 0;
     virtual void DrawNoMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data) = 0;
+    ///Draws meshes which share bank and material set by SetSimplyMaterialMesh, by default one by one
+    virtual void DrawNoMaterialMeshInstances(cObjMesh** meshes, size_t count, sDataRenderMaterial* data);
 
     virtual void BeginDrawShadow(bool shadow_map) = 0;
     virtual void EndDrawShadow() = 0;
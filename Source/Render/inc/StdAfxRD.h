@@ -88,6 +88,10 @@ extern DebugType<int>	Option_EnablePointLight;
 extern DebugType<int>	Option_ShadowMapSelf4x4;
 extern DebugType<float>	Option_ParticleRate;
 extern DebugType<int>	Option_ShadowHint;
+extern DebugType<int>	Option_ParallelPreDraw;
+extern DebugType<int>	Option_SceneGridCulling;
+extern DebugType<int>	Option_ParallelEffects;
+extern DebugType<int>	Option_AssetStreaming;
 
 extern bool Option_ShowType[SHOW_MAX];
 
@@ -102,3 +106,4 @@ extern class cVisGeneric		*gb_VisGeneric;
 #endif
 
 int ResourceFileRead(const char *fname,char *&buf,int &size);
+bool ResourceIsZIP();
@@ -1,4 +1,5 @@
 #include <unordered_set>
+#include <new>
 #include "StdAfxRD.h"
 #include "xmath.h"
 #include "Umath.h"
@@ -12,6 +13,7 @@
 #include "DrawBuffer.h"
 #include "SokolShaders.h"
 #include "RenderTracker.h"
+#include "DebugUtil.h"
 #include <SDL_hints.h>
 
 #ifdef PERIMETER_SOKOL_GL
@@ -256,6 +258,13 @@ int cSokolRender::Init(int xScr, int yScr, int mode, SDL_Window* wnd, int Refres
     const char* render_driver = SDL_GetHint(SDL_HINT_RENDER_DRIVER);
     printf("SDL / Sokol render driver: %s\n", render_driver);
     printf("Sokol render backend: %s\n", sokol_backend);
+
+    int merge_commands = 1;
+    check_command_line_parameter("render_merge_commands", merge_commands);
+    mergeCommands = merge_commands != 0;
+    int mesh_instancing = 1;
+    check_command_line_parameter("render_mesh_instancing", mesh_instancing);
+    meshInstancing = mesh_instancing != 0;
     
     //Call sokol gfx setup
     sg_setup(&desc);
@@ -356,6 +365,8 @@ int cSokolRender::Done() {
     activeCommand.Clear();
     ClearPooledResources(0);
     ClearCommands();
+    commandsStorage.clear();
+    uniformsArena.Free();
     ClearPipelines();
     shaders.clear();
     delete emptyTexture;
@@ -472,14 +483,83 @@ void cSokolRender::ClearCommands() {
             pooled.emplace(index_buffer);
         }
         
-        delete command;
+        command->Clear();
     }
     commands.clear();
+    commandsStorageUsed = 0;
+    uniformsArena.Reset();
 #ifdef PERIMETER_DEBUG
     //printf("%ld %ld\n", reclaimed.size(), bufferPool.size());
 #endif
 }
 
+SokolCommand* cSokolRender::AllocateCommand() {
+    if (commandsStorageUsed == commandsStorage.size()) {
+        commandsStorage.emplace_back();
+    }
+    SokolCommand* cmd = &commandsStorage[commandsStorageUsed++];
+    //Draw data, textures and params were released by ClearCommands, reset the rest
+    cmd->pipeline_id = 0;
+    cmd->shader_id = SOKOL_SHADER_ID_NONE;
+    cmd->base_elements = 0;
+    return cmd;
+}
+
+static bool CanMergeCommands(const SokolCommand* prev, const SokolCommand* next) {
+    if (next->pass_action
+    || prev->pipeline_id != next->pipeline_id
+    || prev->vertex_buffer != next->vertex_buffer
+    || prev->index_buffer != next->index_buffer
+    || prev->base_elements + prev->indices != next->base_elements) {
+        return false;
+    }
+    //Only lists can be joined by concatenating index ranges, strips and fans would get extra primitives
+    PIPELINE_TYPE type;
+    vertex_fmt_t fmt;
+    PIPELINE_MODE mode;
+    cSokolRender::GetPipelineIDParts(prev->pipeline_id, &type, &fmt, &mode);
+    if (type != PIPELINE_TYPE_TRIANGLE) {
+        return false;
+    }
+    if (memcmp(prev->sokol_textures, next->sokol_textures, sizeof(prev->sokol_textures)) != 0
+    || memcmp(prev->viewport, next->viewport, sizeof(prev->viewport)) != 0
+    || memcmp(prev->clip, next->clip, sizeof(prev->clip)) != 0) {
+        return false;
+    }
+    if (prev->vs_params_len != next->vs_params_len || prev->fs_params_len != next->fs_params_len
+    || memcmp(prev->vs_params, next->vs_params, prev->vs_params_len) != 0
+    || memcmp(prev->fs_params, next->fs_params, prev->fs_params_len) != 0) {
+        return false;
+    }
+    return true;
+}
+
+size_t cSokolRender::MergeCommands(std::vector<SokolCommand*>& list) {
+    //Commands are not reordered since blending depends on submission order,
+    //only neighbours that differ just by index range are joined
+    size_t count = 0;
+    SokolCommand* prev = nullptr;
+    for (SokolCommand* command : list) {
+        if (3 > command->vertices) {
+            //Not drawn but may switch pass
+            if (command->pass_action) {
+                prev = nullptr;
+            }
+            continue;
+        }
+        if (prev && CanMergeCommands(prev, command)) {
+            prev->indices += command->indices;
+            prev->vertices = std::max(prev->vertices, command->vertices);
+            //Keep it in list so buffers are reclaimed at ClearCommands, but skip drawing
+            command->vertices = 0;
+            continue;
+        }
+        prev = command;
+        count++;
+    }
+    return count;
+}
+
 void cSokolRender::ClearPipelines() {
     for (auto pipeline : pipelines) {
         delete pipeline.second;
@@ -599,6 +679,44 @@ void cSokolRender::d3d_DestroyDefaultRenderTarget() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+SokolFrameArena::~SokolFrameArena() {
+    Free();
+}
+
+void* SokolFrameArena::Allocate(size_t len) {
+    len = (len + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    xassert(len <= BLOCK_SIZE);
+    if (block_index < blocks.size() && BLOCK_SIZE < block_used + len) {
+        block_index++;
+        block_used = 0;
+    }
+    if (block_index == blocks.size()) {
+        //Extra space so block start can be aligned
+        blocks.push_back(new uint8_t[BLOCK_SIZE + ALIGNMENT]);
+        block_used = 0;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(blocks[block_index]);
+    start = (start + ALIGNMENT - 1) & ~static_cast<uintptr_t>(ALIGNMENT - 1);
+    void* ptr = reinterpret_cast<uint8_t*>(start) + block_used;
+    block_used += len;
+    return ptr;
+}
+
+void SokolFrameArena::Reset() {
+    block_index = 0;
+    block_used = 0;
+}
+
+void SokolFrameArena::Free() {
+    for (uint8_t* block : blocks) {
+        delete[] block;
+    }
+    blocks.clear();
+    Reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 SokolCommand::SokolCommand() {
 }
 
@@ -606,7 +724,7 @@ SokolCommand::~SokolCommand() {
     Clear();
 }
 
-void SokolCommand::CreateShaderParams() {
+void SokolCommand::CreateShaderParams(SokolFrameArena& arena) {
     switch (shader_id) {
         default:
         case SOKOL_SHADER_ID_NONE:
@@ -614,22 +732,22 @@ void SokolCommand::CreateShaderParams() {
             break;
         case SOKOL_SHADER_ID_color_tex1:
         case SOKOL_SHADER_ID_color_tex2:
-            vs_params = new color_texture_vs_params_t();
-            fs_params = new color_texture_fs_params_t();
             vs_params_len = sizeof(color_texture_vs_params_t);            
             fs_params_len = sizeof(color_texture_fs_params_t);
+            vs_params = new (arena.Allocate(vs_params_len)) color_texture_vs_params_t();
+            fs_params = new (arena.Allocate(fs_params_len)) color_texture_fs_params_t();
             break;
         case SOKOL_SHADER_ID_normal:
-            vs_params = new normal_texture_vs_params_t();
-            fs_params = new normal_texture_fs_params_t();
             vs_params_len = sizeof(normal_texture_vs_params_t);            
             fs_params_len = sizeof(normal_texture_fs_params_t);
+            vs_params = new (arena.Allocate(vs_params_len)) normal_texture_vs_params_t();
+            fs_params = new (arena.Allocate(fs_params_len)) normal_texture_fs_params_t();
             break;
         case SOKOL_SHADER_ID_terrain:
-            vs_params = new terrain_vs_params_t();
-            fs_params = new terrain_fs_params_t();
             vs_params_len = sizeof(terrain_vs_params_t);            
             fs_params_len = sizeof(terrain_fs_params_t);
+            vs_params = new (arena.Allocate(vs_params_len)) terrain_vs_params_t();
+            fs_params = new (arena.Allocate(fs_params_len)) terrain_fs_params_t();
             break;
     }
 }
@@ -652,24 +770,7 @@ void SokolCommand::ClearDrawData() {
 }
 
 void SokolCommand::ClearShaderParams() {
-    switch (shader_id) {
-        default:
-        case SOKOL_SHADER_ID_NONE:
-            break;
-        case SOKOL_SHADER_ID_color_tex1:
-        case SOKOL_SHADER_ID_color_tex2:
-            delete reinterpret_cast<color_texture_vs_params_t*>(vs_params);
-            delete reinterpret_cast<color_texture_fs_params_t*>(fs_params);
-            break;
-        case SOKOL_SHADER_ID_normal:
-            delete reinterpret_cast<normal_texture_vs_params_t*>(vs_params);
-            delete reinterpret_cast<normal_texture_fs_params_t*>(fs_params);
-            break;
-        case SOKOL_SHADER_ID_terrain:
-            delete reinterpret_cast<terrain_vs_params_t*>(vs_params);
-            delete reinterpret_cast<terrain_fs_params_t*>(fs_params);
-            break;
-    }
+    //Params are trivially destructible and owned by frame arena
     vs_params = nullptr;
     fs_params = nullptr;
     vs_params_len = 0;
@@ -7,15 +7,38 @@
 
 #include <sokol_gfx.h>
 #include <SDL_video.h>
+#include <deque>
+#include <atomic>
 
 #include "SokolTypes.h"
 
 const int PERIMETER_SOKOL_TEXTURES = 8;
 
+///Linear allocator for data that lives until end of frame, memory blocks are kept between frames
+class SokolFrameArena {
+public:
+    SokolFrameArena() = default;
+    ~SokolFrameArena();
+    NO_COPY_CONSTRUCTOR(SokolFrameArena);
+
+    ///Returns 16 byte aligned memory, valid until Reset
+    void* Allocate(size_t len);
+    void Reset();
+    void Free();
+
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+    static const size_t ALIGNMENT = 16;
+    std::vector<uint8_t*> blocks;
+    size_t block_index = 0;
+    size_t block_used = 0;
+};
+
 struct SokolCommand {
     SokolCommand();
     ~SokolCommand();
-    void CreateShaderParams();
+    ///Shader params are allocated in arena and not freed by command
+    void CreateShaderParams(SokolFrameArena& arena);
     void Clear();
     void ClearDrawData();
     void ClearShaderParams();
@@ -82,6 +105,27 @@ private:
     bool ActiveScene = false;
     bool isOrthographicProjSet = false;
     std::vector<SokolCommand*> commands;
+    //Commands and their shader params are reused each frame instead of allocating per draw
+    std::deque<SokolCommand> commandsStorage;
+    size_t commandsStorageUsed = 0;
+    SokolFrameArena uniformsArena;
+    //Merge of consecutive commands with same state and contiguous indices
+    bool mergeCommands = true;
+    size_t commandsSubmitted = 0;
+    size_t commandsAfterMerge = 0;
+    //Meshes with same material drawn in single command, see DrawNoMaterialMeshInstances
+    static const int MESH_INSTANCE_MAX_VERTICES = 1024;
+    bool meshInstancing = true;
+    size_t meshInstancesBatched = 0;
+    size_t meshInstanceBatches = 0;
+    //Instancing benchmark requested from logic thread, measured in EndScene
+    std::atomic<int> instancingBenchRequest = 0;
+    int instancingBenchFrames = 0;
+    int instancingBenchLeft = 0;
+    bool instancingBenchSaved = true;
+    size_t instancingBenchDraws = 0;
+    uint64_t instancingBenchTime = 0;
+    void InstancingBenchmarkFrame(uint64_t submit_time);
     sg_sampler sampler;
     
     //Empty texture when texture slot is unused
@@ -122,6 +166,9 @@ private:
     //Commands handling
     void ClearActiveBufferAndPassAction();
     void ClearCommands();
+    SokolCommand* AllocateCommand();
+    ///Joins consecutive triangle commands which can be drawn as single draw call, returns amount left
+    static size_t MergeCommands(std::vector<SokolCommand*>& list);
     void FinishActiveDrawBuffer();
     void CreateCommandEmpty();
     void CreateCommand(class VertexBuffer* vb, size_t vertices, class IndexBuffer* ib, size_t indices);
@@ -130,6 +177,8 @@ private:
     void SetColorMode(eColorMode color_mode);
     void SetMaterial(SOKOL_MATERIAL_TYPE material, const sColor4f& diffuse, const sColor4f& ambient,
                      const sColor4f& specular, const sColor4f& emissive, float power);
+    void SetMeshTextureTransform(sDataRenderMaterial* data);
+    static bool IsMeshInstanceable(cObjMesh* mesh);
 
     ///Assigns unused sokol buffer to buffer_ptr with requested 
     void PrepareSokolBuffer(SokolBuffer*& buffer_ptr, MemoryResource* resource, size_t len, bool dynamic, sg_buffer_type type);
@@ -187,6 +236,7 @@ public:
 
     int BeginScene() override;
     int EndScene() override;
+    void StartInstancingBenchmark(int frames) override;
     int Fill(int r,int g,int b,int a=255) override;
     void ClearZBuffer() override;
     int Flush(bool wnd=false) override;
@@ -232,6 +282,7 @@ public:
     void EndDrawMesh() override;
     void SetSimplyMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data) override;
     void DrawNoMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data) override;
+    void DrawNoMaterialMeshInstances(cObjMesh** meshes, size_t count, sDataRenderMaterial* data) override;
 
     void BeginDrawShadow(bool shadow_map) override;
     void EndDrawShadow() override;
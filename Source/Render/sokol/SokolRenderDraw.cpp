@@ -127,10 +127,7 @@ void cSokolRender::SetSimplyMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* da
     SetTexture(1, bump ? nullptr: data->Tex[1], data->MaterialAnimPhase);
 }
 
-void cSokolRender::DrawNoMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data) {
-    //TODO SetPointLight(mesh->GetRootNode()->GetLight());
-
-    SetWorldMatXf(mesh->GetGlobalMatrix());
+void cSokolRender::SetMeshTextureTransform(sDataRenderMaterial* data) {
     Mat4f& tex0mat = activeTextureTransform[0];
     if(data->mat&MAT_TEXMATRIX_STAGE1) {
         MatXf &m=data->TexMatrix;
@@ -149,12 +146,97 @@ void cSokolRender::DrawNoMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data)
     } else {
         tex1mat = Mat4f::ID;
     }
+}
+
+void cSokolRender::DrawNoMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data) {
+    //TODO SetPointLight(mesh->GetRootNode()->GetLight());
+
+    SetWorldMatXf(mesh->GetGlobalMatrix());
+    SetMeshTextureTransform(data);
 
     cMeshTri* Tri = mesh->GetTri();
     SubmitDrawBuffer(Tri->db, &Tri->dbr);
 
-    tex0mat = Mat4f::ID;
-    tex1mat = Mat4f::ID;
+    activeTextureTransform[0] = Mat4f::ID;
+    activeTextureTransform[1] = Mat4f::ID;
+}
+
+bool cSokolRender::IsMeshInstanceable(cObjMesh* mesh) {
+    cMeshTri* Tri = mesh->GetTri();
+    return Tri->db->vb.fmt == sVertexXYZNT1::fmt
+        && Tri->NumVertex <= MESH_INSTANCE_MAX_VERTICES
+        && Tri->dbr.len <= MESH_INSTANCE_MAX_VERTICES * sPolygon::PN;
+}
+
+void cSokolRender::DrawNoMaterialMeshInstances(cObjMesh** meshes, size_t count, sDataRenderMaterial* data) {
+    //Shaders have no per instance attributes, so instances are transformed to world space on CPU
+    //and written into single buffer. Specular depends on model space position, keep those separate
+    bool specular = (data->mat & MAT_LIGHT) && (data->mat & MAT_COLOR_ADD_SPECULAR);
+    if (!meshInstancing || count < 2 || specular) {
+        cInterfaceRenderDevice::DrawNoMaterialMeshInstances(meshes, count, data);
+        return;
+    }
+
+    DrawBuffer* db = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        cObjMesh* mesh = meshes[i];
+        if (!IsMeshInstanceable(mesh)) {
+            if (db) {
+                db->Draw();
+                db = nullptr;
+                meshInstanceBatches++;
+            }
+            DrawNoMaterialMesh(mesh, data);
+            continue;
+        }
+        if (!db) {
+            SetWorldMat4f(nullptr);
+            //Texture transforms are set directly, submit anything pending with previous ones
+            FinishActiveDrawBuffer();
+            SetMeshTextureTransform(data);
+            db = GetDrawBuffer(sVertexXYZNT1::fmt, PT_TRIANGLES, MESH_INSTANCE_MAX_VERTICES * 4);
+        }
+
+        cMeshTri* Tri = mesh->GetTri();
+        sVertexXYZNT1* vb = nullptr;
+        indices_t* ib = nullptr;
+        db->Lock(Tri->NumVertex, Tri->dbr.len, vb, ib, true);
+        //Lock might have submitted previous contents
+        size_t base = db->written_vertices;
+
+        const MatXf& matrix = mesh->GetGlobalMatrix();
+        //Matrix may contain scale, normals use inverse transpose and are renormalized
+        Mat3f normal_matrix;
+        normal_matrix.invert(matrix.rot());
+        const sVertexXYZNT1* src = Tri->VertexBuffer;
+        for (int v = 0; v < Tri->NumVertex; ++v) {
+            Vect3f pos(src[v].x, src[v].y, src[v].z);
+            Vect3f normal(src[v].n[0], src[v].n[1], src[v].n[2]);
+            matrix.xformPoint(pos);
+            normal_matrix.invXform(normal);
+            normal.Normalize();
+            vb[v].setPos(pos);
+            normal.write(vb[v].n);
+            vb[v].uv[0] = src[v].uv[0];
+            vb[v].uv[1] = src[v].uv[1];
+        }
+
+        //Polygon indices point to whole bank vertices
+        const indices_t* src_indices = reinterpret_cast<const indices_t*>(Tri->PolygonBuffer);
+        for (size_t n = 0; n < Tri->dbr.len; ++n) {
+            ib[n] = static_cast<indices_t>(src_indices[n] - Tri->OffsetVertex + base);
+        }
+        db->Unlock();
+
+        meshInstancesBatched++;
+    }
+    if (db) {
+        db->Draw();
+        meshInstanceBatches++;
+    }
+
+    activeTextureTransform[0] = Mat4f::ID;
+    activeTextureTransform[1] = Mat4f::ID;
 }
 
 void cSokolRender::BeginDrawShadow(bool shadow_map) {
@@ -64,6 +64,16 @@ int cSokolRender::EndScene() {
         return 1;
     }
 
+    if (Option_DrawNumberPolygon) {
+        //Numbers of previous frame
+        char str[256];
+        sprintf(str, "commands=%" PRIsize ", merged=%" PRIsize ", mesh instances=%" PRIsize " in %" PRIsize " draws",
+                commandsSubmitted, commandsAfterMerge, meshInstancesBatched, meshInstanceBatches);
+        OutText(10, 100, str, sColor4f(1, 1, 1, 1));
+    }
+    meshInstancesBatched = 0;
+    meshInstanceBatches = 0;
+
     //Make sure there is nothing left to send as command
     ClearActiveBufferAndPassAction();
     xassert(activeDrawBuffer == nullptr);
@@ -71,15 +81,63 @@ int cSokolRender::EndScene() {
 
     ActiveScene = false;
 
+    uint64_t submit_start = clock_us();
+    commandsSubmitted = 0;
+    for (const SokolCommand* command : commands) {
+        if (3 <= command->vertices) {
+            commandsSubmitted++;
+        }
+    }
+    commandsAfterMerge = mergeCommands ? MergeCommands(commands) : commandsSubmitted;
+
 #ifdef SOKOL_METAL
     sokol_metal_render(&swapchain, &sokol_metal_render_callback);
 #else
     DoSokolRendering();
 #endif
+    InstancingBenchmarkFrame(clock_us() - submit_start);
 
     return cInterfaceRenderDevice::EndScene();
 }
 
+void cSokolRender::StartInstancingBenchmark(int frames) {
+    instancingBenchRequest = frames;
+}
+
+void cSokolRender::InstancingBenchmarkFrame(uint64_t submit_time) {
+    //Few frames are skipped so textures and buffers of new models are already created
+    const int WARMUP_FRAMES = 10;
+    int request = instancingBenchRequest.exchange(0);
+    if (0 < request) {
+        instancingBenchFrames = request;
+        instancingBenchLeft = WARMUP_FRAMES + request * 2;
+        instancingBenchSaved = meshInstancing;
+        instancingBenchDraws = 0;
+        instancingBenchTime = 0;
+        meshInstancing = true;
+        return;
+    }
+    if (instancingBenchLeft <= 0) {
+        return;
+    }
+    instancingBenchLeft--;
+    if (instancingBenchLeft >= instancingBenchFrames * 2) {
+        return;
+    }
+    instancingBenchDraws += commandsAfterMerge;
+    instancingBenchTime += submit_time;
+    if (instancingBenchLeft == instancingBenchFrames || instancingBenchLeft == 0) {
+        fprintf(stderr, "Mesh instancing bench: instancing %s, %d frames, %.1f draw calls, submit %.3f ms per frame\n",
+                meshInstancing ? "on" : "off", instancingBenchFrames,
+                static_cast<double>(instancingBenchDraws) / instancingBenchFrames,
+                instancingBenchTime * 1e-3 / instancingBenchFrames);
+        instancingBenchDraws = 0;
+        instancingBenchTime = 0;
+        //Toggle takes effect from next frame draws
+        meshInstancing = instancingBenchLeft ? false : instancingBenchSaved;
+    }
+}
+
 void cSokolRender::DoSokolRendering() {
     //This function might be called from a callback!
 
@@ -451,7 +509,7 @@ void cSokolRender::CreateCommandEmpty() {
 #endif
 
     //Create command to be send
-    SokolCommand* cmd = new SokolCommand();
+    SokolCommand* cmd = AllocateCommand();
     memcpy(cmd->viewport, activeCommand.viewport, sizeof(Vect2i) * 2);
     memcpy(cmd->clip, activeCommand.clip, sizeof(Vect2i) * 2);
 
@@ -536,7 +594,7 @@ void cSokolRender::CreateCommand(VertexBuffer* vb, size_t vertices, IndexBuffer*
     xassert((activeCommand.base_elements + activeCommand.indices) <= indices);
     
     //Create command to be send
-    SokolCommand* cmd = new SokolCommand();
+    SokolCommand* cmd = AllocateCommand();
     cmd->pipeline_id = pipeline_id;
     cmd->shader_id = pipeline->shader_id;
     for (int i = 0; i < PERIMETER_SOKOL_TEXTURES; ++i) {
@@ -549,7 +607,7 @@ void cSokolRender::CreateCommand(VertexBuffer* vb, size_t vertices, IndexBuffer*
     memcpy(cmd->clip, activeCommand.clip, sizeof(Vect2i) * 2);
     
     //Set shader params
-    cmd->CreateShaderParams();
+    cmd->CreateShaderParams(uniformsArena);
     switch (cmd->shader_id) {
         default:
         case SOKOL_SHADER_ID_NONE:
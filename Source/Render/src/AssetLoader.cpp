@@ -0,0 +1,249 @@
+#include "StdAfxRD.h"
+#include "AssetLoader.h"
+#include "FileImage.h"
+
+//Чтение с диска и декодирование, больше потоков только мешают друг другу
+static const int ASSET_LOADER_THREADS=2;
+
+static cAssetLoader* asset_loader=nullptr;
+
+cAssetLoader* GetAssetLoader()
+{
+	if(!Option_AssetStreaming || ResourceIsZIP())
+		return nullptr;
+	return asset_loader;
+}
+
+void CreateAssetLoader()
+{
+	if(!asset_loader)
+		asset_loader=new cAssetLoader;
+}
+
+void DeleteAssetLoader()
+{
+	delete asset_loader;
+	asset_loader=nullptr;
+}
+
+cAssetLoader::cAssetLoader()
+{
+	loaded=0;
+	next_serial=0;
+	mutex=SDL_CreateMutex();
+	work_cond=SDL_CreateCond();
+	done_cond=SDL_CreateCond();
+	quit=false;
+}
+
+cAssetLoader::~cAssetLoader()
+{
+	SDL_LockMutex(mutex);
+	quit=true;
+	queue.clear();
+	SDL_CondBroadcast(work_cond);
+	SDL_UnlockMutex(mutex);
+
+	for(SDL_Thread* thread : threads)
+		SDL_WaitThread(thread,nullptr);
+	threads.clear();
+
+	Clear();
+
+	SDL_DestroyCond(done_cond);
+	SDL_DestroyCond(work_cond);
+	SDL_DestroyMutex(mutex);
+}
+
+std::string cAssetLoader::Key(eKind kind,const std::string& path)
+{
+	return std::string(kind==ASSET_IMAGE?"i:":"f:")+path;
+}
+
+void cAssetLoader::Start()
+{
+	if(!threads.empty())
+		return;
+	for(int i=0;i<ASSET_LOADER_THREADS;i++)
+	{
+		SDL_Thread* thread=SDL_CreateThread(Worker,"asset_loader",this);
+		if(!thread)
+		{
+			fprintf(stderr,"cAssetLoader: SDL_CreateThread failed: %s\n",SDL_GetError());
+			break;
+		}
+		threads.push_back(thread);
+	}
+}
+
+void cAssetLoader::Request(eKind kind,const std::string& path)
+{
+	if(path.empty())
+		return;
+	std::string key=Key(kind,path);
+	SDL_LockMutex(mutex);
+	if(!jobs.count(key))
+	{
+		Job& job=jobs[key];
+		job.kind=kind;
+		job.path=path;
+		job.state=STATE_QUEUED;
+		job.serial=++next_serial;
+		job.buf=nullptr;
+		job.size=0;
+		job.image=nullptr;
+		queue.push_back(key);
+		Start();
+		SDL_CondSignal(work_cond);
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+bool cAssetLoader::IsReady(eKind kind,const std::string& path)
+{
+	SDL_LockMutex(mutex);
+	auto it=jobs.find(Key(kind,path));
+	bool ready=it==jobs.end() || it->second.state==STATE_DONE || it->second.state==STATE_FAILED;
+	SDL_UnlockMutex(mutex);
+	return ready;
+}
+
+int cAssetLoader::GetQueued()
+{
+	SDL_LockMutex(mutex);
+	int n=queue.size();
+	SDL_UnlockMutex(mutex);
+	return n;
+}
+
+//Вызывается под mutex, забирает выполненную работу из jobs
+bool cAssetLoader::TakeJob(eKind kind,const std::string& path,Job& out)
+{
+	std::string key=Key(kind,path);
+	auto it=jobs.find(key);
+	if(it==jobs.end())
+		return false;
+
+	if(it->second.state==STATE_QUEUED)
+	{
+		//Быстрее загрузить самому, чем ждать очереди
+		auto qit=std::find(queue.begin(),queue.end(),key);
+		if(qit!=queue.end())
+			queue.erase(qit);
+		jobs.erase(it);
+		return false;
+	}
+
+	unsigned serial=it->second.serial;
+	while(it->second.state==STATE_RUNNING)
+	{
+		SDL_CondWait(done_cond,mutex);
+		it=jobs.find(key);
+		if(it==jobs.end() || it->second.serial!=serial)
+			return false;
+	}
+
+	out=it->second;
+	jobs.erase(it);
+	return out.state==STATE_DONE;
+}
+
+bool cAssetLoader::TakeFile(const std::string& path,char*& buf,int& size)
+{
+	Job job;
+	SDL_LockMutex(mutex);
+	bool ok=TakeJob(ASSET_FILE,path,job);
+	SDL_UnlockMutex(mutex);
+	if(!ok)
+		return false;
+	buf=job.buf;
+	size=job.size;
+	return true;
+}
+
+cFileImage* cAssetLoader::TakeImage(const std::string& path)
+{
+	Job job;
+	SDL_LockMutex(mutex);
+	bool ok=TakeJob(ASSET_IMAGE,path,job);
+	SDL_UnlockMutex(mutex);
+	return ok?job.image:nullptr;
+}
+
+void cAssetLoader::FreeJob(Job& job)
+{
+	delete[] job.buf;
+	job.buf=nullptr;
+	delete job.image;
+	job.image=nullptr;
+}
+
+void cAssetLoader::Clear()
+{
+	SDL_LockMutex(mutex);
+	queue.clear();
+	//Результат выполняемых сейчас выбросит рабочий поток, не найдя их в jobs
+	for(auto& it : jobs)
+		FreeJob(it.second);
+	jobs.clear();
+	SDL_UnlockMutex(mutex);
+}
+
+int cAssetLoader::Worker(void* data)
+{
+	static_cast<cAssetLoader*>(data)->Run();
+	return 0;
+}
+
+void cAssetLoader::Run()
+{
+	SDL_LockMutex(mutex);
+	while(!quit)
+	{
+		if(queue.empty())
+		{
+			SDL_CondWait(work_cond,mutex);
+			continue;
+		}
+
+		std::string key=queue.front();
+		queue.pop_front();
+		auto it=jobs.find(key);
+		if(it==jobs.end() || it->second.state!=STATE_QUEUED)
+			continue;
+		Job job=it->second;
+		it->second.state=STATE_RUNNING;
+		SDL_UnlockMutex(mutex);
+
+		bool ok=false;
+		if(job.kind==ASSET_FILE)
+		{
+			ok=ResourceFileRead(job.path.c_str(),job.buf,job.size)==0;
+		}else
+		{
+			job.image=cFileImage::Create(job.path);
+			ok=job.image && job.image->load(job.path.c_str())==0;
+		}
+		if(ok)
+			loaded++;
+
+		SDL_LockMutex(mutex);
+		it=jobs.find(key);
+		bool same=it!=jobs.end() && it->second.serial==job.serial;
+		if(!same || quit)
+		{
+			//Пока грузили, результат перестал быть нужен или путь запрошен заново
+			FreeJob(job);
+			if(same)
+				jobs.erase(it);
+		}else
+		{
+			if(!ok)
+				FreeJob(job);
+			job.state=ok?STATE_DONE:STATE_FAILED;
+			it->second=job;
+		}
+		SDL_CondBroadcast(done_cond);
+	}
+	SDL_UnlockMutex(mutex);
+}
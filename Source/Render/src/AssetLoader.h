@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class cFileImage;
+
+//Фоновая загрузка ресурсов.
+//Рабочие потоки читают файлы моделей и декодируют картинки текстур,
+//разбор моделей и создание текстур остаются за вызывающей стороной.
+class cAssetLoader
+{
+public:
+	enum eKind
+	{
+		ASSET_FILE,		//файл целиком в память (m3d)
+		ASSET_IMAGE,	//декодированная картинка cFileImage
+	};
+
+	cAssetLoader();
+	~cAssetLoader();
+
+	//Ставит путь в очередь, повторный запрос того же пути ничего не делает
+	void Request(eKind kind,const std::string& path);
+	//Готов ли результат или запроса нет (выброшен Clear), не ждет
+	bool IsReady(eKind kind,const std::string& path);
+
+	//Забирают результат, если он еще в работе - ждут.
+	//false/nullptr если запроса не было или загрузка не удалась,
+	//тогда вызывающий грузит сам, как без фоновой загрузки
+	bool TakeFile(const std::string& path,char*& buf,int& size);
+	cFileImage* TakeImage(const std::string& path);
+
+	//Выбрасывает незабранные результаты и очередь, вызывается при выгрузке миссии и библиотек
+	void Clear();
+
+	int GetQueued();
+	int GetLoaded(){return loaded;}
+private:
+	enum eState
+	{
+		STATE_QUEUED,
+		STATE_RUNNING,
+		STATE_DONE,
+		STATE_FAILED,
+	};
+
+	struct Job
+	{
+		eKind kind;
+		std::string path;
+		eState state;
+		//Номер запроса, чтобы рабочий поток не принял за свою работу путь, запрошенный заново
+		unsigned serial;
+		char* buf;
+		int size;
+		cFileImage* image;
+	};
+
+	std::unordered_map<std::string, Job> jobs;
+	std::deque<std::string> queue;
+	std::atomic<int> loaded;
+	unsigned next_serial;
+
+	SDL_mutex* mutex;
+	SDL_cond* work_cond;
+	SDL_cond* done_cond;
+	std::vector<SDL_Thread*> threads;
+	bool quit;
+
+	static std::string Key(eKind kind,const std::string& path);
+	bool TakeJob(eKind kind,const std::string& path,Job& out);
+	void FreeJob(Job& job);
+	void Start();
+	static int Worker(void* data);
+	void Run();
+};
+
+//nullptr если фоновая загрузка выключена (render_asset_streaming=0)
+//или ресурсы читаются из zip, ZIPStream не рассчитан на несколько потоков
+cAssetLoader* GetAssetLoader();
+void CreateAssetLoader();
+void DeleteAssetLoader();
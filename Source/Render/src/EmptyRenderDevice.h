@@ -91,6 +91,7 @@ public:
     void EndDrawMesh() override {}
     void SetSimplyMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data) override {}
     void DrawNoMaterialMesh(cObjMesh* mesh, sDataRenderMaterial* data) override {}
+    void DrawNoMaterialMeshInstances(cObjMesh** meshes, size_t count, sDataRenderMaterial* data) override {}
 
     void BeginDrawShadow(bool shadow_map) override {}
     void EndDrawShadow() override {}
@@ -19,6 +19,7 @@
 #endif
 
 int ResourceFileRead(const char *fname,char *&buf,int &size);
+int ResourceFileReadHeader(const char *fname,void *buf,int size);
 
 #define FI_ABS(a)										((a)>=0?(a):-(a))
 #define FI_SIGN(a)										((a)>0?1:((a)<0)?-1:0)
@@ -1081,6 +1082,17 @@ cFileImage* cFileImage::Create(const std::string& fname)
 	return nullptr;
 }
 
+int cFileImage::PeekBitPerPixel(const std::string& fname)
+{
+    //Глубина есть в заголовке только у TGA, остальные форматы надо декодировать
+    if(!endsWith(string_to_lower(fname.c_str()),".tga"))
+        return -1;
+    TGAHeader header;
+    if(ResourceFileReadHeader(fname.c_str(),&header,sizeof(header)))
+        return -1;
+    return header.bitsPerPixel;
+}
+
 void cFileImage::InitFileImage() {
     IMG_Init(IMG_INIT_JPG | IMG_INIT_PNG);
 }
@@ -28,6 +28,8 @@ public:
 	static void InitFileImage();
 	static void DoneFileImage();
 	static cFileImage* Create(const std::string& fname);
+	//Бит на пиксель по заголовку файла без декодирования, -1 если формат этого не позволяет
+	static int PeekBitPerPixel(const std::string& fname);
 };
 class cAviScaleFileImage : public cFileImage
 {
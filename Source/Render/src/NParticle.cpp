@@ -14,9 +14,30 @@
 
 const size_t PARTICLE_BUF_LOCK_LEN = 50;
 
-static RandomGenerator rnd;
 static std::vector<Vect2f> rotate_angle;
 
+//Положение, поворот, цвет и размер частиц на текущем кадре.
+//Считаются одним проходом по всем частицам эмиттера перед выводом в буфер,
+//общие для всех эмиттеров, Draw вызывается только из графического потока
+struct ParticleDrawBatch
+{
+	std::vector<Vect3f> pos;
+	std::vector<float> angle;
+	std::vector<float> size;
+	std::vector<sColor4f> color;
+
+	void resize(int n)
+	{
+		if(pos.size()>=n)
+			return;
+		pos.resize(n);
+		angle.resize(n);
+		size.resize(n);
+		color.resize(n);
+	}
+};
+static ParticleDrawBatch particle_batch;
+
 float GlobalParticleRate = 1.0f;
 KeyFloat::value KeyFloat::none=0;
 KeyPos::value KeyPos::none=Vect3f::ZERO;
@@ -84,6 +105,7 @@ cEmitterBase::cEmitterBase()
 	TraceCount = 1;
 	PlumeInterval = 0.01f;
 	other = nullptr;
+	rnd_seeded = false;
 }
 
 cEmitterBase::~cEmitterBase()
@@ -103,6 +125,41 @@ void cEmitterBase::InitRotateAngle()
 	}
 }
 
+void cEmitterBase::SeedRandom()
+{
+	//Квант и место появления эффекта одинаковы при повторе записи,
+	//номер эмиттера различает эмиттеры одного эффекта
+	int index=std::find(parent->emitters.begin(),parent->emitters.end(),this)-parent->emitters.begin();
+	const Vect3f& pos=parent->GetGlobalMatrix().trans();
+	unsigned int seed=gb_VisGeneric->GetGraphLogicQuant();
+	seed=seed*31+xm::round(pos.x);
+	seed=seed*31+xm::round(pos.y);
+	seed=seed*31+xm::round(pos.z);
+	seed=seed*31+index;
+	rnd.set(seed);
+	rnd_seeded=true;
+}
+
+void cEmitterBase::InitPlumePos(int ix,const Vect3f& pos)
+{
+	xassert(TraceCount>0);
+	if(plume_pos.size()<(ix+1)*TraceCount)
+		plume_pos.resize((ix+1)*TraceCount);
+	Vect3f* p=GetPlumePos(ix);
+	for(int i=0;i<TraceCount;i++)
+		p[i]=pos;
+}
+
+void cEmitterBase::MovePlumePos(int from,int to)
+{
+	if(!chPlume)
+		return;
+	Vect3f* src=GetPlumePos(from);
+	Vect3f* dst=GetPlumePos(to);
+	for(int i=0;i<TraceCount;i++)
+		dst[i]=src[i];
+}
+
 void cEmitterBase::SetMaxTime(float emitter_life,float particle_life)
 {
 	emitter_life_time=emitter_life;
@@ -195,6 +252,8 @@ void cEmitterBase::PreDraw(cCamera *pCamera)
 void cEmitterBase::Animate(float dt)
 {
 	if(b_pause)return;
+	if(!rnd_seeded)
+		SeedRandom();
 	dt*=1e-3f;
 	if(dt>0.1f)
 		dt=0.1f;
@@ -520,14 +579,13 @@ cEmitterInt::~cEmitterInt()
 {
 }
 
-template<class nParticle> FORCEINLINE int ParticlePutToBuf(cEmitterBase* emitter, nParticle& p, Vect3f& npos, float& dt,
+template<class nParticle> FORCEINLINE int ParticlePutToBuf(cEmitterBase* emitter, nParticle& p, Vect3f* plume_pos, Vect3f& npos, float& dt,
                                                                  DrawBuffer* db, sVertexXYZDT1*& v, indices_t*& ib,
                                                                  const uint32_t& color, const Vect3f& PosCamera,
                                                                  const float& size, const cTextureAviScale::RECT& rt,
                                                                  const uint8_t mode, MatXf* iGM = nullptr)
 
 {
-	xassert(!p.plume_pos.empty());
 	float dv1 = (rt.right - rt.left)/emitter->GetTraceCount();
 	float v1 = rt.left;
 	Vect3f prev_lt,prev_lb;
@@ -535,7 +593,7 @@ template<class nParticle> FORCEINLINE int ParticlePutToBuf(cEmitterBase* emitter
 	Vect3f vCameraToObject;
 	if(mode&1) vCameraToObject.set(0,0,1);
 	else vCameraToObject = PosCamera - /*GetGlobalMatrix()*/npos;
-	sy.cross(vCameraToObject, npos - p.plume_pos[0]);
+	sy.cross(vCameraToObject, npos - plume_pos[0]);
 	FastNormalize(sy);
 	sy*=size;
 	prev_lt = npos - sy;
@@ -573,7 +631,7 @@ template<class nParticle> FORCEINLINE int ParticlePutToBuf(cEmitterBase* emitter
 		prev_lt.write(v[0].pos); v[0].diffuse=color; v[0].GetTexel().set(v1, rt.top);		//	(0,0);
 		prev_lb.write(v[1].pos); v[1].diffuse=color; v[1].GetTexel().set(v1, rt.bottom);	//	(0,1);
 
-		Vect3f pos = p.plume_pos[i];
+		Vect3f pos = plume_pos[i];
 		pos+= (prev_pos - pos)*(dt/(real_interval+dt));
 		if(mode&2) 
 		{
@@ -614,7 +672,7 @@ template<class nParticle> FORCEINLINE int ParticlePutToBuf(cEmitterBase* emitter
 		else
 		{
 			real_interval = interval;
-			p.plume_pos[i] = pos;
+			plume_pos[i] = pos;
 		}
 		if (p.time_summary<=1)v1+=dv1*(real_interval/interval);
 		prev_lt.write(v[2].pos); v[2].diffuse=color; v[2].GetTexel().set(v1,rt.top);		//  (1,0);
@@ -698,44 +756,41 @@ void cEmitterInt::Draw(cCamera *pCamera)
     sVertexXYZDT1 *v = nullptr;
     size_t size=Particle.size();
     DrawBuffer* db = rd->GetDrawBuffer(sVertexXYZDT1::fmt, PT_TRIANGLES, PARTICLE_BUF_LOCK_LEN * 4 * 10);
-    for (int i=size-1;i>=0;i--) {
-/*		nParticle& p=Particle[i];
-        if(p.key<0)continue;
-        if (NeedPlume)
-            PutPlumeParticle(dtime_global, Bound, texture, plume_texture, 
-                                    mat, p,	pBuf, pos, dtime );
-        const cTextureAviScale::RECT& rt = texture?
-                    ((cTextureAviScale*)texture)->GetFramePos(p.time_summary) :
-                    cTextureAviScale::RECT::ID;	
-        p.PutToBuf(dtime_global, keys[p.key], keys[p.key+1],
-                    Bound, rt, mat, pBuf, this, pos, dtime, p.time, 1.0f);
-*/
-
+    //Положение, поворот, цвет и размер считаются одним проходом по частицам,
+    //вывод в буфер и продвижение времени - следующим
+    ParticleDrawBatch& batch=particle_batch;
+    batch.resize(size);
+    for (int i=0;i<size;i++) {
         nParticle& p=Particle[i];
         if(p.key<0)continue;
-        Vect3f pos;
-        float angle;
-        sColor4f fcolor;
-        float psize;
-
-        float dtime=dtime_global*p.inv_life_time;
         KeyParticleInt& k0=keys[p.key];
         KeyParticleInt& k1=keys[p.key+1];
-        
-        float& t=p.time;
+
+        float t=p.time;
         float ts=t*k0.inv_dtime;
+        Vect3f& pos=batch.pos[i];
         if (calc_pos)
             pos = p.pos0+p.vdir*(t*(k0.vel+ts*0.5f*(k1.vel-k0.vel)))+g*((p.gvel0+t*k0.gravity*0.5f)*t);
         else pos = p.pos0; ///temp
         Bound.AddBound(pos);
-        angle = p.angle0+ p.angle_dir*(k0.angle_vel*t+t*ts*0.5f*(k1.angle_vel-k0.angle_vel));
-        fcolor = k0.color+(k1.color-k0.color)*ts;
-        psize = k0.size+(k1.size-k0.size)*ts;
+        batch.angle[i] = p.angle0+ p.angle_dir*(k0.angle_vel*t+t*ts*0.5f*(k1.angle_vel-k0.angle_vel));
+        batch.color[i] = k0.color+(k1.color-k0.color)*ts;
+        batch.size[i] = (k0.size+(k1.size-k0.size)*ts)*p.begin_size;
+    }
+
+    for (int i=size-1;i>=0;i--) {
+        nParticle& p=Particle[i];
+        if(p.key<0)continue;
+        Vect3f& pos=batch.pos[i];
+        const sColor4f& fcolor=batch.color[i];
+        float psize=batch.size[i];
+
+        float dtime=dtime_global*p.inv_life_time;
 
         //Добавить в массив
         Vect3f sx,sy;
-        Vect2f rot=rotate_angle[(int) xm::round(angle * rotate_angle_size) & rotate_angle_mask];
-        rot*=psize*=p.begin_size;
+        Vect2f rot=rotate_angle[(int) xm::round(batch.angle[i] * rotate_angle_size) & rotate_angle_mask];
+        rot*=psize;
         mat.invXformVect(Vect3f(+rot.x,-rot.y,0),sx);
         mat.invXformVect(Vect3f(+rot.y,+rot.x,0),sy);
 
@@ -748,7 +803,7 @@ void cEmitterInt::Draw(cCamera *pCamera)
                         cTextureAviScale::RECT::ID;	
         if (chPlume)
         {
-            if (ParticlePutToBuf(this, p,pos,dtime,db,v,ib,color,CameraPos,psize, rt, false))
+            if (ParticlePutToBuf(this, p,GetPlumePos(i),pos,dtime,db,v,ib,color,CameraPos,psize, rt, false))
                 continue;
         } else {
             db->AutoLockQuad<sVertexXYZDT1>(PARTICLE_BUF_LOCK_LEN, 1, v, ib);
@@ -762,11 +817,12 @@ void cEmitterInt::Draw(cCamera *pCamera)
                 parent->AddSquareTriangle(psize*psize);
             #endif
         }
-        ProcessTime(p,dtime,i,pos);
+        //cEmitterZ рисуется своим Draw, здесь виртуальный вызов не нужен
+        cEmitterInt::ProcessTime(p,dtime,i,pos);
     }
     db->AutoUnlock();
     
-	Particle.Compress();
+	Particle.Compress([this](int from,int to){MovePlumePos(from,to);});
 	old_time=time;
 }
 
@@ -999,13 +1055,7 @@ void cEmitterInt::EmitOne(int ix_cur/*nParticle& cur*/,float begin_time)
 
 	CalcColor(cur);
 	if (chPlume)
-	{	
-		cur.plume_pos.resize(TraceCount);
-		std::vector<Vect3f>::iterator it;
-		Vect3f& bpos = /*GetGlobalMatrix()*/cur.pos0;
-		FOR_EACH(cur.plume_pos,it)
-			*it = bpos;
-	}
+		InitPlumePos(ix_cur, /*GetGlobalMatrix()*/cur.pos0);
 }
 
 Vect3f cEmitterInt::CalcVelocity(const EffectBeginSpeedMatrix& s,const nParticle& cur,float mul)
@@ -1274,52 +1324,50 @@ void cEmitterSpl::Draw(cCamera *pCamera)
     sVertexXYZDT1 *v = nullptr;
     size_t size=Particle.size();
     DrawBuffer* db = rd->GetDrawBuffer(sVertexXYZDT1::fmt, PT_TRIANGLES, PARTICLE_BUF_LOCK_LEN * 4 * 10);
-    for(int i=size-1;i>=0;i--)
+    //Положение, поворот, цвет и размер считаются одним проходом по частицам,
+    //вывод в буфер и продвижение времени - следующим
+    ParticleDrawBatch& batch=particle_batch;
+    batch.resize(size);
+    for(int i=0;i<size;i++)
     {
-/*		nParticle& p=Particle[i];
-        if(p.key<0)continue;
-        if (NeedPlume)
-            PutPlumeParticle(dtime_global, Bound, texture, plume_texture, 
-                                    mat, p,	pBuf, pos, dtime );
-        const cTextureAviScale::RECT& rt = texture?
-                    ((cTextureAviScale*)texture)->GetFramePos(p.time_summary) :
-                    cTextureAviScale::RECT::ID;	
-        p.PutToBuf(dtime_global, hkeys[p.key], keys[p.key], keys[p.key+1],
-                    Bound, rt, mat, pBuf, this, pos, dtime, p.time, 1.0f, p.htime);
-        ProcessTime(p,dtime,i);
-*/
         nParticle& p=Particle[i];
         if(p.key<0)continue;
-        Vect3f pos;
-        float angle;
-        sColor4f fcolor;
-        float psize;
-
-        float dtime=dtime_global*p.inv_life_time;
 
         {
             HeritKey& k=hkeys[p.hkey];
             float ts=p.htime*k.inv_dtime;
+            Vect3f& pos=batch.pos[i];
             k.Get(pos,ts);
             p.pos.xformPoint(pos);
             Bound.AddBound(pos);
         }
 
         {
-            float& t=p.time;
+            float t=p.time;
             KeyParticleSpl& k0=keys[p.key];
             KeyParticleSpl& k1=keys[p.key+1];
             
             float ts=t*k0.inv_dtime;
-            angle = p.angle0+ p.angle_dir*(k0.angle_vel*t+t*ts*0.5f*(k1.angle_vel-k0.angle_vel));
-            fcolor = k0.color+(k1.color-k0.color)*ts;
-            psize = k0.size+(k1.size-k0.size)*ts;
+            batch.angle[i] = p.angle0+ p.angle_dir*(k0.angle_vel*t+t*ts*0.5f*(k1.angle_vel-k0.angle_vel));
+            batch.color[i] = k0.color+(k1.color-k0.color)*ts;
+            batch.size[i] = (k0.size+(k1.size-k0.size)*ts)*p.begin_size;
         }
+    }
+
+    for(int i=size-1;i>=0;i--)
+    {
+        nParticle& p=Particle[i];
+        if(p.key<0)continue;
+        Vect3f& pos=batch.pos[i];
+        const sColor4f& fcolor=batch.color[i];
+        float psize=batch.size[i];
+
+        float dtime=dtime_global*p.inv_life_time;
 
         //Добавить в массив
         Vect3f sx,sy;
-        Vect2f rot=rotate_angle[(int) xm::round(angle * rotate_angle_size) & rotate_angle_mask];
-        rot*=psize*=p.begin_size;
+        Vect2f rot=rotate_angle[(int) xm::round(batch.angle[i] * rotate_angle_size) & rotate_angle_mask];
+        rot*=psize;
         mat.invXformVect(Vect3f(+rot.x,-rot.y,0),sx);
         mat.invXformVect(Vect3f(+rot.y,+rot.x,0),sy);
 
@@ -1329,7 +1377,7 @@ void cEmitterSpl::Draw(cCamera *pCamera)
                         cTextureAviScale::RECT::ID;	
         if (chPlume)
         {
-            if (ParticlePutToBuf(this, p,pos,dtime,db,v,ib,color,CameraPos,psize, rt, false))
+            if (ParticlePutToBuf(this, p,GetPlumePos(i),pos,dtime,db,v,ib,color,CameraPos,psize, rt, false))
                 continue;
         }
         else 
@@ -1349,7 +1397,7 @@ void cEmitterSpl::Draw(cCamera *pCamera)
 
     db->AutoUnlock();
         
-	Particle.Compress();
+	Particle.Compress([this](int from,int to){MovePlumePos(from,to);});
 	old_time=time;
 }
 
@@ -1602,13 +1650,7 @@ void cEmitterSpl::EmitOne(int ix_cur/*nParticle& cur*/,float begin_time)
 	if (need_transform) 
 		cur.pos= relative ? cur.pos : GetGlobalMatrix()*cur.pos;
 	if (chPlume)
-	{	
-		cur.plume_pos.resize(TraceCount);
-		std::vector<Vect3f>::iterator it;
-		Vect3f bpos = /*GetGlobalMatrix()*/cur.pos.trans();
-		FOR_EACH(cur.plume_pos,it)
-			*it = bpos;
-	}
+		InitPlumePos(ix_cur, /*GetGlobalMatrix()*/cur.pos.trans());
 }
 
 void cEmitterSpl::ProcessTime(nParticle& p,float delta_time,int i)
@@ -1696,12 +1738,13 @@ void cEmitterSpl::DummyQuant()
 
 ////////////////////////cEffect//////////////////////////
 cEffect::cEffect()
-:cIUnkObjScale(0)
+:cIUnkObjScale(KIND_PARTICLE)
 {
 	link.SetParent(this);
 	time=0;
 	auto_delete_after_life=false;
 	particle_rate=1;
+	emitters_animated=false;
 	func_getz=nullptr;
 }
 
@@ -1771,15 +1814,21 @@ void cEffect::PreDraw(cCamera *pCamera)
 		pCamera->Attach(SCENENODE_OBJECTSORT,this);
 }
 
+bool cEffect::bench_draw=false;
+uint64_t cEffect::bench_draw_time=0;
+
 void cEffect::Draw(cCamera *pCamera)
 {
 #ifdef  NEED_TREANGLE_COUNT
 	count_triangle = 0;
 	square_triangle = 0;
 #endif	
+	uint64_t time_start=bench_draw?clock_us():0;
 	std::vector<cEmitterInterface*>::iterator it;
 	FOR_EACH(emitters,it)
 		(*it)->Draw(pCamera);
+	if(bench_draw)
+		bench_draw_time+=clock_us()-time_start;
 }
 
 void cEffect::SetCycled(bool cycled)
@@ -1798,16 +1847,38 @@ bool cEffect::IsCycled()const
 	return false;
 }
 
+void cEffect::AnimateEmitters(float dt,int& emitters_count,int& particles_count)
+{
+	std::vector<cEmitterInterface*>::iterator it;
+	FOR_EACH(emitters,it)
+	{
+		cEmitterInterface* p=*it;
+		if(!p->IsAnimateThreadSafe())
+			continue;
+		bool b=time<p->GetStartTime();
+		p->SetPause(b);
+		p->Animate(dt);
+		emitters_count++;
+		cEmitterBase* base=dynamic_cast<cEmitterBase*>(p);
+		if(base && !b)
+			particles_count+=base->GetParticleCount();
+	}
+	emitters_animated=true;
+}
+
 void cEffect::Animate(float dt)
 {
 	std::vector<cEmitterInterface*>::iterator it;
 	FOR_EACH(emitters,it)
 	{
 		cEmitterInterface* p=*it;
+		if(emitters_animated && p->IsAnimateThreadSafe())
+			continue;
 		bool b=time<p->GetStartTime();
 		p->SetPause(b);
 		p->Animate(dt);
 	}
+	emitters_animated=false;
 
 	time+=dt*1e-3f;
 	if(auto_delete_after_life)
@@ -3442,47 +3513,43 @@ void cEmitterZ::Draw(cCamera *pCamera)
     indices_t* ib = nullptr;
     sVertexXYZDT1 *v = nullptr;
     DrawBuffer* db = rd->GetDrawBuffer(sVertexXYZDT1::fmt, PT_TRIANGLES, PARTICLE_BUF_LOCK_LEN * 4 * 10);
-    for(int i=size-1;i>=0;i--)
+    //Положение, поворот, цвет и размер считаются одним проходом по частицам,
+    //вывод в буфер и продвижение времени - следующим
+    ParticleDrawBatch& batch=particle_batch;
+    batch.resize(size);
+    for(int i=0;i<size;i++)
     {
         nParticle& p=Particle[i];
         if(p.key<0)continue;
-        Vect3f pos;
-        float angle;
-        sColor4f fcolor;
-        float psize;
-
-        float dtime=dtime_global*p.inv_life_time;
-        
         KeyParticleInt& k0=keys[p.key];
         KeyParticleInt& k1=keys[p.key+1];
         
-        float& t=p.time;
+        float t=p.time;
         float ts=t*k0.inv_dtime;
+        Vect3f& pos=batch.pos[i];
         pos.x = p.pos0.x+p.vdir.x*(t*(k0.vel+ts*0.5f*(k1.vel-k0.vel)))+g.x*((p.gvel0+t*k0.gravity*0.5f)*t);
         pos.y = p.pos0.y+p.vdir.y*(t*(k0.vel+ts*0.5f*(k1.vel-k0.vel)))+g.y*((p.gvel0+t*k0.gravity*0.5f)*t);
-/*		if (relative)
-        {
-            Vect3f pp; //word coordinate
-            pos.z=0;
-            pp = GM*pos;
-            pp.z = CalcZ(pp.x,pp.y); 
-            pos = iGM*pp;
-        }
-        else*/ 
-            pos.z = CalcZ(pos.x,pos.y); 
-//		pp.x = (GM.rot().xrow().x*pos.x + GM.rot().xrow().y*pos.y)  +  GM.trans().x;
-//		pp.y = (GM.rot().yrow().x*pos.x + GM.rot().yrow().y*pos.y)  +  GM.trans().y;
-//		pp.z = CalcZ(pp.x,pp.y); 
-//		pos.z = (iGM.rot().zrow().x*pp.x + iGM.rot().zrow().y*pp.y + iGM.rot().zrow().z*pp.z) + iGM.trans().z;
+        pos.z = CalcZ(pos.x,pos.y); 
         Bound.AddBound(pos);
-        angle = p.angle0+ p.angle_dir*(k0.angle_vel*t+t*ts*0.5f*(k1.angle_vel-k0.angle_vel));
-        fcolor = k0.color+(k1.color-k0.color)*ts;
-        psize = k0.size+(k1.size-k0.size)*ts;
+        batch.angle[i] = p.angle0+ p.angle_dir*(k0.angle_vel*t+t*ts*0.5f*(k1.angle_vel-k0.angle_vel));
+        batch.color[i] = k0.color+(k1.color-k0.color)*ts;
+        batch.size[i] = (k0.size+(k1.size-k0.size)*ts)*p.begin_size;
+    }
+
+    for(int i=size-1;i>=0;i--)
+    {
+        nParticle& p=Particle[i];
+        if(p.key<0)continue;
+        Vect3f& pos=batch.pos[i];
+        const sColor4f& fcolor=batch.color[i];
+        float psize=batch.size[i];
+
+        float dtime=dtime_global*p.inv_life_time;
 
         //Добавить в массив
         Vect3f sx,sy;
-        Vect2f rot=rotate_angle[(int) xm::round(angle * rotate_angle_size) & rotate_angle_mask];
-        rot*=psize*=p.begin_size;
+        Vect2f rot=rotate_angle[(int) xm::round(batch.angle[i] * rotate_angle_size) & rotate_angle_mask];
+        rot*=psize;
         if(planar)
         {
             sx.x=+rot.x;
@@ -3503,7 +3570,7 @@ void cEmitterZ::Draw(cCamera *pCamera)
                         cTextureAviScale::RECT::ID;	
         if (chPlume)
         {
-            if (ParticlePutToBuf(this, p,pos,dtime,db,v,ib,color,CameraPos,psize, rt, mode, &iGM))
+            if (ParticlePutToBuf(this, p,GetPlumePos(i),pos,dtime,db,v,ib,color,CameraPos,psize, rt, mode, &iGM))
                 continue;
         }
         else 
@@ -3519,12 +3586,12 @@ void cEmitterZ::Draw(cCamera *pCamera)
                 parent->AddSquareTriangle(psize*psize);
             #endif
         }
-        ProcessTime(p,dtime,i,pos);
+        cEmitterZ::ProcessTime(p,dtime,i,pos);
     }
 
     db->AutoUnlock();
     
-	Particle.Compress();
+	Particle.Compress([this](int from,int to){MovePlumePos(from,to);});
 
 	old_time=time;
 }
@@ -3597,9 +3664,9 @@ void cEmitterZ::EmitOne(int ix_cur/*nParticle& cur*/,float begin_time)
 */
 		}else
 			z = CalcZ(cur.pos0.x,cur.pos0.y);
-		std::vector<Vect3f>::iterator it;
-		FOR_EACH(cur.plume_pos,it)
-			it->z = z;
+		Vect3f* plume=GetPlumePos(ix_cur);
+		for(int i=0;i<TraceCount;i++)
+			plume[i].z = z;
 	}
 }
 
@@ -469,6 +469,9 @@ public:
 
 	virtual void SetFunctorGetZ(FunctorGetZ* func){}
 	virtual void AddZ(float z){}
+
+	//Animate трогает только данные своего эффекта и может идти в рабочем потоке
+	virtual bool IsAnimateThreadSafe(){return true;}
 protected:
 	virtual void DisableEmitProlonged(){}
 	cEffect* parent;
@@ -529,6 +532,11 @@ public:
 	int cur_one_pos;//Индекс в begin_position
 	virtual Vect3f GetVdir(int i)=0;
 protected:
+	//Свой генератор у каждого эмиттера: эмиттеры обновляются из разных потоков,
+	//а зерно зависит только от эффекта, поэтому картинка повторяется при повторе записи
+	RandomGenerator rnd;
+	bool rnd_seeded;
+	void SeedRandom();
 
 	CKey num_particle;
 	CKey begin_size;
@@ -541,6 +549,13 @@ protected:
 	int   TraceCount;
 	float PlumeInterval;
 
+	//Следы всех частиц эмиттера одним массивом, по TraceCount точек на индекс частицы,
+	//чтобы частицы не держали собственных std::vector и копировались простым присваиванием
+	std::vector<Vect3f> plume_pos;
+	Vect3f* GetPlumePos(int ix){return &plume_pos[ix*TraceCount];}
+	void InitPlumePos(int ix,const Vect3f& pos);
+	void MovePlumePos(int from,int to);
+
 	enum 
 	{
 		rotate_angle_size=256,
@@ -602,7 +617,6 @@ public:
 		sColor4c begin_color;
 
 		Vect3f normal;
-		std::vector<Vect3f> plume_pos;
 	};
 protected:
 	BackVector<nParticle>	Particle;
@@ -647,10 +661,9 @@ public:
 	void ResetPlumePos(int ix) override
 	{
 		xassert((uint32_t)ix < Particle.size());
-		nParticle& p = Particle[ix]; 
-		std::vector<Vect3f>::iterator i;
-		FOR_EACH(p.plume_pos,i)
-			*i = p.pos0;
+		if((ix+1)*TraceCount > plume_pos.size())
+			return;
+		InitPlumePos(ix, Particle[ix].pos0);
 	};
 };
 
@@ -718,7 +731,6 @@ class cEmitterSpl:public cEmitterBase
 		//То-же, но для сплайнов
 		int   hkey;
 		float htime;
-		std::vector<Vect3f> plume_pos;
 		MatXf pos;
 		float angle0,angle_dir;
 		//color0,size0 - константы
@@ -760,6 +772,8 @@ public:
 
 	bool IsLive() override {return time<emitter_life_time || cycled;}
 	bool IsVisible(cCamera *pCamera) override {return false;}
+	//Создает и удаляет источник света сцены
+	bool IsAnimateThreadSafe() override {return false;}
 
 	void SetEmitterKey(EmitterKeyLight& k);
 	void SetDummyTime(float t) override {};
@@ -778,6 +792,7 @@ class cEffect:public cIUnkObjScale
 	float time;
 	bool auto_delete_after_life;
 	float particle_rate;
+	bool emitters_animated;
 
 	class EffectObserverLink:protected ObserverLink
 	{
@@ -837,6 +852,10 @@ public:
 	std::vector<Vect3f>& GetNorm(){return normal_position;}
 	cEmitterBase* GetEmitN(int n){xassert((uint32_t)n < emitters.size()); return (cEmitterBase*)emitters[n];}
 	void SetFunctorGetZ(FunctorGetZ* func);//Делается вовремя addref,release
+
+	//Суммарное время Draw эффектов в мкс, считается только во время замера cScene::StartEffectBenchmark
+	static bool bench_draw;
+	static uint64_t bench_draw_time;
 protected:
 #ifdef  NEED_TREANGLE_COUNT
 	int count_triangle;
@@ -851,6 +870,9 @@ public:
 protected:
 	friend class cScene;
 	void Init(EffectKey& el,cEmitter3dObject* models,float scale=1.0f);
+	//Анимация эмиттеров частиц до Animate, эффекты друг от друга не зависят
+	//и могут обновляться параллельно. Источники света и удаление эффекта остаются в Animate
+	void AnimateEmitters(float dt,int& emitters_count,int& particles_count);
 	void Add(cEmitterInterface*);//Предполагается, что эмиттер уже инициализированн
 
 	const MatXf& GetCenter3DModel();
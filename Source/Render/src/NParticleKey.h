@@ -211,7 +211,10 @@ public:
 	int GetIndexFree();
 	void SetFree(int n);
 
-	void Compress();
+	void Compress(){Compress([](int from,int to){});}
+	//move(from,to) вызывается для каждой перенесенной частицы
+	template<class Move>
+	void Compress(Move move);
 };
 
 
@@ -256,7 +259,8 @@ void BackVector<type>::SetFree(int n)
 }
 
 template <class type>
-void BackVector<type>::Compress()
+template <class Move>
+void BackVector<type>::Compress(Move move)
 {
 	if(this->size()<6)
 		return;
@@ -269,7 +273,10 @@ void BackVector<type>::Compress()
 		if((*this)[i].key!=-1)
 		{
 			if(i!=curi)
+			{
 				(*this)[curi]=(*this)[i];
+				move(i,curi);
+			}
 			curi++;
 		}
 	}
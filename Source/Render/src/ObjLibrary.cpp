@@ -8,6 +8,7 @@
 #include "MeshBank.h"
 #include "NParticle.h"
 #include "files/files.h"
+#include "AssetLoader.h"
 
 bool is_old_model=false;
 bool WinVGIsOldModel()
@@ -30,6 +31,19 @@ int ResourceFileRead(const char *fname,char *&buf,int &size)
 	return 0;
 }
 
+//Читает только начало файла, 0 - прочитано size байт
+int ResourceFileReadHeader(const char *fname,void *buf,int size)
+{
+	ZIPStream f;
+	if(!f.open(fname)) {
+	    f.close();
+	    return -1;
+	}
+	int ret=f.size()>=size && f.read(buf,size)==size?0:-1;
+	f.close();
+	return ret;
+}
+
 bool ResourceIsZIP()
 {
 	return ZIPIsOpen();
@@ -200,17 +214,20 @@ cTexture* LoadTextureDef(const char* name,const char* path,const char* def_path,
 	std::string path_name(path);
     path_name += name;
     std::string defpath_name;
+	if(def_path)
+	{
+		defpath_name = def_path;
+		defpath_name += name;
+	}
 
 	bool enable_error=GetTexLibrary()->EnableError(false);
 
-	cTexture *Texture=GetTexLibrary()->GetElement(path_name.c_str(),attr);
+	cTexture *Texture=GetTexLibrary()->GetElementAsync(path_name.c_str(),attr,defpath_name.c_str());
 	if(Texture==nullptr)
 	{
 		if(def_path)
 		{
-            defpath_name = def_path;
-            defpath_name += name;
-			Texture=GetTexLibrary()->GetElement(defpath_name.c_str(),attr);
+			Texture=GetTexLibrary()->GetElementAsync(defpath_name.c_str(),attr);
 		}
 
 		if(Texture==nullptr)
@@ -612,13 +629,33 @@ void cObjLibrary::Compact(FILE* f)
 	MTAuto mtlock(&lock);
 	FreeOne(f);
 	remove_null_element(objects);
+	RebuildIndex();
 }
 
 void cObjLibrary::Free(FILE* f)
 {
 	MTAuto mtlock(&lock);
+	if(cAssetLoader* loader=GetAssetLoader())
+		loader->Clear();
 	FreeOne(f);
 	objects.clear();
+	objects_index.clear();
+	model_paths.clear();
+}
+
+void cObjLibrary::AddObj(cAllMeshBank* bank)
+{
+	objects.push_back(bank);
+	objects_index[convert_path_key(bank->GetFileName())].push_back(bank);
+}
+
+void cObjLibrary::RebuildIndex()
+{
+	objects_index.clear();
+	for(cAllMeshBank* p : objects)
+		objects_index[convert_path_key(p->GetFileName())].push_back(p);
+	//Содержимое ресурсов могло поменяться между миссиями
+	model_paths.clear();
 }
 
 cObjectNodeRoot* cObjLibrary::GetElement(const char* pFileName,const char* pTexturePath)
@@ -627,14 +664,94 @@ cObjectNodeRoot* cObjLibrary::GetElement(const char* pFileName,const char* pText
 	return GetElementInternal(pFileName,pTexturePath,true);
 }
 
-cObjectNodeRoot* cObjLibrary::GetElementInternal(const char* pFileName,const char* pTexturePath,bool enable_error_not_found)
+void cObjLibrary::Prefetch(const char* pFileName)
 {
-	if(!pFileName)
+	cAssetLoader* loader=GetAssetLoader();
+	if(!loader || !pFileName || !pFileName[0])
+		return;
+
+	MTAuto mtlock(&lock);
+	const ModelPath& path=ResolveModelPath(pFileName,nullptr);
+	if(objects_index.count(path.key) || !get_content_entry(pFileName))
+		return;
+	loader->Request(cAssetLoader::ASSET_FILE,path.fname);
+
+	std::string lod=pFileName;
+	size_t pos=lod.rfind('.');
+	if(pos!=std::string::npos)
 	{
-		VISASSERT(0);
-		return NULL;
+		lod.insert(pos,"_lod");
+		if(get_content_entry(lod))
+			loader->Request(cAssetLoader::ASSET_FILE,ResolveModelPath(lod.c_str(),nullptr).fname);
 	}
+}
+
+void cObjLibrary::BenchmarkLookup()
+{
+	MTAuto mtlock(&lock);
+	std::vector<std::string> names,texture_paths;
+	for(cAllMeshBank* p : objects)
+	{
+		names.push_back(p->GetFileName());
+		texture_paths.push_back(p->GetTexturePath());
+	}
+	if(names.empty())
+		return;
+
+	const int rounds=100;
+	int found=0,scanned=0;
+	//Тот же поиск, что в GetElementInternal, кэш путей свой - model_paths не трогаем
+	MODEL_PATHS scratch_paths;
+	uint64_t time_start=clock_us();
+	for(int round=0;round<rounds;round++)
+		for(int i=0;i<names.size();i++)
+		{
+			cAllMeshBank* nearest_bank=NULL;
+			if(FindBank(ResolveModelPath(scratch_paths,names[i].c_str(),texture_paths[i].c_str()),nearest_bank))
+				found++;
+		}
+
+	//Прежний поиск: разбор пути на каждый запрос и перебор всех банков
+	uint64_t time_index=clock_us();
+	for(int round=0;round<rounds;round++)
+		for(int i=0;i<names.size();i++)
+		{
+			ModelPath path;
+			ParseModelPath(names[i].c_str(),texture_paths[i].c_str(),path);
+			for(cAllMeshBank* p : objects)
+				if(stricmp(p->GetFileName(),path.fname.c_str())==0 &&
+					stricmp(p->GetTexturePath(),path.TexturePath.c_str())==0)
+				{
+					scanned++;
+					break;
+				}
+		}
+	uint64_t time_scan=clock_us();
+
+	fprintf(stderr,"Model library bench: %" PRIsize " banks, index %.1f lookups/ms, list scan %.1f lookups/ms, found %i/%i\n",
+		names.size(),
+		names.size()*rounds*1e3/std::max<uint64_t>(time_index-time_start,1),
+		names.size()*rounds*1e3/std::max<uint64_t>(time_scan-time_index,1),
+		found,scanned);
+}
 
+const cObjLibrary::ModelPath& cObjLibrary::ResolveModelPath(MODEL_PATHS& paths,const char* pFileName,const char* pTexturePath)
+{
+	std::string key=convert_path_key(pFileName);
+	key+='|';
+	if(pTexturePath)
+		key+=convert_path_key(pTexturePath);
+	auto it=paths.find(key);
+	if(it!=paths.end())
+		return it->second;
+
+	ModelPath& path=paths[key];
+	ParseModelPath(pFileName,pTexturePath,path);
+	return path;
+}
+
+void cObjLibrary::ParseModelPath(const char* pFileName,const char* pTexturePath,ModelPath& path)
+{
 	std::string fname;
     std::string DefPath;
     std::string TexturePath;
@@ -667,18 +784,42 @@ cObjectNodeRoot* cObjLibrary::GetElementInternal(const char* pFileName,const cha
 		TexturePath=DefPath;
 	}
 
+	path.fname=fname;
+	path.key=convert_path_key(fname);
+	path.TexturePath=TexturePath;
+	path.DefTexturePath=DefTexturePath;
+}
+
+cAllMeshBank* cObjLibrary::FindBank(const ModelPath& path,cAllMeshBank*& nearest_bank)
+{
+	auto found=objects_index.find(path.key);
+	if(found==objects_index.end())
+		return NULL;
+	for(cAllMeshBank* bank : found->second)
+	{
+		nearest_bank=bank;
+		if(stricmp(bank->GetTexturePath(),path.TexturePath.c_str())==0)
+			return bank;
+	}
+	return NULL;
+}
+
+cObjectNodeRoot* cObjLibrary::GetElementInternal(const char* pFileName,const char* pTexturePath,bool enable_error_not_found)
+{
+	if(!pFileName)
+	{
+		VISASSERT(0);
+		return NULL;
+	}
+
+	const ModelPath& path=ResolveModelPath(pFileName,pTexturePath);
+	const std::string& fname=path.fname;
+	const std::string& TexturePath=path.TexturePath;
+	const std::string& DefTexturePath=path.DefTexturePath;
+
 	cAllMeshBank* nearest_bank=NULL;
-	for(int i=0;i<GetNumberObj();i++) {
-        if (stricmp(GetObj(i)->GetFileName(), fname.c_str()) == 0) {
-            cAllMeshBank* bank = GetObj(i);
-            nearest_bank = bank;
-
-            if (stricmp(bank->GetTexturePath(), TexturePath.c_str()) == 0) {
-                cObjectNodeRoot* tmp = (cObjectNodeRoot*) bank->root->BuildCopy();
-                return tmp;
-            }
-        }
-    }
+	if(cAllMeshBank* bank=FindBank(path,nearest_bank))
+		return (cObjectNodeRoot*) bank->root->BuildCopy();
 
 	cAllMeshBank *ObjNode=NULL;
 	cAllMeshBank *ObjNodeLod=NULL;
@@ -701,9 +842,9 @@ cObjectNodeRoot* cObjLibrary::GetElementInternal(const char* pFileName,const cha
 	cObjectNodeRoot *tmp=NULL;
 	if(ObjNode)
 	{
-		objects.push_back(ObjNode); 
+		AddObj(ObjNode);
 		if(ObjNodeLod)
-			objects.push_back(ObjNodeLod); 
+			AddObj(ObjNodeLod);
 		tmp=(cObjectNodeRoot*)ObjNode->root->BuildCopy(); 
 	}
 	return tmp;
@@ -773,7 +914,8 @@ cAllMeshBank* cObjLibrary::LoadM3D(const char *fname,const char *TexturePath,con
 	int size=0;
 	char *buf=0;
 
-	if(ResourceFileRead(fname,buf,size))
+	cAssetLoader* loader=GetAssetLoader();
+	if((!loader || !loader->TakeFile(fname,buf,size)) && ResourceFileRead(fname,buf,size))
 	{
 		if(enable_error_not_found)
 			m3derror()<<"File not found "<<VERR_END;
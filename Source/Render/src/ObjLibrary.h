@@ -14,11 +14,36 @@ public:
 	virtual void Free(FILE* f=NULL);
 	virtual void Compact(FILE* f=NULL);
 	virtual cObjectNodeRoot* GetElement(const char* pFileName,const char* pTexturePath);
+	//Начинает фоновое чтение файла модели и ее lod
+	void Prefetch(const char* pFileName);
+	//Печатает скорость поиска загруженных моделей по индексу и перебором,
+	//путь разбирается как в GetElement, но в отдельном кэше
+	void BenchmarkLookup();
 
 	MTSection* GetLock(){return &lock;}
 private:
 	typedef std::vector<cAllMeshBank*> OBJECTS;
 	OBJECTS objects;
+	//Банки по имени файла модели в порядке загрузки
+	std::unordered_map<std::string, OBJECTS> objects_index;
+
+	//Результат разбора пути модели и пути текстур для запроса
+	struct ModelPath
+	{
+		std::string fname;
+		std::string key;
+		std::string TexturePath;
+		std::string DefTexturePath;
+	};
+	typedef std::unordered_map<std::string, ModelPath> MODEL_PATHS;
+	MODEL_PATHS model_paths;
+	static void ParseModelPath(const char* pFileName,const char* pTexturePath,ModelPath& path);
+	static const ModelPath& ResolveModelPath(MODEL_PATHS& paths,const char* pFileName,const char* pTexturePath);
+	const ModelPath& ResolveModelPath(const char* pFileName,const char* pTexturePath)	{ return ResolveModelPath(model_paths,pFileName,pTexturePath); }
+	//Банк с нужными текстурами или NULL, nearest_bank - последний банк той же модели
+	cAllMeshBank* FindBank(const ModelPath& path,cAllMeshBank*& nearest_bank);
+	void AddObj(cAllMeshBank* bank);
+	void RebuildIndex();
 	cAllMeshBank* LoadM3D(const char *fname,const char *TexturePath,const char *DefTexturePath,bool enable_error_not_found);
 	inline int GetNumberObj()									{ return objects.size(); }
 	inline cAllMeshBank* GetObj(int number)						{ return objects[number]; }
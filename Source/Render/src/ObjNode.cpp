@@ -693,6 +693,21 @@ void cObjectNodeRoot::PreDraw(cCamera *DrawNode)
 	if(!DrawNode->TestVisible(GetGlobalMatrix(),GlobalBound.min,GlobalBound.max) )
 		return;
 
+	PreDrawVisible(DrawNode);
+}
+
+bool cObjectNodeRoot::PreDrawPrepare(cCamera *DrawNode)
+{
+	VISASSERT(observer.empty());
+	if(!DrawNode->TestVisible(GetGlobalMatrix(),GlobalBound.min,GlobalBound.max) )
+		return false;
+
+	Update();
+	return true;
+}
+
+void cObjectNodeRoot::PreDrawVisible(cCamera *DrawNode)
+{
 	DrawNode->AttachTestShadow(this);
 	Update();
 
@@ -243,6 +243,13 @@ public:
 	void SetPosition(const MatXf& Matrix) override;
 	void Animate(float dt) override;
 	void PreDraw(cCamera *DrawNode) override;
+	//PreDraw разделенный на две части, PreDrawPrepare не трогает ничего кроме самого объекта
+	//и может вызываться для разных объектов из нескольких потоков. Возвращает видимость.
+	bool PreDrawPrepare(cCamera *DrawNode);
+	void PreDrawVisible(cCamera *DrawNode);
+	//Пока есть связи PreDraw двигает другие объекты и должен идти по порядку
+	bool HasLinks() { return !observer.empty(); }
+	bool IsMatrixChanged() { return NodeAttribute.GetAttribute(ATTRNODE_UPDATEMATRIX)!=0; }
 	void GetLocalBorder(int *nVertex,Vect3f **Vertex,int *nIndex,short **Index) override;
 	
 	virtual const Vect3f& GetScale() const		{ return Scale; }
@@ -601,6 +601,14 @@ void cInterfaceRenderDevice::DrawPoint(const Vect3f &v1, const sColor4c& color)
 void cInterfaceRenderDevice::FlushPrimitive3D() {
 }
 
+// Mesh draw
+
+void cInterfaceRenderDevice::DrawNoMaterialMeshInstances(cObjMesh** meshes, size_t count, sDataRenderMaterial* data) {
+    for (size_t i = 0; i < count; ++i) {
+        DrawNoMaterialMesh(meshes[i], data);
+    }
+}
+
 // Other render functions
 
 void cInterfaceRenderDevice::DrawScene(class cScene *Scene) {
@@ -9,10 +9,12 @@
 #include "ObjNode.h"
 #include "SpriteNode.h"
 #include "Line3d.h"
+#include "NParticle.h"
 #include "ObjLibrary.h"
 #include "cPlane.h"
 #include "CChaos.h"
 #include "../client/Silicon.h"
+#include "xjobs.h"
 
 FILE *gb_fSceneLog=NULL;
 
@@ -30,6 +32,13 @@ cScene::cScene() : cUnknownClass(KIND_SCENE)
 	StrencilShadowDrawNode=CreateCamera();
 	ReflectionDrawNode=CreateCamera();
 	disable_tilemap_visible_test=false;
+	predraw_culled=0;
+
+	effect_bench_request=0;
+	effect_bench_frames=effect_bench_left=0;
+	effect_bench_parallel=1;
+	effect_bench_particles=0;
+	effect_bench_animate_time=effect_bench_draw_time=0;
 }
 cScene::~cScene()
 {
@@ -123,6 +132,9 @@ void cScene::Animate()
 
     //Iterate objects
     grid.DisableChanges(true);
+	uint64_t animate_start=clock_us();
+	AnimateEffects(dTime);
+	EffectBenchmarkFrame(clock_us()-animate_start);
 	for (auto el : grid) {
 #ifdef MTGVECTOR_USE_HANDLES
         cIUnkClass* p = safe_cast<cIUnkClass*>(el->Get());
@@ -157,12 +169,99 @@ void cScene::Animate()
         }
     }
     UnkLightArray.DisableChanges(false);
-	BuildTree();
+	UpdateObjectGrid();
 	CaclulateLightAmbient();
 
 	PreviousTime=CurrentTime;
 }
 
+void cScene::AnimateEffects(float dTime)
+{
+	//Эмиттеры одного эффекта ссылаются друг на друга (other),
+	//поэтому параллельно обновляются эффекты целиком
+	const int PARALLEL_CHUNK=4;
+	const int PARALLEL_MIN=8;
+
+	int threads=parallel_threads();
+	animate_emitters.assign(threads,0);
+	animate_particles.assign(threads,0);
+
+	animate_effects.clear();
+	for (auto el : grid) {
+#ifdef MTGVECTOR_USE_HANDLES
+        cIUnkClass* p = safe_cast<cIUnkClass*>(el->Get());
+#else
+        cIUnkClass* p = el;
+#endif
+		if(p && p->GetKind()==KIND_PARTICLE && p->GetAttr(ATTRUNKOBJ_IGNORE)==0)
+			animate_effects.push_back(p);
+	}
+
+	int count=animate_effects.size();
+	if(!Option_ParallelEffects || count<PARALLEL_MIN)
+	{
+		for(int i=0;i<count;i++)
+			safe_cast<cEffect*>(animate_effects[i])->AnimateEmitters(dTime,animate_emitters[0],animate_particles[0]);
+		return;
+	}
+
+	int chunks=(count+PARALLEL_CHUNK-1)/PARALLEL_CHUNK;
+	parallel_for(chunks,[this,dTime,count](int chunk) {
+		int thread=parallel_thread_index();
+		int end=std::min(count,(chunk+1)*PARALLEL_CHUNK);
+		for(int i=chunk*PARALLEL_CHUNK;i<end;i++)
+			safe_cast<cEffect*>(animate_effects[i])->AnimateEmitters(dTime,animate_emitters[thread],animate_particles[thread]);
+	});
+}
+
+void cScene::StartEffectBenchmark(int frames)
+{
+	effect_bench_request=frames;
+}
+
+void cScene::EffectBenchmarkFrame(uint64_t animate_time)
+{
+	//Первые кадры пропускаются, пока эффекты набирают частицы
+	const int WARMUP_FRAMES=30;
+	int request=effect_bench_request.exchange(0);
+	if(request>0)
+	{
+		effect_bench_frames=request;
+		effect_bench_left=WARMUP_FRAMES+request*2;
+		effect_bench_parallel=Option_ParallelEffects;
+		Option_ParallelEffects=1;
+		return;
+	}
+	if(effect_bench_left<=0)
+		return;
+
+	//Draw эффектов предыдущего кадра прошел между вызовами Animate
+	if(effect_bench_left<=effect_bench_frames*2)
+	{
+		int particles=0;
+		for(int t=0;t<animate_particles.size();t++)
+			particles+=animate_particles[t];
+		effect_bench_particles+=particles;
+		effect_bench_animate_time+=animate_time;
+		effect_bench_draw_time+=cEffect::bench_draw_time;
+	}
+	cEffect::bench_draw_time=0;
+	effect_bench_left--;
+	cEffect::bench_draw=effect_bench_left>0;
+
+	if(effect_bench_left==effect_bench_frames || effect_bench_left==0)
+	{
+		double frames=effect_bench_frames;
+		fprintf(stderr,"Effect bench: parallel %s, %d effects, %.0f particles, animate %.3f ms %.1f particles/ms, draw %.3f ms %.1f particles/ms per frame\n",
+			Option_ParallelEffects?"on":"off",(int)animate_effects.size(),effect_bench_particles/frames,
+			effect_bench_animate_time*1e-3/frames,effect_bench_particles*1e3/std::max<uint64_t>(effect_bench_animate_time,1),
+			effect_bench_draw_time*1e-3/frames,effect_bench_particles*1e3/std::max<uint64_t>(effect_bench_draw_time,1));
+		effect_bench_particles=0;
+		effect_bench_animate_time=effect_bench_draw_time=0;
+		Option_ParallelEffects=effect_bench_left?0:effect_bench_parallel;
+	}
+}
+
 void cScene::SetTime(double Time)
 { 
 	PreviousTime=CurrentTime; 
@@ -193,8 +292,10 @@ void cScene::PreDraw(cCamera *DrawNode)
 void cScene::Draw(cCamera *DrawNode)
 {
 	MTEnter enter(lock_draw);
+	object_grid.ClearStatistics();
 	//PreDraw
 	UpdateLists(gb_VisGeneric->GetGraphLogicQuant());
+	GetTexLibrary()->UpdateStreaming();
 	VISASSERT(DrawNode->GetScene()==this);
 	Animate();
 	int i;
@@ -216,16 +317,7 @@ void cScene::Draw(cCamera *DrawNode)
 	}
 
     grid.DisableChanges(true);
-    for (auto el : grid) {
-#ifdef MTGVECTOR_USE_HANDLES
-        cIUnkClass* obj = safe_cast<cIUnkClass*>(el->Get());
-#else
-        cIUnkClass* obj = el;
-#endif
-        if (obj&&obj->GetAttr(ATTRUNKOBJ_IGNORE)==0) {
-            obj->PreDraw(DrawNode);
-        }
-    }
+    PreDrawObjects(DrawNode);
     grid.DisableChanges(false);
 
     UnkLightArray.DisableChanges(true);
@@ -247,6 +339,111 @@ void cScene::Draw(cCamera *DrawNode)
 	DrawNode->DrawScene();
 
 	gb_RenderDevice->SetClipRect(0,0,gb_RenderDevice->GetSizeX(),gb_RenderDevice->GetSizeY());
+
+	if(Option_DrawNumberPolygon && TileMap)
+	{
+		char str[256];
+		sprintf(str,"scene grid: objects=%d moved=%d cells visited=%d objects tested=%d culled=%d",
+			object_grid.GetNumberObject(),object_grid.GetObjectsMoved(),
+			object_grid.GetCellsVisited(),object_grid.GetObjectsTested(),predraw_culled);
+		gb_RenderDevice->OutText(10,120,str,sColor4f(1,1,1,1));
+	}
+
+	if(Option_DrawNumberPolygon)
+	{
+		char str[256];
+		int len=sprintf(str,"effects=%d emitters/particles per thread:",(int)animate_effects.size());
+		for(int t=0;t<animate_emitters.size() && len<sizeof(str)-32;t++)
+			len+=sprintf(str+len," %d/%d",animate_emitters[t],animate_particles[t]);
+		gb_RenderDevice->OutText(10,140,str,sColor4f(1,1,1,1));
+	}
+}
+
+enum ePreDrawState
+{
+	PREDRAW_SEQUENTIAL,	//обычный PreDraw
+	PREDRAW_HIDDEN,		//подготовлен, не видим
+	PREDRAW_VISIBLE,	//подготовлен, видим
+};
+
+void cScene::PreDrawObjects(cCamera *DrawNode)
+{
+	//Меньше этого потоки не окупаются
+	const int PARALLEL_MIN_OBJECTS=256;
+	const int PARALLEL_CHUNK=64;
+
+	//Модели в невидимых ячейках сетки пропускаются, кроме тех к которым привязаны другие объекты
+	bool cull=Option_SceneGridCulling && TileMap;
+	if(cull)
+		object_grid.Cull(DrawNode);
+	predraw_culled=0;
+
+	predraw_objects.clear();
+    for (auto el : grid) {
+#ifdef MTGVECTOR_USE_HANDLES
+        cIUnkClass* obj = safe_cast<cIUnkClass*>(el->Get());
+#else
+        cIUnkClass* obj = el;
+#endif
+        if (obj&&obj->GetAttr(ATTRUNKOBJ_IGNORE)==0) {
+            predraw_objects.push_back(obj);
+        }
+    }
+
+	int count=predraw_objects.size();
+	predraw_state.assign(count,PREDRAW_SEQUENTIAL);
+
+	//Проверка видимости и расчет матриц узлов моделей не зависят друг от друга и идут параллельно,
+	//все добавления в массивы камеры делаются потом в порядке grid, как и раньше
+	if(Option_ParallelPreDraw && count>=PARALLEL_MIN_OBJECTS)
+	{
+		int chunks=(count+PARALLEL_CHUNK-1)/PARALLEL_CHUNK;
+		parallel_for(chunks,[this,DrawNode,count,cull](int chunk) {
+			int end=std::min(count,(chunk+1)*PARALLEL_CHUNK);
+			for(int i=chunk*PARALLEL_CHUNK;i<end;i++)
+			{
+				cIUnkClass* obj=predraw_objects[i];
+				if(obj->GetKind()!=KIND_OBJ_NODE_ROOT)
+					continue;
+				cObjectNodeRoot* root=static_cast<cObjectNodeRoot*>(obj);
+				if(root->HasLinks() || (cull && object_grid.IsCulled(root)))
+					continue;
+				predraw_state[i]=root->PreDrawPrepare(DrawNode)?PREDRAW_VISIBLE:PREDRAW_HIDDEN;
+			}
+		});
+	}
+
+	for(int i=0;i<count;i++)
+	{
+		cIUnkClass* obj=predraw_objects[i];
+		uint8_t state=predraw_state[i];
+		if(state!=PREDRAW_SEQUENTIAL)
+		{
+			cObjectNodeRoot* root=static_cast<cObjectNodeRoot*>(obj);
+			//Сдвинут PreDraw другого объекта после подготовки
+			if(root->IsMatrixChanged())
+				state=PREDRAW_SEQUENTIAL;
+		}
+
+		switch(state)
+		{
+		case PREDRAW_SEQUENTIAL:
+			if(cull && obj->GetKind()==KIND_OBJ_NODE_ROOT)
+			{
+				cObjectNodeRoot* root=static_cast<cObjectNodeRoot*>(obj);
+				if(!root->HasLinks() && object_grid.IsCulled(root))
+				{
+					predraw_culled++;
+					break;
+				}
+			}
+			obj->PreDraw(DrawNode);
+			break;
+		case PREDRAW_VISIBLE:
+			static_cast<cObjectNodeRoot*>(obj)->PreDrawVisible(DrawNode);
+			break;
+		}
+	}
 }
 
 void cScene::PostDraw(cCamera *Camera)
@@ -489,6 +686,7 @@ cTileMap* cScene::CreateMap(TerraInterface* terra,int zeroplastnumber)
 	cScene::Size=Vect2i(terra->SizeX(),terra->SizeY());
 	TileMap=new cTileMap(this,terra);
 	TileMap->SetBuffer(cScene::Size,zeroplastnumber);
+	object_grid.Init(Size.x,Size.y);
 
 	TileNumber=TileMap->GetTileNumber();
 	tile_size=TileMap->GetTileSize().x;
@@ -635,38 +833,24 @@ void cScene::AddReflectionCamera(cCamera *DrawNode)
 
 }
 
-void cScene::BuildTree()
+void cScene::UpdateObjectGrid()
 {
-	if(TileMap) {
-		tree.clear();
-
-		bool is_spherical=false;
-		for(int i=0;i<GetNumberLight();i++)
-		{
-			cUnkLight* ULight=GetLight(i);
-			if(ULight && ULight->GetAttr(ATTRLIGHT_SPHERICAL))
-			{
-				is_spherical=true;
-			}
-		}
+	if(!TileMap)
+		return;
 
-		if(is_spherical) {
-			std::vector<cIUnkClass*> nodes;
-			for (auto el : grid) {
+	//Сетка живет между кадрами, пересчитываются только сдвинувшиеся модели
+	object_grid.BeginUpdate();
+	for (auto el : grid) {
 #ifdef MTGVECTOR_USE_HANDLES
-                cUnknownClass* unk = el->Get();
+		cUnknownClass* unk = el->Get();
 #else
-                cUnknownClass* unk = el;
+		cUnknownClass* unk = el;
 #endif
-				if (unk && unk->GetKind()==KIND_OBJ_NODE_ROOT) {
-                    cIUnkClass* obj = safe_cast<cIUnkClass*>(unk);
-                    nodes.push_back(obj);
-                }
-			}
-
-			tree.build(0,0,Size.x,Size.y,nodes);
+		if (unk && unk->GetKind()==KIND_OBJ_NODE_ROOT) {
+			object_grid.Update(safe_cast<cIUnkClass*>(unk));
 		}
 	}
+	object_grid.EndUpdate();
 }
 
 struct SceneLightProcParam
@@ -718,7 +902,7 @@ void cScene::CaclulateLightAmbient()
 			p.color=ULight->GetDiffuse();
 			p.color*=2;
 
-			tree.find(Vect2i(p.pos.x,p.pos.y),p.radius * 3.5f,SceneLightProc,&p);
+			object_grid.find(Vect2i(p.pos.x,p.pos.y),p.radius * 3.5f,SceneLightProc,&p);
 		}
 	}
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include "UnkLight.h"
 #include "cPlane.h"
 #include "NParticle.h"
@@ -109,14 +110,20 @@ public:
 	*/
 
     SDL_mutex* GetLockDraw(){return lock_draw;}
+
+	//Печатает частицы в мс для обновления и отрисовки эффектов сцены за frames кадров
+	//с параллельным обновлением эмиттеров и столько же без него. Можно звать из логики
+	void StartEffectBenchmark(int frames);
 private:
 	void Animate();
+	void AnimateEffects(float dTime);
+	void PreDrawObjects(cCamera *DrawNode);
 	cObjLibrary			*ObjLibrary;				// библиотека 3d-объектов
 	double				CurrentTime,PreviousTime;	// текущее и предыдущее время
 	Vect2i				Size;						// размер мира
 	MTGVector			UnkLightArray;				// массив источников света сцены
     MTGVector			grid;
-	QuatTree			tree;
+	SceneObjectGrid		object_grid;				// сетка моделей для источников света и отсечения
 
 	class cTileMap *TileMap;
 
@@ -129,10 +136,31 @@ private:
 
 	bool disable_tilemap_visible_test;
 
+	//Объекты grid на текущем кадре и результат параллельной подготовки PreDraw
+	std::vector<cIUnkClass*> predraw_objects;
+	std::vector<uint8_t> predraw_state;
+	int predraw_culled;
+
+	//Эффекты текущего кадра, эмиттеры которых обновляются параллельно,
+	//и счетчики обновленных эмиттеров и частиц по потокам
+	std::vector<cIUnkClass*> animate_effects;
+	std::vector<int> animate_emitters;
+	std::vector<int> animate_particles;
+
+	//Замер эффектов: запрос из потока логики, остаток кадров и суммы за половину замера
+	std::atomic<int> effect_bench_request;
+	int effect_bench_frames;
+	int effect_bench_left;
+	int effect_bench_parallel;
+	int64_t effect_bench_particles;
+	uint64_t effect_bench_animate_time;
+	uint64_t effect_bench_draw_time;
+	void EffectBenchmarkFrame(uint64_t animate_time);
+
 	void AddStrencilCamera(cCamera *DrawNode);
 	void AddReflectionCamera(cCamera *DrawNode);
 
-	void BuildTree();
+	void UpdateObjectGrid();
 	void CaclulateLightAmbient();
 	void UpdateLists(int cur_quant);
 };
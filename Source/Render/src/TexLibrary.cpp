@@ -1,6 +1,7 @@
 #include "StdAfxRD.h"
 #include "FileImage.h"
 #include "files/files.h"
+#include "AssetLoader.h"
 
 #ifdef PERIMETER_D3D9
 #ifdef _WIN32
@@ -29,6 +30,73 @@ struct BeginNF
 static BeginNF begin_nf;
 #endif //TEXTURE_NOTFREE
 
+//Сколько загруженных в фоне текстур создавать за кадр
+static const int STREAMING_TEXTURES_PER_FRAME=8;
+
+//Белая непрозрачная картинка, временно заменяет грузящуюся в фоне текстуру
+class cPlaceholderImage : public cFileImage
+{
+public:
+	cPlaceholderImage(int size)
+	{
+		x=y=size;
+		bpp=32;
+		length=1;
+	}
+
+	int GetTextureAlpha(void *pointer,int time,int bpp,int bpl,int aBitCount,int aBitShift,int xSize,int ySize) override
+	{
+		Fill(pointer,bpp,bpl,((1u<<aBitCount)-1)<<aBitShift,xSize,ySize);
+		return 0;
+	}
+
+	int GetTextureRGB(void *pointer,int time,int bpp,int bpl,
+		int rBitCount,int gBitCount,int bBitCount,
+		int rBitShift,int gBitShift,int bBitShift,
+		int xSize,int ySize) override
+	{
+		uint32_t mask=(((1u<<rBitCount)-1)<<rBitShift)|(((1u<<gBitCount)-1)<<gBitShift)|(((1u<<bBitCount)-1)<<bBitShift);
+		Fill(pointer,bpp,bpl,mask,xSize,ySize);
+		return 0;
+	}
+protected:
+	void Fill(void *pointer,int bpp,int bpl,uint32_t mask,int xSize,int ySize)
+	{
+		if(xSize<0) xSize=x;
+		if(ySize<0) ySize=y;
+		for(int j=0;j<ySize;j++)
+		{
+			uint8_t* line=(uint8_t*)pointer+j*bpl;
+			for(int i=0;i<xSize;i++)
+			{
+				uint32_t value;
+				memcpy(&value,line+i*bpp,bpp);
+				value|=mask;
+				memcpy(line+i*bpp,&value,bpp);
+			}
+		}
+	}
+};
+
+static void ClearFrames(cTexture* Texture)
+{
+	for (auto frame : Texture->frames)
+	{
+#ifdef PERIMETER_D3D9
+        if (gb_RenderDevice->GetRenderSelection() == DEVICE_D3D9 && frame.d3d) {
+            frame.d3d->Release();
+        }
+#endif
+#ifdef PERIMETER_SOKOL
+        if (gb_RenderDevice->GetRenderSelection() == DEVICE_SOKOL) {
+            delete frame.sg;
+        }
+#endif
+        frame.ptr = nullptr;
+	}
+	Texture->frames.clear();
+}
+
 cTexLibrary* GetTexLibrary()
 {
 	return gb_RenderDevice->GetTexLibrary();
@@ -94,12 +162,49 @@ void cTexLibrary::Compact(FILE* f)
 {
 	FreeOne(f);
 	remove_null_element(textures);
+	RebuildIndex();
 }
 
 void cTexLibrary::Free(FILE* f)
 {
+	for(StreamingTexture& s : streaming)
+		s.texture->Release();
+	streaming.clear();
+	if(cAssetLoader* loader=GetAssetLoader())
+		loader->Clear();
 	FreeOne(f);
 	textures.clear();
+	texture_index.clear();
+}
+
+cTexture* cTexLibrary::FindTexture(const std::string& key)
+{
+	auto it=texture_index.find(key);
+	if(it==texture_index.end())
+		return nullptr;
+	cTexture* cur=it->second;
+	xassert(cur->GetX()>=0 && cur->GetX()<=15);
+	xassert(cur->GetY()>=0 && cur->GetY()<=15);
+	cur->IncRef();
+	return cur;
+}
+
+void cTexLibrary::AddTexture(cTexture* Texture)
+{
+	textures.push_back(Texture); Texture->IncRef();
+	//Имя могло поменяться при загрузке (_normal вместо _bump), индексируем итоговое
+	if(Texture->GetName() && Texture->GetName()[0])
+		texture_index.emplace(convert_path_key(Texture->GetName()),Texture);
+}
+
+void cTexLibrary::RebuildIndex()
+{
+	texture_index.clear();
+	for(cTexture* p : textures)
+	{
+		if(p && p->GetName() && p->GetName()[0])
+			texture_index.emplace(convert_path_key(p->GetName()),p);
+	}
 }
 
 cTexture* cTexLibrary::CreateRenderTexture(int width, int height, uint32_t attr, bool enable_assert)
@@ -161,17 +266,8 @@ cTexture* cTexLibrary::GetElementAviScale(const char* TextureName,const char *pM
 	MTAuto mtenter(&lock);
 	if(TextureName==0||TextureName[0]==0) return 0; // имя текстуры пустое
 
-	for(int i=0;i<GetNumberTexture();i++)
-	{
-		cTexture* cur=GetTexture(i);
-		xassert(cur->GetX()>=0 && cur->GetX()<=15);
-		xassert(cur->GetY()>=0 && cur->GetY()<=15);
-		if( cur && stricmp(cur->GetName(),TextureName)==0)
-		{
-			cur->IncRef();
-			return cur;
-		}
-	}
+	if(cTexture* cur=FindTexture(convert_path_key(TextureName)))
+		return cur;
 
 	cAviScaleFileImage avi_images;
 	std::string fName = TextureName;
@@ -190,7 +286,7 @@ cTexture* cTexLibrary::GetElementAviScale(const char* TextureName,const char *pM
 		return NULL;
 	}
 
-	textures.push_back(Texture); Texture->IncRef();
+	AddTexture(Texture);
 	return Texture;
 }
 
@@ -200,17 +296,8 @@ cTexture* cTexLibrary::GetElement(const char* TextureName,const char *pMode)
 	if(TextureName==nullptr||TextureName[0]==0) return nullptr; // имя текстуры пустое
     std::string path = convert_path_native(TextureName);
 
-	for(int i=0;i<GetNumberTexture();i++)
-	{
-		cTexture* cur=GetTexture(i);
-		xassert(cur->GetX()>=0 && cur->GetX()<=15);
-		xassert(cur->GetY()>=0 && cur->GetY()<=15);
-		if( cur && stricmp(cur->GetName(),path.c_str())==0)
-		{
-			cur->IncRef();
-			return cur;
-		}
-	}
+	if(cTexture* cur=FindTexture(convert_path_key(path)))
+		return cur;
 
 	cTexture *Texture=new cTexture(path.c_str());
 
@@ -219,11 +306,170 @@ cTexture* cTexLibrary::GetElement(const char* TextureName,const char *pMode)
 		return nullptr;
 	}
 
-	textures.push_back(Texture); Texture->IncRef();
+	AddTexture(Texture);
 	return Texture;
 }
 
-bool cTexLibrary::LoadTexture(cTexture* Texture,const char *pMode)
+cTexture* cTexLibrary::GetElementAsync(const char* TextureName,const char *pMode,const char *pDefTextureName)
+{
+	MTAuto mtenter(&lock);
+	cAssetLoader* loader=GetAssetLoader();
+	if(!loader || TextureName==nullptr || TextureName[0]==0)
+		return GetElement(TextureName,pMode);
+	std::string path = convert_path_native(TextureName);
+
+	if(cTexture* cur=FindTexture(convert_path_key(path)))
+		return cur;
+
+	//Видео, bump и отсутствующие файлы требуют особой обработки в ReLoadTexture
+	if(endsWith(path, ".avi") || endsWith(path, ".avix") || !get_content_entry(path))
+		return GetElement(path.c_str(),pMode);
+
+	cTexture *Texture=new cTexture(path.c_str());
+	SetupTexture(Texture,pMode);
+	std::string content=convert_path_content(Texture->GetName());
+	//Атрибуты прозрачности копируются в материалы банков при загрузке модели,
+	//поэтому их надо знать до заглушки - глубину берем из заголовка файла
+	int bpp=content.empty()?-1:cFileImage::PeekBitPerPixel(content);
+	if(Texture->GetAttribute(MAT_BUMP) || bpp<0 || !CreatePlaceholder(Texture))
+	{
+		delete Texture;
+		return GetElement(path.c_str(),pMode);
+	}
+	if(bpp==32)
+		Texture->SetAttribute(TEXTURE_ALPHA_BLEND);
+
+	StreamingTexture s;
+	s.texture=Texture;
+	s.path=content;
+	if(pDefTextureName && pDefTextureName[0])
+	{
+		std::string def_path=convert_path_native(pDefTextureName);
+		if(get_content_entry(def_path))
+			s.def_path=convert_path_content(def_path);
+	}
+	s.mipmap=Texture->GetNumberMipMap();
+	loader->Request(cAssetLoader::ASSET_IMAGE,content);
+	Texture->SetNumberMipMap(1);
+	streaming.push_back(s);
+	Texture->IncRef();
+
+	AddTexture(Texture);
+	return Texture;
+}
+
+bool cTexLibrary::CreatePlaceholder(cTexture* Texture)
+{
+	const int size=4;
+	int mipmap=Texture->GetNumberMipMap();
+	cPlaceholderImage image(size);
+	ClearFrames(Texture);
+	Texture->SetNumberMipMap(1);
+	Texture->New(1);
+	Texture->SetTimePerFrame(0);
+	Texture->SetWidth(size);
+	Texture->SetHeight(size);
+	int err=gb_RenderDevice->CreateTexture(Texture,&image);
+	Texture->SetNumberMipMap(mipmap);
+	return err==0;
+}
+
+static cFileImage* LoadFileImage(const std::string& path)
+{
+	cFileImage* FileImage=cFileImage::Create(path);
+	if(FileImage && FileImage->load(path.c_str()))
+	{
+		delete FileImage;
+		FileImage=nullptr;
+	}
+	return FileImage;
+}
+
+void cTexLibrary::UpdateStreaming()
+{
+	MTAuto mtenter(&lock);
+	cAssetLoader* loader=GetAssetLoader();
+	int created=0;
+	for(int i=0;i<streaming.size() && created<STREAMING_TEXTURES_PER_FRAME;)
+	{
+		StreamingTexture& s=streaming[i];
+		if(loader && !loader->IsReady(cAssetLoader::ASSET_IMAGE,s.path))
+		{
+			i++;
+			continue;
+		}
+
+		cTexture* Texture=s.texture;
+		cFileImage* FileImage=loader?loader->TakeImage(s.path):nullptr;
+		//Фоновую загрузку выключили или она не удалась - грузим сразу,
+		//затем картинку по умолчанию, как LoadTextureDef
+		if(!FileImage)
+			FileImage=LoadFileImage(s.path);
+		if(!FileImage && !s.def_path.empty())
+			FileImage=LoadFileImage(s.def_path);
+
+		Texture->SetNumberMipMap(s.mipmap);
+		if(FileImage)
+		{
+			if(CreateFromImage(Texture,FileImage))
+			{
+				Error(Texture);
+				CreatePlaceholder(Texture);
+			}
+			delete FileImage;
+			created++;
+		}else
+		{
+			//Картинка не загрузилась, текстура остается белой
+			Error(Texture);
+		}
+
+		Texture->Release();
+		streaming.erase(streaming.begin()+i);
+	}
+}
+
+void cTexLibrary::BenchmarkLookup()
+{
+	MTAuto mtenter(&lock);
+	std::vector<std::string> names;
+	for(cTexture* p : textures)
+		if(p && p->GetName() && p->GetName()[0])
+			names.push_back(p->GetName());
+	if(names.empty())
+		return;
+
+	//Как в GetElement: путь приводится к ключу на каждый запрос
+	const int rounds=100;
+	int found=0,scanned=0;
+	uint64_t time_start=clock_us();
+	for(int round=0;round<rounds;round++)
+		for(const std::string& name : names)
+			if(cTexture* cur=FindTexture(convert_path_key(convert_path_native(name.c_str()))))
+			{
+				cur->Release();
+				found++;
+			}
+
+	uint64_t time_index=clock_us();
+	for(int round=0;round<rounds;round++)
+		for(const std::string& name : names)
+			for(cTexture* p : textures)
+				if(p && p->GetName() && stricmp(p->GetName(),name.c_str())==0)
+				{
+					scanned++;
+					break;
+				}
+	uint64_t time_scan=clock_us();
+
+	fprintf(stderr,"Texture library bench: %" PRIsize " textures, index %.1f lookups/ms, list scan %.1f lookups/ms, found %i/%i\n",
+		names.size(),
+		names.size()*rounds*1e3/std::max<uint64_t>(time_index-time_start,1),
+		names.size()*rounds*1e3/std::max<uint64_t>(time_scan-time_index,1),
+		found,scanned);
+}
+
+void cTexLibrary::SetupTexture(cTexture* Texture,const char *pMode)
 {
 	// тест наличия текстуры
 	if(pMode&&strstr((char*)pMode,"NoMipMap"))
@@ -264,29 +510,32 @@ bool cTexLibrary::LoadTexture(cTexture* Texture,const char *pMode)
 
     if(pMode&&strstr(pMode,"Normal"))
         Texture->SetAttribute(MAT_NORMAL);
+}
 
+bool cTexLibrary::LoadTexture(cTexture* Texture,const char *pMode)
+{
+	SetupTexture(Texture,pMode);
 	return ReLoadTexture(Texture);
 }
 
+int cTexLibrary::CreateFromImage(cTexture* Texture,cFileImage* FileImage)
+{
+	ClearFrames(Texture);
+	if(FileImage->GetBitPerPixel()==32) Texture->SetAttribute(TEXTURE_ALPHA_BLEND);
+
+	Texture->New(FileImage->GetLength());
+	if(FileImage->GetLength()<=1) 
+		Texture->SetTimePerFrame(0);
+	else
+		Texture->SetTimePerFrame((FileImage->GetTime()-1)/(FileImage->GetLength()-1));
+	Texture->SetWidth(FileImage->GetX()),Texture->SetHeight(FileImage->GetY());
+
+	return gb_RenderDevice->CreateTexture(Texture,FileImage);
+}
+
 bool cTexLibrary::ReLoadTexture(cTexture* Texture)
 {
-	{
-		for (auto frame : Texture->frames)
-		{
-#ifdef PERIMETER_D3D9
-            if (gb_RenderDevice->GetRenderSelection() == DEVICE_D3D9) {
-                frame.d3d->Release();
-            }
-#endif
-#ifdef PERIMETER_SOKOL
-            if (gb_RenderDevice->GetRenderSelection() == DEVICE_SOKOL) {
-                delete frame.sg;
-            }
-#endif
-            frame.ptr = nullptr;
-		}
-		Texture->frames.clear();
-	}
+	ClearFrames(Texture);
 		
 	bool bump=Texture->GetAttribute(MAT_BUMP)?true:false;
 	bool pos_bump=gb_VisGeneric->PossibilityBump();
@@ -326,7 +575,13 @@ bool cTexLibrary::ReLoadTexture(cTexture* Texture)
         }
 	}
 	
-	cFileImage* FileImage = path.length() > 0 ? cFileImage::Create(path.c_str()) : nullptr;
+	//Картинка могла быть заранее декодирована в фоне
+	cAssetLoader* loader = GetAssetLoader();
+	cFileImage* FileImage = loader && path.length() > 0 ? loader->TakeImage(path) : nullptr;
+	bool loaded = FileImage != nullptr;
+	if(!FileImage && path.length() > 0) {
+	    FileImage = cFileImage::Create(path.c_str());
+	}
 	if(!FileImage) {
         bool err;
 #ifdef PERIMETER_D3D9
@@ -345,23 +600,15 @@ bool cTexLibrary::ReLoadTexture(cTexture* Texture)
         return err;
 	}
 	
-	if(FileImage->load(path.c_str()))
+	if(!loaded && FileImage->load(path.c_str()))
 	{
 		delete FileImage;
 		Error(Texture);
 		Texture->Release();
 		return false;
 	}
-	if(FileImage->GetBitPerPixel()==32) Texture->SetAttribute(TEXTURE_ALPHA_BLEND);
-
-	Texture->New(FileImage->GetLength());
-	if(FileImage->GetLength()<=1) 
-		Texture->SetTimePerFrame(0);
-	else
-		Texture->SetTimePerFrame((FileImage->GetTime()-1)/(FileImage->GetLength()-1));
-	Texture->SetWidth(FileImage->GetX()),Texture->SetHeight(FileImage->GetY());
 
-	int err=gb_RenderDevice->CreateTexture(Texture,FileImage);
+	int err=CreateFromImage(Texture,FileImage);
 
 	delete FileImage;
 	if(err)
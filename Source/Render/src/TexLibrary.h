@@ -1,6 +1,7 @@
 #pragma once
 
 class cTexture;
+class cFileImage;
 
 class cTexLibrary
 {
@@ -14,6 +15,14 @@ public:
 	bool EnableError(bool enable);
 	cTexture* GetElementAviScale(const char* TextureName,const char *pMode =0);
 	cTexture* GetElement(const char *pTextureName,const char *pMode=0);
+	//Как GetElement, но картинка декодируется в фоне, до загрузки текстура белая.
+	//Если фоновая загрузка невозможна, грузит сразу.
+	//pDefTextureName - картинка на случай, если основная не декодируется (как def_path в LoadTextureDef)
+	cTexture* GetElementAsync(const char *pTextureName,const char *pMode=0,const char *pDefTextureName=0);
+	//Создает текстуры из загруженных в фоне картинок, только в графическом потоке
+	void UpdateStreaming();
+	//Печатает скорость поиска загруженных текстур по индексу и перебором
+	void BenchmarkLookup();
 
 	inline int GetNumberTexture()							{ return textures.size(); }
 	inline cTexture* GetTexture(int number)					{ return textures[number]; }
@@ -31,11 +40,29 @@ private:
 	bool enable_error;
     float current_bump_scale = 1;
 	std::vector<cTexture*> textures;
+	//Текстуры по ключу имени (convert_path_key), первая загруженная с этим именем
+	std::unordered_map<std::string, cTexture*> texture_index;
     std::unordered_map<std::string, float> texture_bump_scale;
+	//Текстуры, ждущие фоновой загрузки картинки
+	struct StreamingTexture
+	{
+		cTexture* texture;
+		std::string path;
+		std::string def_path;
+		int mipmap;
+	};
+	std::vector<StreamingTexture> streaming;
+	bool CreatePlaceholder(cTexture* Texture);
+
 	void FreeOne(FILE* f);
+	cTexture* FindTexture(const std::string& key);
+	void AddTexture(cTexture* Texture);
+	void RebuildIndex();
 
+	void SetupTexture(cTexture* Texture,const char *pMode);
 	bool LoadTexture(cTexture* Texture,const char *pMode);
 	bool ReLoadTexture(cTexture* Texture);
+	int CreateFromImage(cTexture* Texture,cFileImage* FileImage);
 
 	void Error(cTexture* Texture);
 
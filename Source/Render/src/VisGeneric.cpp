@@ -4,6 +4,7 @@
 #endif
 #include "VisGeneric.h"
 #include "ObjLibrary.h"
+#include "AssetLoader.h"
 #include "Scene.h"
 #include "Font.h"
 #include "Localization.h"
@@ -60,6 +61,10 @@ DebugType<int>		Option_EnablePointLight(true);
 DebugType<int>		Option_ShadowMapSelf4x4(true);//only radeon 9700
 DebugType<float>	Option_ParticleRate(1);
 DebugType<int>		Option_ShadowHint(0);
+DebugType<int>		Option_ParallelPreDraw(1);
+DebugType<int>		Option_SceneGridCulling(1);
+DebugType<int>		Option_ParallelEffects(1);
+DebugType<int>		Option_AssetStreaming(1);
 
 bool cVisGeneric::assertEnabled_ = false;
 
@@ -112,6 +117,22 @@ cVisGeneric::cVisGeneric() : cUnknownClass(KIND_UI_VISGENERIC)//: SceneArray(KIN
     MT_SET_TYPE(MT_GRAPH_THREAD);
     if (check_command_line("dump_mt_tls")) {
         debug_dump_mt_tls();
+    }
+    const char* parallel_predraw = check_command_line("render_parallel_predraw");
+    if (parallel_predraw) {
+        Option_ParallelPreDraw = atoi(parallel_predraw);
+    }
+    const char* grid_culling = check_command_line("render_grid_culling");
+    if (grid_culling) {
+        Option_SceneGridCulling = atoi(grid_culling);
+    }
+    const char* parallel_effects = check_command_line("render_parallel_effects");
+    if (parallel_effects) {
+        Option_ParallelEffects = atoi(parallel_effects);
+    }
+    const char* asset_streaming = check_command_line("render_asset_streaming");
+    if (asset_streaming) {
+        Option_AssetStreaming = atoi(asset_streaming);
     }
 	for(int i=0;i<SHOW_MAX;i++)
 		Option_ShowType[i]=true;
@@ -119,6 +140,7 @@ cVisGeneric::cVisGeneric() : cUnknownClass(KIND_UI_VISGENERIC)//: SceneArray(KIN
 	// инициализация глобальных переменых
 	shaders=NULL;
 	ObjLibrary=new cObjLibrary();
+	CreateAssetLoader();
 
 	FILE* f=fopen("VisGeneric.cfg","rt");
 	if( !f ) return;
@@ -181,6 +203,7 @@ cVisGeneric::~cVisGeneric()
 
 	ReleaseShaders();
 	RELEASE(ObjLibrary); 
+	DeleteAssetLoader();
 	ClearData();
 	gb_VisGeneric=0;
 	MTDONE(lock_effect_library);
@@ -254,6 +277,23 @@ cScene* cVisGeneric::CreateScene()
 	Scene->SetObjLibrary(ObjLibrary);
 	return Scene;
 }
+
+void cVisGeneric::PrefetchObject(const char* fname)
+{
+	ObjLibrary->Prefetch(fname);
+}
+
+void cVisGeneric::BenchmarkLibraries()
+{
+	ObjLibrary->BenchmarkLookup();
+	GetTexLibrary()->BenchmarkLookup();
+}
+
+void cVisGeneric::ClearPrefetch()
+{
+	if(cAssetLoader* loader=GetAssetLoader())
+		loader->Clear();
+}
 //////////////////////////////////////////////////////////////////////////////////////////
 void cVisGeneric::SetData(cInterfaceRenderDevice *pData)
 { // функция для работы с окном вывода
@@ -46,6 +46,12 @@ public:
     cInterfaceRenderDevice* GetRenderDevice();
 	// функции для работы со сценой
 	virtual cScene* CreateScene();
+	//Файл модели начинает читаться в фоне, чтобы первый CreateObject не ждал диска
+	void PrefetchObject(const char* fname);
+	//Выбрасывает файлы, прочитанные заранее и так и не понадобившиеся
+	void ClearPrefetch();
+	//Замер поиска в библиотеках моделей и текстур, render_library_bench=1
+	void BenchmarkLibraries();
 
 	//Предполагаестя, что все фонты лежат в одной директории,
 	//а SetFontDirectory и ReloadAllFont переключает языки 
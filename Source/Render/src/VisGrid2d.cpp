@@ -2,221 +2,266 @@
 #include "StdAfxRD.h"
 #include "VisGrid2d.h"
 #include "SafeCast.h"
+#include "ObjNode.h"
+#include "cCamera.h"
 
-QuatTree::QuatTree()
+SceneObjectGrid::SceneObjectGrid()
 {
-	root=NULL;
+	cell_number.set(0,0);
+	update_stamp=0;
+	culled=false;
+	ClearStatistics();
 }
 
-QuatTree::~QuatTree()
+SceneObjectGrid::~SceneObjectGrid()
 {
-	clear();	
+	clear();
 }
 
-void QuatTree::clear()
+void SceneObjectGrid::Init(int size_x,int size_y)
 {
-	delete root;
-	root=NULL;
+	clear();
+	cell_number.x=std::max((size_x+(1<<CELL_SHIFT)-1)>>CELL_SHIFT,1);
+	cell_number.y=std::max((size_y+(1<<CELL_SHIFT)-1)>>CELL_SHIFT,1);
+	cells.resize(cell_number.x*cell_number.y);
+	for(Cell& cell : cells)
+	{
+		cell.bound.SetInvalidBox();
+		cell.dirty=false;
+		cell.visible=true;
+	}
 }
 
-void QuatTree::find(Vect2i pos,int radius,find_proc proc,void* param)
+void SceneObjectGrid::clear()
 {
-	find(pos.x-radius,pos.y-radius,pos.x+radius,pos.y+radius,proc,param);
+	entries.clear();
+	free_entries.clear();
+	objects.clear();
+	cells.clear();
+	cell_number.set(0,0);
+	culled=false;
 }
 
-void QuatTree::find(int xmin,int ymin,int xmax,int ymax,find_proc proc,void* param)
+void SceneObjectGrid::ClearStatistics()
 {
-	add_proc=proc;
-	add_param=param;
-
-	add_xmin=xmin;
-	add_ymin=ymin;
-	add_xmax=xmax;
-	add_ymax=ymax;
-	if(root)
-		add(*root);
+	cells_visited=0;
+	objects_tested=0;
+	objects_moved=0;
 }
 
-void QuatTree::add(QuatNode& cur)
+int SceneObjectGrid::GetCell(const Vect3f& pos) const
 {
-	if((cur.xmin<add_xmax || cur.xmax>add_xmin)&&
-	   (cur.ymin<add_ymax || cur.ymax>add_ymin))
-	{
-        int sz = cur.obj.size();
-        for (int i = 0; i < sz; i++) {
-            cIUnkClass* obj = cur.obj[i];
-            Vect3f pos = obj->GetCenterObject();
-            if ((add_xmin<=pos.x && pos.x <= add_xmax) &&
-                (add_ymin<=pos.y && pos.y <= add_ymax))
-            {
-                add_proc(obj, add_param);
-            }
-        }
+	int x=clamp(xm::round(pos.x)>>CELL_SHIFT,0,cell_number.x-1);
+	int y=clamp(xm::round(pos.y)>>CELL_SHIFT,0,cell_number.y-1);
+	return x+y*cell_number.x;
+}
 
-		if(cur.left)
-			add(*cur.left);
-		if(cur.right)
-			add(*cur.right);
-	}
+void SceneObjectGrid::CalcBound(Entry& e)
+{
+	//Те же точки, что проверяет cCamera::TestVisible(matrix,min,max)
+	const Vect3f& mi=e.local_bound.min;
+	const Vect3f& ma=e.local_bound.max;
+	Vect3f p;
+	e.bound.SetInvalidBox();
+	e.matrix.xformPoint(Vect3f(mi.x,mi.y,mi.z),p); e.bound.AddBound(p);
+	e.matrix.xformPoint(Vect3f(ma.x,mi.y,mi.z),p); e.bound.AddBound(p);
+	e.matrix.xformPoint(Vect3f(mi.x,ma.y,mi.z),p); e.bound.AddBound(p);
+	e.matrix.xformPoint(Vect3f(ma.x,ma.y,mi.z),p); e.bound.AddBound(p);
+	e.matrix.xformPoint(Vect3f(mi.x,mi.y,ma.z),p); e.bound.AddBound(p);
+	e.matrix.xformPoint(Vect3f(ma.x,mi.y,ma.z),p); e.bound.AddBound(p);
+	e.matrix.xformPoint(Vect3f(mi.x,ma.y,ma.z),p); e.bound.AddBound(p);
+	e.matrix.xformPoint(Vect3f(ma.x,ma.y,ma.z),p); e.bound.AddBound(p);
+	e.center=e.matrix.trans();
 }
 
-void QuatTree::GetBorder(cIUnkClass* obj,int& xmin,int& ymin,int& xmax,int& ymax)
+void SceneObjectGrid::SetCell(int index,int cell)
 {
-	sBox6f b;
-	Vect2f mi,ma;
-	obj->GetBoundBox(b);
-	Vect3f	p[8];
-	const MatXf& matrix=obj->GetPosition();
-	matrix.xformPoint(Vect3f(b.min.x,b.min.y,b.min.z),p[0]);
-	matrix.xformPoint(Vect3f(b.max.x,b.min.y,b.min.z),p[1]);
-	matrix.xformPoint(Vect3f(b.min.x,b.max.y,b.min.z),p[2]);
-	matrix.xformPoint(Vect3f(b.max.x,b.max.y,b.min.z),p[3]);
-	matrix.xformPoint(Vect3f(b.min.x,b.min.y,b.max.z),p[4]);
-	matrix.xformPoint(Vect3f(b.max.x,b.min.y,b.max.z),p[5]);
-	matrix.xformPoint(Vect3f(b.min.x,b.max.y,b.max.z),p[6]);
-	matrix.xformPoint(Vect3f(b.max.x,b.max.y,b.max.z),p[7]);
-
-	mi.set(p[0].x,p[0].y);
-	ma=mi;
-	for(int k=0;k<8;k++)
+	Entry& e=entries[index];
+	if(e.cell>=0)
 	{
-		mi.x=min(mi.x,p[k].x);
-		mi.y=min(mi.y,p[k].y);
-		ma.x=max(ma.x,p[k].x);
-		ma.y=max(ma.y,p[k].y);
+		std::vector<int>& list=cells[e.cell].entries;
+		std::vector<int>::iterator it=std::find(list.begin(),list.end(),index);
+		VISASSERT(it!=list.end());
+		*it=list.back();
+		list.pop_back();
+		cells[e.cell].dirty=true;
 	}
 
-	xmin=mi.x;
-	xmax=ma.x;
-	ymin=mi.y;
-	ymax=ma.y;
+	e.cell=cell;
+	if(cell>=0)
+	{
+		cells[cell].entries.push_back(index);
+		cells[cell].dirty=true;
+	}
 }
 
-void QuatTree::build(int xmin,int ymin,int xmax,int ymax,vect& blist)
+void SceneObjectGrid::Remove(int index)
 {
-//	start_timer_auto(BuildTree,1);
+	Entry& e=entries[index];
+	objects.erase(e.obj);
+	SetCell(index,-1);
+	e.obj=NULL;
+	free_entries.push_back(index);
+}
 
-	clear();
-	int sz=blist.size();
-	if(!sz)
+void SceneObjectGrid::BeginUpdate()
+{
+	update_stamp++;
+	culled=false;
+}
+
+void SceneObjectGrid::Update(cIUnkClass* obj)
+{
+	if(cells.empty())
 		return;
-	std::vector<OneObj> tlist(sz);
-	std::vector<OneObj*> plist(sz);
-	for(int i=0;i<sz;i++)
+	VISASSERT(obj->GetKind()==KIND_OBJ_NODE_ROOT);
+	cObjectNodeRoot* node=safe_cast<cObjectNodeRoot*>(obj);
+
+	int index;
+	std::unordered_map<cIUnkClass*,int>::iterator it=objects.find(obj);
+	if(it==objects.end())
 	{
-		OneObj& o=tlist[i];
-		GetBorder(blist[i],o.xmin,o.ymin,o.xmax,o.ymax);
-		o.obj=blist[i];
-		plist[i]=&o;
+		if(free_entries.empty())
+		{
+			index=entries.size();
+			entries.push_back(Entry());
+		}else
+		{
+			index=free_entries.back();
+			free_entries.pop_back();
+		}
+		objects[obj]=index;
+
+		Entry& e=entries[index];
+		e.obj=obj;
+		e.cell=-1;
+	}else
+	{
+		index=it->second;
+		Entry& e=entries[index];
+		e.stamp=update_stamp;
+		sBox6f local_bound;
+		node->GetBoundBox(local_bound);
+		if(!memcmp(&e.matrix,&node->GetGlobalMatrix(),sizeof(MatXf)) &&
+		   !memcmp(&e.local_bound,&local_bound,sizeof(sBox6f)))
+			return;
 	}
 
-	root=new QuatNode;
-	build(xmin,ymin,xmax,ymax,plist,root);
+	Entry& e=entries[index];
+	e.stamp=update_stamp;
+	e.matrix=node->GetGlobalMatrix();
+	node->GetBoundBox(e.local_bound);
+	CalcBound(e);
+	objects_moved++;
+
+	int cell=GetCell(e.center);
+	if(cell!=e.cell)
+		SetCell(index,cell);
+	else
+		cells[cell].dirty=true;
 }
 
-void QuatTree::build(int xmin,int ymin,int xmax,int ymax,pvect& blist,QuatNode* node)
+void SceneObjectGrid::CalcCellBound(Cell& cell)
 {
-	node->xmin=xmin;
-	node->xmax=xmax;
-	node->ymin=ymin;
-	node->ymax=ymax;
-
-	int divigex=(xmin+xmax)>>1;
-	int divigey=(ymin+ymax)>>1;
-	if(divigex==xmin || divigey==ymin || blist.size()<4)
+	cell.bound.SetInvalidBox();
+	for(int index : cell.entries)
 	{
-		int sz=blist.size();
-		node->obj.resize(sz);
-		for(int i=0;i<sz;i++)
-			node->obj[i]=blist[i]->obj;
-		return;
+		const sBox6f& b=entries[index].bound;
+		cell.bound.AddBound(b.min);
+		cell.bound.AddBound(b.max);
 	}
+	cell.dirty=false;
+}
 
-	pvect horz_cur,horz_left,horz_right,
-		  vert_cur,vert_top,vert_bottom;
-
-	pvect::iterator it;
-	//x
-	FOR_EACH(blist,it)
+void SceneObjectGrid::EndUpdate()
+{
+	int sz=entries.size();
+	for(int i=0;i<sz;i++)
 	{
-		OneObj* o=*it;
-		if(o->xmin>=divigex)
-			horz_right.push_back(o);
-		else
-		if(o->xmax<=divigex)
-			horz_left.push_back(o);
-		else
-			horz_cur.push_back(o);
+		if(entries[i].obj && entries[i].stamp!=update_stamp)
+			Remove(i);
 	}
 
-	//y
-	FOR_EACH(blist,it)
+	for(Cell& cell : cells)
 	{
-		OneObj* o=*it;
-		if(o->ymin>=divigey)
-			vert_bottom.push_back(o);
-		else
-		if(o->ymax<=divigey)
-			vert_top.push_back(o);
-		else
-			vert_cur.push_back(o);
+		if(cell.dirty)
+			CalcCellBound(cell);
 	}
+}
 
-	int xt=horz_cur.size()+ (std::max)(horz_left.size(),horz_right.size());
-	int yt=vert_cur.size()+ (std::max)(vert_top.size(),vert_bottom.size());
-	if(xt<yt)
-	{
-		int sz=horz_cur.size();
-		node->obj.resize(sz);
-		for(int i=0;i<sz;i++)
-			node->obj[i]=horz_cur[i]->obj;
+void SceneObjectGrid::find(Vect2i pos,int radius,find_proc proc,void* param)
+{
+	find(pos.x-radius,pos.y-radius,pos.x+radius,pos.y+radius,proc,param);
+}
 
-		{
-			pvect().swap(vert_cur);
-			pvect().swap(vert_top);
-			pvect().swap(vert_bottom);
-			pvect().swap(horz_cur);
-		}
+void SceneObjectGrid::find(int xmin,int ymin,int xmax,int ymax,find_proc proc,void* param)
+{
+	if(cells.empty())
+		return;
 
-		if(!horz_left.empty())
-		{
-			node->left=new QuatNode;
-			build(xmin,ymin,divigex,ymax,horz_left,node->left);
-		}
+	//Объект лежит в ячейке своего центра, других ячеек смотреть не нужно
+	int cxmin=clamp(xmin>>CELL_SHIFT,0,cell_number.x-1);
+	int cymin=clamp(ymin>>CELL_SHIFT,0,cell_number.y-1);
+	int cxmax=clamp(xmax>>CELL_SHIFT,0,cell_number.x-1);
+	int cymax=clamp(ymax>>CELL_SHIFT,0,cell_number.y-1);
 
-		if(!horz_right.empty())
-		{
-			node->right=new QuatNode;
-			build(divigex,ymin,xmax,ymax,horz_right,node->right);
-		}
-	}else
+	for(int y=cymin;y<=cymax;y++)
+	for(int x=cxmin;x<=cxmax;x++)
 	{
-		int sz=vert_cur.size();
-		node->obj.resize(sz);
-		for(int i=0;i<sz;i++)
-			node->obj[i]=vert_cur[i]->obj;
-
+		Cell& cell=cells[x+y*cell_number.x];
+		cells_visited++;
+		for(int index : cell.entries)
 		{
-			pvect().swap(horz_cur);
-			pvect().swap(horz_left);
-			pvect().swap(horz_right);
-			pvect().swap(vert_cur);
+			const Entry& e=entries[index];
+			objects_tested++;
+			if((xmin<=e.center.x && e.center.x<=xmax) &&
+			   (ymin<=e.center.y && e.center.y<=ymax))
+			{
+				proc(e.obj,param);
+			}
 		}
+	}
+}
 
-		if(!vert_top.empty())
+void SceneObjectGrid::Cull(cCamera* camera)
+{
+	culled=!cells.empty();
+	for(Cell& cell : cells)
+	{
+		if(cell.entries.empty())
 		{
-			node->left=new QuatNode;
-			build(xmin,ymin,xmax,divigey,vert_top,node->left);
+			cell.visible=false;
+			continue;
 		}
 
-		if(!vert_bottom.empty())
-		{
-			node->right=new QuatNode;
-			build(xmin,divigey,xmax,ymax,vert_bottom,node->right);
-		}
+		cells_visited++;
+		cell.visible=camera->TestVisibleArea(cell.bound.min,cell.bound.max)!=VISIBLE_OUTSIDE;
 	}
 }
 
+bool SceneObjectGrid::IsCulled(cIUnkClass* obj) const
+{
+	if(!culled)
+		return false;
+
+	std::unordered_map<cIUnkClass*,int>::const_iterator it=objects.find(obj);
+	if(it==objects.end())
+		return false;
+
+	const Entry& e=entries[it->second];
+	if(cells[e.cell].visible)
+		return false;
+
+	cObjectNodeRoot* node=safe_cast<cObjectNodeRoot*>(obj);
+	sBox6f local_bound;
+	node->GetBoundBox(local_bound);
+	if(memcmp(&e.matrix,&node->GetGlobalMatrix(),sizeof(MatXf)) ||
+	   memcmp(&e.local_bound,&local_bound,sizeof(sBox6f)))
+		return false;
+
+	return true;
+}
+
 ///////////////////////////MTGVector///////////////////////////////
 /*
  Для StreamInterpolator необходимо иметь объекты,
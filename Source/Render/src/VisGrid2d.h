@@ -59,56 +59,83 @@ public:
 #endif
 };
 
-class QuatTree
+class cCamera;
+
+//Сетка объектов сцены (KIND_OBJ_NODE_ROOT) для поиска по области и отсечения по камере.
+//Объект лежит в ячейке своего центра, а границы ячейки включают границы всех её объектов
+//(loose grid), поэтому объект переносится только когда центр сменил ячейку.
+//Обновляется инкрементально, границы пересчитываются только у сдвинувшихся объектов.
+class SceneObjectGrid
 {
 public:
-	typedef std::vector<cIUnkClass*> vect;
 	typedef void (*find_proc)(cIUnkClass* obj,void* param);
-protected:
-	struct QuatNode
-	{
-		int xmin,ymin,xmax,ymax;
-		vect obj;
-		QuatNode *left,*right;
-
-		QuatNode()
-		{
-			left=right=NULL;
-		}
-
-		~QuatNode()
-		{
-			delete left;
-			delete right;
-		}
-	};
-
-	QuatNode* root;
-
-	int add_xmin,add_ymin,add_xmax,add_ymax;
-	find_proc add_proc;
-	void* add_param;
-	void add(QuatNode& cur);
 
-	struct OneObj
-	{
-		int xmin,ymin,xmax,ymax;
-		cIUnkClass* obj;
-	};
+	SceneObjectGrid();
+	~SceneObjectGrid();
 
-	typedef std::vector<OneObj*> pvect;
-	void build(int xmin,int ymin,int xmax,int ymax,pvect& blist,QuatNode* cur);
-
-public:
+	void Init(int size_x,int size_y);
+	void clear();
 
-	QuatTree();
-	~QuatTree();
+	//Каждый кадр: BeginUpdate, Update для всех объектов сцены, EndUpdate.
+	//Объекты, для которых не вызван Update, удаляются из сетки
+	void BeginUpdate();
+	void Update(cIUnkClass* obj);
+	void EndUpdate();
 
+	//Объекты с центром в прямоугольнике
 	void find(Vect2i pos,int radius,find_proc proc,void* param);
 	void find(int xmin,int ymin,int xmax,int ymax,find_proc proc,void* param);
 
-	void build(int xmin,int ymin,int xmax,int ymax,vect& blist);
-	void clear();
+	//Отсечение ячеек по камере, после него IsCulled(obj) - объект точно не виден камерой.
+	//Объект, сдвинутый после последнего Update, считается видимым.
+	//IsCulled можно вызывать из нескольких потоков
+	void Cull(cCamera* camera);
+	bool IsCulled(cIUnkClass* obj) const;
+
+	//Статистика за кадр
+	int GetNumberObject() const { return objects.size(); }
+	int GetCellsVisited() const { return cells_visited; }
+	int GetObjectsTested() const { return objects_tested; }
+	int GetObjectsMoved() const { return objects_moved; }
+	void ClearStatistics();
+
 protected:
-	void GetBorder(cIUnkClass* p,int& xmin,int& ymin,int& xmax,int& ymax);
+	enum { CELL_SHIFT = 7 };
+
+	struct Entry
+	{
+		cIUnkClass* obj;
+		MatXf matrix;
+		sBox6f local_bound;
+		sBox6f bound;
+		Vect3f center;
+		int cell;
+		int stamp;
+	};
+
+	struct Cell
+	{
+		std::vector<int> entries;
+		sBox6f bound;
+		bool dirty;
+		bool visible;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<int> free_entries;
+	std::unordered_map<cIUnkClass*,int> objects;
+	std::vector<Cell> cells;
+	Vect2i cell_number;
+	int update_stamp;
+	bool culled;
+
+	int cells_visited;
+	int objects_tested;
+	int objects_moved;
+
+	int GetCell(const Vect3f& pos) const;
+	void SetCell(int index,int cell);
+	void CalcBound(Entry& e);
+	void Remove(int index);
+	void CalcCellBound(Cell& cell);
 };
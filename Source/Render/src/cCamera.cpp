@@ -780,6 +780,14 @@ struct SortMaterialByNodeBank
 	}
 };
 
+static void DrawMeshInstances(std::vector<cObjMesh*>& meshes,sDataRenderMaterial& Data)
+{
+	if(meshes.empty())
+		return;
+	gb_RenderDevice->DrawNoMaterialMeshInstances(&meshes.front(),meshes.size(),&Data);
+	meshes.clear();
+}
+
 void cCamera::DrawSortMaterial()
 {
 	std::vector<cMeshSortingPhase*>& ar=RootCamera->arSortMaterial;
@@ -802,12 +810,17 @@ void cCamera::DrawSortMaterial()
     gb_RenderDevice->BeginDrawMesh(false, use_shadow);
     gb_RenderDevice->SetSimplyMaterialMesh(cur_mat->GetFront(), &Data);
 
+	//Меши копятся пока не сменится материал и отдаются устройству пачкой
+	std::vector<cObjMesh*>& instances=RootCamera->arDrawMesh;
+	instances.clear();
+
 	if (GetAttribute(ATTRCAMERA_REFLECTION)) {
         for (cMeshSortingPhase* s : ar) {
 			if(cur_mat->pBank!=s->pBank || cur_mat->channel!=s->channel ||
 				cur_mat->phase!=s->phase || cur_mat->diffuse!=s->diffuse ||
 				cur_mat->ambient!=s->ambient ||
 				cur_mat->attribute!=s->attribute) {
+				DrawMeshInstances(instances, Data);
 				cur_mat=s;
 				cur_mat->GetMaterial(&Data);
 
@@ -820,7 +833,7 @@ void cCamera::DrawSortMaterial()
                     continue;
                 }
 
-                gb_RenderDevice->DrawNoMaterialMesh(pMesh, &Data);
+                instances.push_back(pMesh);
 				//draw_object++;
 			}
 		}
@@ -829,6 +842,7 @@ void cCamera::DrawSortMaterial()
 			if(cur_mat->pBank!=s->pBank || cur_mat->channel!=s->channel ||
 			   cur_mat->phase!=s->phase || cur_mat->diffuse!=s->diffuse ||
 			   cur_mat->attribute!=s->attribute) {
+				DrawMeshInstances(instances, Data);
 				cur_mat=s;
 				cur_mat->GetMaterial(&Data);
 
@@ -837,11 +851,12 @@ void cCamera::DrawSortMaterial()
 			}
 
 			for(cObjMesh* pMesh=s->GetFront();pMesh;pMesh=pMesh->GetNextSorting()) {
-                gb_RenderDevice->DrawNoMaterialMesh(pMesh, &Data);
+                instances.push_back(pMesh);
 				//draw_object++;
 			}
 		}
 	}
+	DrawMeshInstances(instances, Data);
 
     gb_RenderDevice->EndDrawMesh();
 }
@@ -1069,6 +1084,32 @@ eTestVisible cCamera::TestVisible(const MatXf &matrix,const Vect3f &min,const Ve
 	return VISIBLE_INTERSECT;
 }
 
+eTestVisible cCamera::GridTestArea(const Vect3f &min,const Vect3f &max)
+{
+	int xmin=(int) xm::round(min.x) >> TestGridShl,ymin=(int) xm::round(min.y) >> TestGridShl;
+	int xmax=(int) xm::round(max.x) >> TestGridShl,ymax=(int) xm::round(max.y) >> TestGridShl;
+	xmin=std::max(xmin,0);
+	ymin=std::max(ymin,0);
+	xmax=std::min(xmax,TestGridSize.x-1);
+	ymax=std::min(ymax,TestGridSize.y-1);
+
+	for(int y=ymin;y<=ymax;y++)
+	for(int x=xmin;x<=xmax;x++)
+	{
+		if(pTestGrid[x+y*TestGridSize.x])
+			return VISIBLE_INTERSECT;
+	}
+
+	return VISIBLE_OUTSIDE;
+}
+
+eTestVisible cCamera::TestVisibleArea(const Vect3f &min,const Vect3f &max)
+{
+	if(RootCamera->pTestGrid)
+		return RootCamera->GridTestArea(min,max);
+	return TestVisible(min,max);
+}
+
 //*
 eTestVisible cCamera::TestVisible(const Vect3f &min,const Vect3f &max)
 { // для BoundingBox с границами min && max, заданными в глобальным координатах
@@ -102,6 +102,9 @@ public:
 	eTestVisible TestVisibleComplete(const Vect3f &min,const Vect3f &max);
 	
 	eTestVisible TestVisible(const MatXf &matrix,const Vect3f &min,const Vect3f &max);
+	// для области в глобальных координатах, содержащей BoundingBox нескольких объектов,
+	// объекты вне видимой области точно не пройдут TestVisible(matrix,min,max)
+	eTestVisible TestVisibleArea(const Vect3f &min,const Vect3f &max);
 	inline eTestVisible TestVisible(const Vect3f &center,float radius=0);
 
 	void Attach(int pos,cIUnkClass *UObject);
@@ -210,6 +213,7 @@ protected:
 	Vect3f						WorldI,WorldJ,WorldK;
 protected:
 	std::vector<cMeshSortingPhase*> arSortMaterial;
+	std::vector<cObjMesh*> arDrawMesh;//меши с одинаковым материалом, рисуются одним вызовом
 	void DrawSortMaterial();
 	void DrawSortMaterialShadow();
 	void DrawSortMaterialShadowStrencil();
@@ -231,6 +235,7 @@ protected:
 	void InitGridTest(int grid_dx,int grid_dy,int grid_size);
 	void CalcTestForGrid();
 	inline eTestVisible GridTest(Vect3f p[8]);
+	eTestVisible GridTestArea(const Vect3f &min,const Vect3f &max);
 
 	void DrawShadowDebug();
 	void Set2DRenderState();
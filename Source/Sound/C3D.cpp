@@ -359,72 +359,52 @@ void ScriptParam::Release()
 	sounds.clear();
 }
 
-struct SNDOneBufferDistance
+//Играющему звуку при сравнении громкости даётся запас,
+//чтобы звуки примерно равной громкости не перехватывали канал друг у друга каждый кадр
+static const float VOICE_PLAYING_BONUS = 1.25f;
+
+struct SNDOneBufferPriority
 {
 	SNDOneBuffer* p;
-	float distance;
+	float priority;
+	int index;
 
-	inline bool operator()(const SNDOneBufferDistance& s1,const SNDOneBufferDistance& s2)const
+	inline bool operator()(const SNDOneBufferPriority& s1,const SNDOneBufferPriority& s2)const
 	{
-		return s1.distance<s2.distance;
+		if(s1.priority!=s2.priority)
+			return s1.priority>s2.priority;
+		return s1.index<s2.index;
 	}
 };
 
-void ScriptParam::RecalculateClipDistance()
+void ScriptParam::LimitVoices()
 {
-	std::vector<SNDOneBufferDistance> real_played;
-	std::vector<SNDOneBuffer>::iterator its;
-	if(max_num_sound<1)
-		return;
-
-	if(soundbuffer.size()<=max_num_sound)
-		return;
+	//Вызывается только из SND3DListener::Update, буфер общий для всех типов
+	static std::vector<SNDOneBufferPriority> playing;
+	playing.clear();
 
-	SNDOneBufferDistance s;
-	FOR_EACH(soundbuffer,its)
+	SNDOneBufferPriority s;
+	for(int i=0;i<soundbuffer.size();i++)
 	{
-		SNDOneBuffer& p=*its;
-		if(!p.used)continue;
-		if(p.p3DBuffer==NULL)continue;
-
+		SNDOneBuffer& p=soundbuffer[i];
+		if(!p.used || p.p3DBuffer==NULL)
+			continue;
+		p.p3DBuffer->SetCulled(false);
 		if(!p.p3DBuffer->IsPlaying())
 			continue;
 		s.p=&p;
-		s.distance=p.p3DBuffer->VectorToListener().norm();
-		real_played.push_back(s);
+		s.priority=p.buffer->volume;
+		if(!p.p3DBuffer->IsVirtual())
+			s.priority*=VOICE_PLAYING_BONUS;
+		s.index=i;
+		playing.push_back(s);
 	}
 
-	int sz=real_played.size();
-	if(sz<=max_num_sound)
+	if(max_num_sound<1 || playing.size()<=max_num_sound)
 		return;
 
-	std::sort(real_played.begin(),real_played.end(),s);
-
-	int i;
-#ifdef _DEBUG
-	for(i=0;i<sz-1;i++)
-	{
-		float d1=real_played[i].distance;
-		float d2=real_played[i+1].distance;
-		ASSERT(d1<=d2);
-	}
-#endif //_DEBUG
-/*
-	float clip_dist=(real_played[max_num_sound-1].distance+
-					 real_played[max_num_sound].distance)*0.5f;
-
-	FOR_EACH(soundbuffer,its)
-	if(its->p3DBuffer)
-		its->p3DBuffer->SetClipDistance(clip_dist);
-/*/
-	for(i=0;i<real_played.size();i++)
-	{
-		if(i<max_num_sound)
-			real_played[i].p->p3DBuffer->SetClipDistance(FLT_MAX);
-		else
-			real_played[i].p->p3DBuffer->SetClipDistance(0);
-	}
-/**/
-
+	//Полная сортировка не нужна, достаточно отделить max_num_sound самых громких
+	std::nth_element(playing.begin(),playing.begin()+max_num_sound,playing.end(),s);
+	for(int i=max_num_sound;i<playing.size();i++)
+		playing[i].p->p3DBuffer->SetCulled(true);
 }
-
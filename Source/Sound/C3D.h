@@ -29,6 +29,8 @@ struct SNDOneBuffer
 
 	inline bool RecalculatePos();
 	inline void RecalculateVolume();
+	//Передаёт положение в p3DBuffer и считает слышимость, не трогая канал
+	inline float RecalculateAudible();
 
 	//Автоматическое задание нестандартной частоты
 	void PlayPreprocessing();
@@ -66,8 +68,9 @@ struct ScriptParam
 
 	void Release();
 
-	//Рассчитывает, какой должна быть ClipDistance, чтобы звучало не более max_num_sound
-	void RecalculateClipDistance();
+	//Оставляет слышимыми не более max_num_sound самых громких звуков,
+	//остальные играют виртуально. Вызывать после RecalculateAudible всех буферов
+	void LimitVoices();
 
 	MTSection* GetLock(){return &mtlock;};
 	std::vector<SND_Sample*>& GetSounds(){ASSERT(mtlock.is_lock());return sounds;}
@@ -20,6 +20,7 @@ static bool g_enable_voices = true;
 static bool enable_sound_log = false;
 
 SND3DListener snd_listener;
+static SNDVoiceStats voice_stats;
 
 static std::string sound_directory="";
 
@@ -387,20 +388,23 @@ bool SND3DListener::SetVelocity(const Vect3f& _velocity)
 	return true;
 }
 
-bool SNDOneBuffer::RecalculatePos()
+float SNDOneBuffer::RecalculateAudible()
 {
-	if (!used) return true;
 	//Vect3f p=snd_listener.mat*pos;
-	Vect3f p=snd_listener.rotate*(pos-snd_listener.position);
-	bool ok = p3DBuffer->SetPosition(pos);//p);
+	p3DBuffer->SetPosition(pos);//p);
 
 //	Vect3f v=snd_listener.mat.rot()*velocity;
 	Vect3f v=snd_listener.rotate*velocity;
-	ok &= p3DBuffer->SetVelocity(v);
-	p3DBuffer->RecalculatePos();
-
-	return ok;
+	p3DBuffer->SetVelocity(v);
+	return p3DBuffer->RecalculateAudible();
+}
 
+bool SNDOneBuffer::RecalculatePos()
+{
+	if (!used) return true;
+	RecalculateAudible();
+	p3DBuffer->UpdateVoice();
+	return true;
 }
 
 void SNDOneBuffer::RecalculateVolume()
@@ -439,23 +443,51 @@ void SNDOneBuffer::PlayPreprocessing()
 
 bool SND3DListener::Update()
 {
+	uint64_t update_start=clock_us();
+	voice_stats.active=voice_stats.virtual_voices=0;
+
 	SNDScript::MapScript::iterator it;
 	FOR_EACH(script3d.map_script,it)
 	{
 		ScriptParam* sp=(*it).second;
 		MTAuto lock(sp->GetLock());
-		sp->RecalculateClipDistance();
+		std::vector<SNDOneBuffer>& buffers=sp->GetBuffer();
 
+		//Сначала слышимость всех звуков типа, затем ограничение их числа,
+		//и только потом каналы микшера, чтобы не запускать звук, который тут же будет вытеснен
 		std::vector<SNDOneBuffer>::iterator itb;
-		FOR_EACH(sp->GetBuffer(),itb)
+		FOR_EACH(buffers,itb)
+		{
+			SNDOneBuffer& sb=*itb;
+			if(sb.used && sb.p3DBuffer && sb.p3DBuffer->IsPlaying())
+				sb.RecalculateAudible();
+		}
+
+		sp->LimitVoices();
+
+		FOR_EACH(buffers,itb)
 		{
-			(*itb).RecalculatePos();
+			SNDOneBuffer& sb=*itb;
+			if(!sb.used || !sb.p3DBuffer || !sb.p3DBuffer->IsPlaying())
+				continue;
+			sb.p3DBuffer->UpdateVoice();
+			if(sb.p3DBuffer->IsVirtual())
+				voice_stats.virtual_voices++;
+			else if(sb.p3DBuffer->IsPlaying())
+				voice_stats.active++;
 		}
 	}
 
+	voice_stats.mixing=Mix_Playing(-1);
+	voice_stats.update_ms=(clock_us()-update_start)*1e-3f;
 	return true;
 }
 
+const SNDVoiceStats& SNDGetVoiceStats()
+{
+	return voice_stats;
+}
+
 ///////////////////////SND3DSound////////////////////////
 SND3DSound::SND3DSound()
 {
@@ -145,6 +145,19 @@ public:
 
 extern SND3DListener snd_listener;
 
+//Статистика 3D звуков за последний SND3DListener::Update
+struct SNDVoiceStats
+{
+	int active;//занимают канал микшера
+	int virtual_voices;//играют без канала: неслышны или вытеснены по max_num_sound
+	int mixing;//всего занятых каналов микшера, вместе с 2D и речью
+	float update_ms;//время SND3DListener::Update
+
+	SNDVoiceStats():active(0),virtual_voices(0),mixing(0),update_ms(0){}
+};
+
+const SNDVoiceStats& SNDGetVoiceStats();
+
 ////////////////////////////2D/////////////////////////////////
 
 //volume : 0 - миниум, 1 - максиум
@@ -129,6 +129,7 @@ int SND_Sample::play() {
             SDL_LockAudio();
             channelSamples[channel] = this;
             SDL_UnlockAudio();
+            channel_hint = channel;
         }
         
     }
@@ -195,10 +196,16 @@ int SND_Sample::getChannel() const {
     if (!SND::has_sound_init) return SND_NO_CHANNEL;
     SDL_LockAudio();
     int channel = SND_NO_CHANNEL;
-    for (auto entry : channelSamples) {
-        if (entry.second == this) {
-            channel = entry.first;
-            break;
+    auto hint = channelSamples.find(channel_hint);
+    if (hint != channelSamples.end() && hint->second == this) {
+        channel = channel_hint;
+    } else {
+        for (auto entry : channelSamples) {
+            if (entry.second == this) {
+                channel = entry.first;
+                channel_hint = channel;
+                break;
+            }
         }
     }
     SDL_UnlockAudio();
@@ -102,6 +102,9 @@ private:
     ///Current frequency of chunk
     float chunk_frequency = 1.0f;
 
+    ///Channel used by last play, checked first in getChannel to avoid scanning all channels
+    mutable int channel_hint = SND_NO_CHANNEL;
+
     ///Updates the channel effects from current sample effects, internal function that accepts channel
     bool updateEffects(int channel);
 
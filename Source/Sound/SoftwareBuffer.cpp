@@ -29,6 +29,12 @@ static void dprintf(char *format, ...)
 //////////////////////SoftSound3D//////////////////////////
 const float SOUND_CONSTANT = 343.0;
 
+//Одиночный звук, ставший слышимым позже этого (мс) от начала, не запускается:
+//SDL_mixer не умеет начинать с середины, а звук выстрела с начала уже не к месту
+static const double VIRTUAL_LATE_START = 150.0;
+//Изменения громкости и панорамы меньше этого не передаются в канал
+static const float APPLY_EPSILON = 1.0f/256;
+
 SoftSound3D::SoftSound3D()
 {
 	pause=false;
@@ -43,6 +49,11 @@ SoftSound3D::SoftSound3D()
 	volume=1.0f;
 
 	set_volume=1.0f;
+
+	is_virtual=false;
+	culled=false;
+	play_time=pause_time=0;
+	applied_volume=applied_pan=-1;
 }
 
 SoftSound3D::~SoftSound3D()
@@ -106,7 +117,10 @@ bool SoftSound3D::IsPlaying()
 bool SoftSound3D::Play(bool cycled)
 {
     is_cycled=pSound->looped = cycled;
-	is_playing=pSound->play() != SND_NO_CHANNEL;
+	is_playing=true;
+	//Канал получит в UpdateVoice, если слышен
+	is_virtual=true;
+	play_time=clockf();
 
 //	if(!is_cycled)dprintf("Play\n");
 
@@ -126,6 +140,7 @@ bool SoftSound3D::Play(bool cycled)
 bool SoftSound3D::Stop()
 {
     is_playing=false;
+    is_virtual=false;
     pause=false;
     return pSound->stop();
 }
@@ -152,6 +167,12 @@ Vect3f SoftSound3D::VectorToListener()
 }
 
 void SoftSound3D::RecalculatePos()
+{
+	RecalculateAudible();
+	UpdateVoice();
+}
+
+float SoftSound3D::RecalculateAudible()
 {
 	//Volume
 	Vect3f pos=position-snd_listener.position;
@@ -254,65 +275,78 @@ void SoftSound3D::RecalculatePos()
 	}
 /**/
 
-	if(is_playing) {//Start/stop section
-        bool is_playing_real=pSound->isPlaying();
+	return pSound->volume;
+}
 
-/*      TODO commented originally, remove?
-		if(is_playing_real)
+void SoftSound3D::UpdateVoice()
+{
+	//Стоящий на паузе канал держим до SNDPausePop
+	if(!is_playing || pause)
+		return;
+
+	bool audible=!culled && SND::EFFECT_VOLUME_THRESHOLD<pSound->volume;
+	if(!is_virtual)
+	{
+		bool is_playing_real=pSound->isPlaying();
+		if(is_playing_real && audible)
 		{
-			DWORD dwCurrentPlayCursor;
-			if(pSound->GetCurrentPosition(&dwCurrentPlayCursor,NULL)==DS_OK)
+			//Update any change of effects we may have made
+			if(APPLY_EPSILON<=xm::abs(pSound->volume-applied_volume) || APPLY_EPSILON<=xm::abs(pSound->pan-applied_pan))
 			{
-				begin_play_sound=curtime-dwCurrentPlayCursor/(double)nAvgBytesPerSec;
+				pSound->updateEffects();
+				applied_volume=pSound->volume;
+				applied_pan=pSound->pan;
 			}
+			return;
 		}
-*/
-        
-        /* TODO use this instead of pausing channel once seeking is impl in SDL_mixer
-        if (full_volume == 0.0f && is_playing_real) {
-            //Stop
-            last_start_stop=curtime;
-            pSound->stop();
-            is_playing_real = false;
-        } else {
-            //Start
-            is_playing_real = pSound->play() != SND_NO_CHANNEL;
-        }
-        */
-
-        //Stop cycled ones that have no volume to free channel
-        if (is_playing_real && is_cycled && pSound->volume <= SND::EFFECT_VOLUME_THRESHOLD) {
-            pSound->stop();
-            is_playing_real = false;
-        }
-
-        //Update any change of effects we may have made
-        if (is_playing_real) {
-            pSound->updateEffects();
-        }
-
-        //if(!is_cycled && curpos>=1.0f) //TODO once seeking is done use something like this
-		if(!is_playing_real)
+
+		if(is_playing_real)
+		{
+			//Неслышный или вытесненный звук освобождает канал и дальше играет виртуально
+			pSound->stop();
+		}else if(!is_cycled)
+		{
+			//Доиграл
+			Stop();
+			return;
+		}
+		//Sometimes cycled ones can be stopped when frequency changes, they are restarted below
+		is_virtual=true;
+	}
+
+	double elapsed=clockf()-play_time;
+	if(!is_cycled && pSound->getDuration()<=elapsed)
+	{
+		Stop();
+		return;
+	}
+
+	//TODO once seeking is impl in SDL_mixer start one shot sounds from elapsed position
+	if(audible && (is_cycled || elapsed<VIRTUAL_LATE_START))
+	{
+		if(pSound->play()!=SND_NO_CHANNEL)
 		{
-            if (is_cycled) {
-                //Sometimes cycled ones can be stopped when frequency changes or volume is zero
-                if (SND::EFFECT_VOLUME_THRESHOLD <= pSound->volume) {
-                    //Volume is back, play it
-                    pSound->play();
-                }
-            } else {
-                Stop();
-            }
+			is_virtual=false;
+			applied_volume=pSound->volume;
+			applied_pan=pSound->pan;
 		}
 	}
 }
 
 void SoftSound3D::RecalculateVolume()
 {
+	//Громкость могла поменяться глобально, передать в канал в любом случае
+	applied_volume=-1;
 	RecalculatePos();
 }
 
 void SoftSound3D::Pause(bool p) {
+    //Время на паузе не идёт в позицию виртуального звука
+    if (p && !pause) {
+        pause_time = clockf();
+    } else if (!p && pause) {
+        play_time += clockf() - pause_time;
+    }
     pause = p;
     if (pause) {
         pSound->pause();
@@ -31,6 +31,15 @@ public:
 	virtual void RecalculatePos()=0;
 	virtual void RecalculateVolume()=0;
 
+	//RecalculatePos по частям, чтобы сначала посчитать слышимость всех звуков,
+	//а потом уже запускать и останавливать каналы микшера
+	virtual float RecalculateAudible()=0;//Возвращает громкость с учётом расстояния
+	virtual void UpdateVoice()=0;
+
+	//Вытесненный более громкими звуками того же типа звук играет виртуально
+	virtual void SetCulled(bool culled)=0;
+	virtual bool IsVirtual()=0;
+
 	virtual Vect3f VectorToListener()=0;
 
 	virtual void SetClipDistance(float clip_distance)=0;
@@ -49,6 +58,14 @@ class SoftSound3D:public VirtualSound3D
 	bool pause;
 	float volume;
 	float set_volume;
+
+	//Виртуальный звук играет без канала микшера, его позиция отслеживается по времени
+	bool is_virtual;
+	bool culled;
+	double play_time;//clockf() начала проигрывания, сдвигается на время паузы
+	double pause_time;
+	//Что последний раз передано в канал, чтобы не трогать микшер без изменений
+	float applied_volume,applied_pan;
 public:
 	SoftSound3D();
 	~SoftSound3D();
@@ -73,6 +90,11 @@ public:
 	void RecalculatePos();
 	void RecalculateVolume();
 
+	float RecalculateAudible();
+	void UpdateVoice();
+	void SetCulled(bool _culled){culled=_culled;};
+	bool IsVirtual(){return is_playing && is_virtual;};
+
 	Vect3f VectorToListener();
 	void SetClipDistance(float _clip_distance){clip_distance=_clip_distance;};
 	void Pause(bool p);
@@ -9,6 +9,13 @@ interface ITriggerChainProfiler
 	virtual char const* getEntryText(int entryIndex) const = 0;
 	virtual bool setCurrentEntry(int entryIndex) = 0;
 	virtual bool isDataEnabled() const = 0;
+
+	// Получено событий цепочкой
+	virtual int getEventsCount() const = 0;
+	// Передано событий триггерам, подписанным на их тип
+	virtual int getEventDispatchCount() const = 0;
+	// Не передано активным триггерам, которым событие не нужно
+	virtual int getEventSkipCount() const = 0;
 };
 
 #endif//__TRIGGER_CHAIN_PROFILER
\ No newline at end of file
@@ -50,3 +50,18 @@ bool TriggerChainProfiler::setCurrentEntry(int entryIndex){
 bool TriggerChainProfiler::isDataEnabled() const{
 	return ptrChain_->isLogValid();
 }
+
+int TriggerChainProfiler::getEventsCount() const{
+	assert(ptrChain_);
+	return ptrChain_->eventsReceived();
+}
+
+int TriggerChainProfiler::getEventDispatchCount() const{
+	assert(ptrChain_);
+	return ptrChain_->eventsDispatched();
+}
+
+int TriggerChainProfiler::getEventSkipCount() const{
+	assert(ptrChain_);
+	return ptrChain_->eventsSkipped();
+}
@@ -27,6 +27,10 @@ public:
 	virtual char const* getEntryText(int entryIndex) const;
 	virtual bool setCurrentEntry(int entryIndex);
 	virtual bool isDataEnabled() const;
+
+	virtual int getEventsCount() const;
+	virtual int getEventDispatchCount() const;
+	virtual int getEventSkipCount() const;
 private:
 	TriggerChain* ptrChain_;
 };
@@ -39,6 +39,15 @@ void ConditionSwitcher::checkEvent(AIPlayer& aiPlayer, const Event* event)
 			ci->condition->checkEvent(aiPlayer, event);
 }
 
+int ConditionSwitcher::eventMask() const
+{
+	int mask = 0;
+    FOR_EACH_AUTO(conditions, ci)
+		if(ci->condition)
+			mask |= ci->condition->eventMask();
+	return mask;
+}
+
 void ConditionSwitcher::clear() 
 {
     FOR_EACH_AUTO(conditions, ci)
@@ -214,6 +223,9 @@ bool Trigger::isChild(const Trigger& child) const
 //------------------------------------------------------------
 TriggerChain::TriggerChain() 
 {
+	eventsReceived_ = 0;
+	eventsDispatched_ = 0;
+	eventsSkipped_ = 0;
 	initialize();
 }
 
@@ -238,9 +250,13 @@ void TriggerChain::buildLinks()
 	}
 
 	activeTriggers_.clear();
+	for(int i = 0; i < EVENT_TYPES_MAX; i++)
+		eventSubscribers_[i].clear();
     FOR_EACH_AUTO(triggers, ti)
-		if(ti->active())
+		if(ti->active()){
 			activeTriggers_.push_back(&(*ti));
+			subscribe(&(*ti));
+		}
 
 	triggerEvents_.clear();
 }
@@ -264,6 +280,23 @@ void TriggerChain::initialize()
 	buildLinks();
 }
 
+void TriggerChain::subscribe(Trigger* trigger)
+{
+	int mask = trigger->condition ? trigger->condition->eventMask() : 0;
+	for(int i = 0; i < EVENT_TYPES_MAX; i++)
+		if(mask & (1 << i))
+			eventSubscribers_[i].push_back(trigger);
+}
+
+void TriggerChain::unsubscribe(Trigger* trigger)
+{
+	// Условие могло смениться после подписки, поэтому чистим все списки
+	for(int i = 0; i < EVENT_TYPES_MAX; i++){
+		ActiveTriggers& subscribers = eventSubscribers_[i];
+		subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), trigger), subscribers.end());
+	}
+}
+
 void TriggerChain::initTriggersState()
 {
 	TriggerList::iterator ti;
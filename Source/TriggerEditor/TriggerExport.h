@@ -122,6 +122,8 @@ struct Condition : ShareHandleBaseSerializeVirtual // Не выполняетс
 		return state_ = check(aiPlayer); 
 	}
 	virtual void checkEvent(AIPlayer& aiPlayer, const class Event* event) {}
+	// Маска типов событий (Event::mask), на которые реагирует checkEvent
+	virtual int eventMask() const { return 0; }
 	virtual void clear() {}
 	virtual void writeInfo(XBuffer& buffer, std::string offset) const {}
 
@@ -192,6 +194,7 @@ struct ConditionSwitcher : Condition // И/ИЛИ
 
 	bool check(AIPlayer& aiPlayer) override;
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 	void clear() override;
 	void writeInfo(XBuffer& buffer, std::string offset) const override;
 
@@ -548,6 +551,12 @@ public:
 	void activateTrigger(Trigger* trigger);
 	void deactivateTrigger(Trigger* trigger);
 
+	// Счетчики рассылки событий: получено событий, передано триггерам,
+	// не передано активным триггерам, чьи условия на событие не реагируют
+	int eventsReceived() const { return eventsReceived_; }
+	int eventsDispatched() const { return eventsDispatched_; }
+	int eventsSkipped() const { return eventsSkipped_; }
+
 	const CRectSerialized& boundingRect() const {
 		return boundingRect_;
 	}
@@ -584,6 +593,18 @@ private:
 
 	typedef std::vector<Trigger*, TriggerAllocator<Trigger*> > ActiveTriggers;
 	ActiveTriggers activeTriggers_;
+
+	// Активные триггера по типам событий, на которые реагируют их условия.
+	// Ведется вместе с activeTriggers_ и в том же порядке
+	enum { EVENT_TYPES_MAX = 32 };
+	ActiveTriggers eventSubscribers_[EVENT_TYPES_MAX];
+
+	int eventsReceived_;
+	int eventsDispatched_;
+	int eventsSkipped_;
+
+	void subscribe(Trigger* trigger);
+	void unsubscribe(Trigger* trigger);
 };
 
 //-----------------------------
@@ -130,6 +130,15 @@ void terUnitBase::setPose(const Se3f& pose, bool initPose)
     log_var(pose_.trans());
 }
 
+void terUnitBase::setUnitClass(int unit_class)
+{
+	if(unitClass_ == unit_class)
+		return;
+	unitClass_ = unit_class;
+	if(Player)
+		Player->updateUnitIndex(this);
+}
+
 void terUnitBase::updateIncludingCluster()
 {
 	includingCluster_ = field_dispatcher->getIncludingCluster(position());
@@ -358,6 +367,7 @@ void terUnitBase::universalLoad(SaveUnitData* data)
 	damageMolecula_ = data->damageMolecula;
 	if(data->unitID)
 		(terUnitID&)*this = terUnitID(Player->registerUnitID(data->unitID), playerID());
+	Player->updateUnitIndex(this);
 }
 
 void terUnitBase::showDebugInfo()
@@ -4,6 +4,7 @@
 #include "UnitAttribute.h"
 #include "Grid2D.h"
 #include "CommonCommands.h"
+#include "MemoryPool.h"
 
 #if !defined(_MSC_VER) || (_MSC_VER >= 1900)
 #include <functional> // mem_fn, not_fn
@@ -31,6 +32,8 @@ private:
 class terUnitBase : public terUnitID, public ShareHandleBaseSerializeVirtual
 {
 public:
+	SLAB_ALLOCATION_DECLARATION
+
 	terUnitBase(const UnitTemplate& data);
 	virtual ~terUnitBase();
 
@@ -167,7 +170,7 @@ public:
 	virtual int isSingleSelection(){ return 0; }
 
 	int unitClass() const { return unitClass_; }
-	void setUnitClass(int unit_class){ unitClass_ = unit_class; }
+	void setUnitClass(int unit_class);
 
 	//-------------------------------------
 	virtual bool isConstructed() const { return true; }
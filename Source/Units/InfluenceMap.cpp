@@ -0,0 +1,341 @@
+#include "StdAfx.h"
+
+#include "Universe.h"
+#include "GenericUnit.h"
+#include "InfluenceMap.h"
+
+InfluenceMap::InfluenceMap()
+{
+	sizeX_ = sizeY_ = 0;
+	stamp_ = 0;
+	valid_ = false;
+	changedUnits_ = 0;
+	maxRadius_ = 0;
+
+	int async = 0;
+	check_command_line_parameter("influence_map_async", async);
+	async_ = async != 0;
+	pending_ = false;
+	quit_ = false;
+	thread_ = 0;
+	mutex_ = 0;
+	work_cond_ = 0;
+	done_cond_ = 0;
+}
+
+InfluenceMap::~InfluenceMap()
+{
+	stopWorker();
+}
+
+void InfluenceMap::clear()
+{
+	sync();
+	layers_.clear();
+	units_.clear();
+	sizeX_ = sizeY_ = 0;
+	valid_ = false;
+}
+
+bool InfluenceMap::layersMatch(const PlayerVect& players) const
+{
+	if(layers_.size() != players.size())
+		return false;
+	for(int i = 0; i < players.size(); i++)
+		if(layers_[i].player != players[i] || layers_[i].clan != players[i]->clan())
+			return false;
+	return true;
+}
+
+void InfluenceMap::reset(const PlayerVect& players, int map_size_x, int map_size_y)
+{
+	xassert(players.size() <= LAYERS_MAX);
+
+	sizeX_ = (map_size_x >> CELL_SHIFT) + 1;
+	sizeY_ = (map_size_y >> CELL_SHIFT) + 1;
+	int cells = sizeX_*sizeY_;
+
+	units_.clear();
+	layers_.resize(players.size());
+	for(int i = 0; i < players.size(); i++){
+		Layer& layer = layers_[i];
+		layer.player = players[i];
+		layer.clan = players[i]->clan();
+		layer.strength.assign(cells, 0);
+		layer.count.assign(cells, 0);
+		layer.distance.assign(cells, DISTANCE_INF);
+		layer.distanceDirty = false;
+	}
+}
+
+void InfluenceMap::apply(const Presence& presence, int sign)
+{
+	for(int i = 0; i < layers_.size(); i++){
+		if(!(presence.enemyMask & (1u << i)))
+			continue;
+		Layer& layer = layers_[i];
+		layer.strength[presence.cell] += sign*presence.strength;
+		int& count = layer.count[presence.cell];
+		count += sign;
+		xassert(count >= 0);
+		// Расстояния меняются, только если ячейка опустела или заселилась
+		if(count == (sign > 0 ? 1 : 0))
+			layer.distanceDirty = true;
+	}
+}
+
+void InfluenceMap::update(const PlayerVect& players, int map_size_x, int map_size_y)
+{
+	start_timer_auto(InfluenceMapUpdate, STATISTICS_GROUP_LOGIC);
+	MTL();
+	sync();
+
+	if(!valid_ || !layersMatch(players) || sizeX_ != (map_size_x >> CELL_SHIFT) + 1 || sizeY_ != (map_size_y >> CELL_SHIFT) + 1)
+		reset(players, map_size_x, map_size_y);
+	valid_ = true;
+
+	stamp_++;
+	changedUnits_ = 0;
+	maxRadius_ = 0;
+
+	for(int p = 0; p < players.size(); p++){
+		const terPlayer* owner = players[p];
+
+		// Для кого юниты owner - возможные враги, в зависимости от enemyWorld юнита
+		unsigned int enemyMask[2] = { 0, 0 };
+		for(int i = 0; i < layers_.size(); i++){
+			const terPlayer* viewer = layers_[i].player;
+			for(int enemyWorld = 0; enemyWorld < 2; enemyWorld++){
+				bool enemy = viewer->clan() != owner->clan() ?
+					!owner->isWorld() || enemyWorld :
+					viewer->isWorld() && !enemyWorld;
+				if(enemy)
+					enemyMask[enemyWorld] |= 1u << i;
+			}
+		}
+
+		const UnitList& units = players[p]->units();
+		UnitList::const_iterator ui;
+		FOR_EACH(units, ui){
+			terUnitGeneric* unit = dynamic_cast<terUnitGeneric*>(*ui);
+			if(!unit || !unit->inserted() || !unit->alive())
+				continue;
+
+			Presence presence;
+			Vect2f position = unit->position2D();
+			int x = clamp(xm::round(position.x), 0, map_size_x - 1) >> CELL_SHIFT;
+			int y = clamp(xm::round(position.y), 0, map_size_y - 1) >> CELL_SHIFT;
+			presence.cell = y*sizeX_ + x;
+			presence.strength = unit->damageMolecula().aliveElementCount();
+			presence.enemyMask = enemyMask[unit->attr()->enemyWorld ? 1 : 0];
+			presence.stamp = stamp_;
+			if(maxRadius_ < unit->radius())
+				maxRadius_ = unit->radius();
+
+			std::unordered_map<const terUnitBase*, Presence>::iterator i = units_.find(unit);
+			if(i != units_.end()){
+				Presence& old = i->second;
+				if(old.cell == presence.cell && old.strength == presence.strength && old.enemyMask == presence.enemyMask){
+					old.stamp = stamp_;
+					continue;
+				}
+				apply(old, -1);
+				old = presence;
+			}
+			else
+				units_.insert(std::make_pair(unit, presence));
+			apply(presence, 1);
+			changedUnits_++;
+		}
+	}
+
+	// Удаленные и погибшие юниты
+	for(std::unordered_map<const terUnitBase*, Presence>::iterator i = units_.begin(); i != units_.end();){
+		if(i->second.stamp != stamp_){
+			apply(i->second, -1);
+			i = units_.erase(i);
+			changedUnits_++;
+		}
+		else
+			++i;
+	}
+
+	if(async_){
+		startWorker();
+		if(thread_){
+			SDL_LockMutex(mutex_);
+			pending_ = true;
+			SDL_CondSignal(work_cond_);
+			SDL_UnlockMutex(mutex_);
+			return;
+		}
+	}
+	computeDistances();
+}
+
+void InfluenceMap::computeDistances()
+{
+	for(int i = 0; i < layers_.size(); i++)
+		if(layers_[i].distanceDirty){
+			distanceTransform(layers_[i]);
+			layers_[i].distanceDirty = false;
+		}
+}
+
+void InfluenceMap::distanceTransform(Layer& layer)
+{
+	// Расстояние в ячейках по максимуму из dx, dy, два прохода
+	std::vector<unsigned short>& d = layer.distance;
+	for(int i = 0; i < d.size(); i++)
+		d[i] = layer.count[i] ? 0 : DISTANCE_INF;
+
+	for(int y = 0; y < sizeY_; y++)
+		for(int x = 0; x < sizeX_; x++){
+			int i = y*sizeX_ + x;
+			int v = d[i];
+			if(x > 0)
+				v = min(v, d[i - 1] + 1);
+			if(y > 0){
+				v = min(v, d[i - sizeX_] + 1);
+				if(x > 0)
+					v = min(v, d[i - sizeX_ - 1] + 1);
+				if(x < sizeX_ - 1)
+					v = min(v, d[i - sizeX_ + 1] + 1);
+			}
+			d[i] = min(v, int(DISTANCE_INF));
+		}
+
+	for(int y = sizeY_ - 1; y >= 0; y--)
+		for(int x = sizeX_ - 1; x >= 0; x--){
+			int i = y*sizeX_ + x;
+			int v = d[i];
+			if(x < sizeX_ - 1)
+				v = min(v, d[i + 1] + 1);
+			if(y < sizeY_ - 1){
+				v = min(v, d[i + sizeX_] + 1);
+				if(x < sizeX_ - 1)
+					v = min(v, d[i + sizeX_ + 1] + 1);
+				if(x > 0)
+					v = min(v, d[i + sizeX_ - 1] + 1);
+			}
+			d[i] = min(v, int(DISTANCE_INF));
+		}
+}
+
+const InfluenceMap::Layer* InfluenceMap::layer(const terPlayer* viewer)
+{
+	MTL();
+	sync();
+	for(int i = 0; i < layers_.size(); i++)
+		if(layers_[i].player == viewer)
+			return &layers_[i];
+	return 0;
+}
+
+float InfluenceMap::enemyDistanceMin(const terPlayer* viewer, const Vect2f& pos)
+{
+	const Layer* l = layer(viewer);
+	// Карта еще не строилась - ничего не обещаем
+	if(!l)
+		return 0;
+
+	int x = clamp(xm::round(pos.x) >> CELL_SHIFT, 0, sizeX_ - 1);
+	int y = clamp(xm::round(pos.y) >> CELL_SHIFT, 0, sizeY_ - 1);
+	int d = l->distance[y*sizeX_ + x];
+	if(d == DISTANCE_INF)
+		return FLT_INF;
+	// Между точками ячеек, отстоящих на d, не меньше (d - 1) ячеек,
+	// радиусы и запас учитываются так же, как в UnitQueryCache::collect
+	return max(float((d - 1) << CELL_SHIFT) - maxRadius_ - POSITION_MARGIN, 0.f);
+}
+
+int InfluenceMap::enemyStrength(const terPlayer* viewer, const Vect2f& pos, float radius)
+{
+	const Layer* l = layer(viewer);
+	if(!l)
+		return 0;
+
+	int x0 = clamp(xm::round(pos.x - radius) >> CELL_SHIFT, 0, sizeX_ - 1);
+	int y0 = clamp(xm::round(pos.y - radius) >> CELL_SHIFT, 0, sizeY_ - 1);
+	int x1 = clamp(xm::round(pos.x + radius) >> CELL_SHIFT, 0, sizeX_ - 1);
+	int y1 = clamp(xm::round(pos.y + radius) >> CELL_SHIFT, 0, sizeY_ - 1);
+
+	int strength = 0;
+	for(int y = y0; y <= y1; y++)
+		for(int x = x0; x <= x1; x++)
+			strength += l->strength[y*sizeX_ + x];
+	return strength;
+}
+
+//////////////////////////////////////////////////////////////////
+//	Рабочий поток
+//////////////////////////////////////////////////////////////////
+void InfluenceMap::startWorker()
+{
+	if(thread_)
+		return;
+	mutex_ = SDL_CreateMutex();
+	work_cond_ = SDL_CreateCond();
+	done_cond_ = SDL_CreateCond();
+	quit_ = false;
+	thread_ = SDL_CreateThread(worker, "influence_map", this);
+	if(!thread_){
+		fprintf(stderr, "InfluenceMap: SDL_CreateThread failed: %s\n", SDL_GetError());
+		// Дальше считаем в логическом потоке
+		async_ = false;
+		stopWorker();
+	}
+}
+
+void InfluenceMap::stopWorker()
+{
+	if(thread_){
+		SDL_LockMutex(mutex_);
+		quit_ = true;
+		SDL_CondSignal(work_cond_);
+		SDL_UnlockMutex(mutex_);
+		SDL_WaitThread(thread_, 0);
+		thread_ = 0;
+	}
+	if(mutex_){
+		SDL_DestroyCond(done_cond_);
+		SDL_DestroyCond(work_cond_);
+		SDL_DestroyMutex(mutex_);
+		done_cond_ = work_cond_ = 0;
+		mutex_ = 0;
+	}
+	pending_ = false;
+}
+
+void InfluenceMap::sync()
+{
+	if(!thread_)
+		return;
+	SDL_LockMutex(mutex_);
+	while(pending_)
+		SDL_CondWait(done_cond_, mutex_);
+	SDL_UnlockMutex(mutex_);
+}
+
+int InfluenceMap::worker(void* data)
+{
+	static_cast<InfluenceMap*>(data)->run();
+	return 0;
+}
+
+void InfluenceMap::run()
+{
+	SDL_LockMutex(mutex_);
+	while(!quit_){
+		if(!pending_){
+			SDL_CondWait(work_cond_, mutex_);
+			continue;
+		}
+		SDL_UnlockMutex(mutex_);
+		computeDistances();
+		SDL_LockMutex(mutex_);
+		pending_ = false;
+		SDL_CondBroadcast(done_cond_);
+	}
+	SDL_UnlockMutex(mutex_);
+}
@@ -0,0 +1,100 @@
+#ifndef __INFLUENCE_MAP_H__
+#define __INFLUENCE_MAP_H__
+
+#include <unordered_map>
+
+class terPlayer;
+class terUnitBase;
+typedef std::vector<terPlayer*> PlayerVect;
+
+//////////////////////////////////////////////////////////////////
+//  Карты угрозы для каждого игрока.
+//  В крупных ячейках хранится сила юнитов, которые могут быть
+//  врагами игрока (см. terUnitBase::isEnemy), и расстояние до
+//  ближайшей ячейки с такими юнитами. Вклад юнита меняется, только
+//  когда он переходит в другую ячейку, теряет элементы или умирает.
+//  Строится в том же кванте и по тем же юнитам, что UnitQueryCache,
+//  поэтому отрицательный ответ enemiesAround позволяет не сканировать.
+//  Расстояния можно пересчитывать в рабочем потоке, пока идет
+//  MoveQuant (influence_map_async=1), результат от этого не меняется.
+//////////////////////////////////////////////////////////////////
+class InfluenceMap
+{
+public:
+	InfluenceMap();
+	~InfluenceMap();
+
+	void update(const PlayerVect& players, int map_size_x, int map_size_y);
+	void clear();
+
+	// Нижняя оценка расстояния от pos до краев возможных врагов viewer,
+	// FLT_INF если их нет
+	float enemyDistanceMin(const terPlayer* viewer, const Vect2f& pos);
+	// false - в радиусе точно нет ни одного врага
+	bool enemiesAround(const terPlayer* viewer, const Vect2f& pos, float radius) { return enemyDistanceMin(viewer, pos) <= radius; }
+	// Сумма живых элементов возможных врагов в ячейках, задетых квадратом
+	int enemyStrength(const terPlayer* viewer, const Vect2f& pos, float radius);
+
+	// Юнитов, сменивших вклад при последнем обновлении
+	int changedUnits() const { return changedUnits_; }
+
+private:
+	enum {
+		CELL_SHIFT = 6,
+		// Запас на перемещение юнитов с момента построения, как в UnitQueryCache
+		POSITION_MARGIN = 32,
+		DISTANCE_INF = 0xffff,
+		LAYERS_MAX = 32
+	};
+
+	struct Presence
+	{
+		int cell;
+		int strength;
+		unsigned int enemyMask; // слои, для которых юнит - возможный враг
+		unsigned int stamp;
+	};
+
+	// Карта одного игрока-наблюдателя
+	struct Layer
+	{
+		const terPlayer* player;
+		int clan;
+		std::vector<int> strength;
+		std::vector<int> count;
+		std::vector<unsigned short> distance;
+		bool distanceDirty;
+	};
+
+	std::vector<Layer> layers_;
+	std::unordered_map<const terUnitBase*, Presence> units_;
+	int sizeX_, sizeY_;
+	unsigned int stamp_;
+	bool valid_;
+	int changedUnits_;
+	float maxRadius_;
+
+	bool async_;
+	bool pending_;
+	bool quit_;
+	SDL_Thread* thread_;
+	SDL_mutex* mutex_;
+	SDL_cond* work_cond_;
+	SDL_cond* done_cond_;
+
+	bool layersMatch(const PlayerVect& players) const;
+	void reset(const PlayerVect& players, int map_size_x, int map_size_y);
+	void apply(const Presence& presence, int sign);
+	const Layer* layer(const terPlayer* viewer);
+
+	void computeDistances();
+	void distanceTransform(Layer& layer);
+
+	void startWorker();
+	void stopWorker();
+	void sync();
+	static int worker(void* data);
+	void run();
+};
+
+#endif //__INFLUENCE_MAP_H__
@@ -746,7 +746,7 @@ void terUnitReal::moveToPoint(const Vect3f& v)
 		recalcPathTimer_.stop();
 	}
 	if(!pathFindSucceeded_ && !recalcPathTimer_){
-		pathFindSucceeded_ = ai_tile_map->findPath(Vect2i(position2D()), pathFindTarget_, pathFindList_, AITileMap::PATH_NORMAL);
+		pathFindSucceeded_ = ai_tile_map->findSharedPath(Vect2i(position2D()), pathFindTarget_, pathFindList_, AITileMap::PATH_NORMAL);
 		recalcPathTimer_.start(1000);
 	}
 	
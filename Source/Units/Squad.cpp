@@ -1552,7 +1552,7 @@ void terUnitSquad::addWayPoint(const Vect2f& point, bool bypassPathfinder)
         bypassPathfinder = true;
     }
     
-	if (!bypassPathfinder && ai_tile_map->findPath(wayPoints_.empty() ? position2D() : wayPoints_.back(), point, pathFindList, AITileMap::PATH_NORMAL)) {
+	if (!bypassPathfinder && ai_tile_map->findSharedPath(wayPoints_.empty() ? position2D() : wayPoints_.back(), point, pathFindList, AITileMap::PATH_NORMAL)) {
         for (auto& i : pathFindList) {
             wayPoints_.push_back(i);
         }
@@ -1918,7 +1918,8 @@ private:
 terUnitBase* terUnitSquad::findBestTarget(const Vect2f& pos, float radius)
 {
 	SquadSearchTargetScanOp op(pos, radius, *this);
-	universe()->UnitGrid.Scan(pos.x, pos.y, radius, op);
+	if(universe()->influenceMap.enemiesAround(Player, pos, radius))
+		universe()->unitQuery.scanEnemies(this, pos, radius, op);
 	return op.result();
 }
 
@@ -1982,7 +1983,9 @@ void terUnitSquad::attackQuant()
 				float fire_radius = offensiveMode() && !patrolMode() ? currentAttribute()->sightRadius() : currentAttribute()->fireRadius();
 				fire_radius += radius();
 				SquadSearchTargetsScanOp op(position2D(), fire_radius, *this);
-				universe()->UnitGrid.Scan(position().x, position().y, fire_radius, op);
+				// Список целей нужен только с врагами, ремонт ищется отдельно
+				if(universe()->influenceMap.enemiesAround(Player, position2D(), fire_radius))
+					universe()->unitQuery.scan(position2D(), fire_radius, op);
 				op.sortTargets();
 
 				if(!targets_clean_timer()){
@@ -2049,7 +2052,7 @@ void terUnitSquad::attackQuant()
                     repositionToAttack(ap);
                 }
 
-				targets_scan_timer.start(squad_targets_scan_period);
+				targets_scan_timer.start(universe()->unitQuery.staggeredPeriod(this, squad_targets_scan_period));
 			}
 			else {
 //				SquadUnitList::iterator ui;
@@ -2302,13 +2305,13 @@ void terUnitSquad::techniciansQuant()
 		}
 	}
 
-	technician_targets_scan_timer.start(squad_technician_targets_scan_period);
+	technician_targets_scan_timer.start(universe()->unitQuery.staggeredPeriod(this, squad_technician_targets_scan_period));
 	if(!flag) return;
 
 	float fire_radius = offensiveMode() && !patrolMode() ? currentAttribute()->sightRadius() : currentAttribute()->fireRadius();
 	fire_radius += radius();
 	SquadTechnicianSearchTargetsScanOp op(position2D(), fire_radius, *this);
-	universe()->UnitGrid.Scan(position().x, position().y, fire_radius, op);
+	universe()->unitQuery.scan(position2D(), fire_radius, op);
 	op.sortTargets();
 
 	if(op.targets().empty()) return;
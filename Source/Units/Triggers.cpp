@@ -190,6 +190,11 @@ void ConditionCreateObject::checkEvent(AIPlayer& aiPlayer, const Event* event)
 	}
 }
 
+int ConditionCreateObject::eventMask() const
+{
+	return Event::mask(Event::CREATE_OBJECT) | Event::mask(Event::DESTROY_OBJECT);
+}
+
 void ConditionKillObject::checkEvent(AIPlayer& aiPlayer, const Event* event) 
 {
 	if(event->type() == Event::ATTACK_OBJECT){
@@ -202,6 +207,11 @@ void ConditionKillObject::checkEvent(AIPlayer& aiPlayer, const Event* event)
 	}
 }
 
+int ConditionKillObject::eventMask() const
+{
+	return Event::mask(Event::ATTACK_OBJECT);
+}
+
 void ConditionCaptureBuilding::checkEvent(AIPlayer& aiPlayer, const Event* event) 
 {
 	if(event->type() == Event::CAPTURE_BUILDING){
@@ -211,6 +221,11 @@ void ConditionCaptureBuilding::checkEvent(AIPlayer& aiPlayer, const Event* event
 	}
 }
 
+int ConditionCaptureBuilding::eventMask() const
+{
+	return Event::mask(Event::CAPTURE_BUILDING);
+}
+
 bool ConditionObjectByLabelExists::check(AIPlayer& aiPlayer) 
 { 
 	return universe()->findUnitByLabel(label);
@@ -225,6 +240,11 @@ void ConditionKillObjectByLabel::checkEvent(AIPlayer& aiPlayer, const Event* eve
 	}
 }
 
+int ConditionKillObjectByLabel::eventMask() const
+{
+	return Event::mask(Event::DESTROY_OBJECT);
+}
+
 void ConditionTimeMatched::checkEvent(AIPlayer& aiPlayer, const Event* event) 
 {
 	if(event->type() == Event::TIME){
@@ -234,12 +254,22 @@ void ConditionTimeMatched::checkEvent(AIPlayer& aiPlayer, const Event* event)
 	}
 }
 
+int ConditionTimeMatched::eventMask() const
+{
+	return Event::mask(Event::TIME);
+}
+
 void ConditionMouseClick::checkEvent(AIPlayer& aiPlayer, const Event* event) 
 {
 	if(event->type() == Event::MOUSE_CLICK)
 		setSatisfied();
 }
 
+int ConditionMouseClick::eventMask() const
+{
+	return Event::mask(Event::MOUSE_CLICK);
+}
+
 void ConditionClickOnButton::checkEvent(AIPlayer& aiPlayer, const Event* event) 
 {
 	if(event->type() == Event::CLICK_ON_BUTTON &&
@@ -247,6 +277,11 @@ void ConditionClickOnButton::checkEvent(AIPlayer& aiPlayer, const Event* event)
 			counter_++;
 }
 
+int ConditionClickOnButton::eventMask() const
+{
+	return Event::mask(Event::CLICK_ON_BUTTON);
+}
+
 bool ConditionToolzerSelectedNearObjectByLabel::check(AIPlayer& aiPlayer) 
 { 
 	terUnitBase* unit = universe()->findUnitByLabel(label);
@@ -297,6 +332,11 @@ void ConditionActivateSpot::checkEvent(AIPlayer& aiPlayer, const Event* event)
 	}
 }
 
+int ConditionActivateSpot::eventMask() const
+{
+	return Event::mask(Event::ACTIVATE_SPOT);
+}
+
 bool ConditionObjectNearObjectByLabel::check(AIPlayer& aiPlayer)
 {
 	terUnitBase* unit = universe()->findUnitByLabel(label);
@@ -338,6 +378,11 @@ void ConditionTeleportation::checkEvent(AIPlayer& aiPlayer, const Event* event)
 	}
 }
 
+int ConditionTeleportation::eventMask() const
+{
+	return Event::mask(Event::TELEPORTATION);
+}
+
 bool ConditionEnegyLevelLowerReserve::check(AIPlayer& aiPlayer)
 {
 	return aiPlayer.energyData().accumulated() < energyReserve;
@@ -381,6 +426,11 @@ void ConditionUnitClassUnderAttack::checkEvent(AIPlayer& aiPlayer, const Event*
 	}
 }
 
+int ConditionUnitClassUnderAttack::eventMask() const
+{
+	return Event::mask(Event::ATTACK_OBJECT);
+}
+
 void ConditionUnitClassIsGoingToBeAttacked::checkEvent(AIPlayer& aiPlayer, const Event* event)
 {
 	if(event->type() == Event::AIM_AT_OBJECT){
@@ -393,6 +443,11 @@ void ConditionUnitClassIsGoingToBeAttacked::checkEvent(AIPlayer& aiPlayer, const
 	}
 }
 
+int ConditionUnitClassIsGoingToBeAttacked::eventMask() const
+{
+	return Event::mask(Event::AIM_AT_OBJECT);
+}
+
 bool ConditionSquadGoingToAttack::check(AIPlayer& aiPlayer)
 {
 	terUnitSquad* squad = aiPlayer.chooseSquad(chooseSquadID);
@@ -505,6 +560,11 @@ void ConditionPlayerState::checkEvent(AIPlayer& aiPlayer, const Event* event)
 	}
 }
 
+int ConditionPlayerState::eventMask() const
+{
+	return Event::mask(Event::PLAYER_STATE);
+}
+
 bool ConditionIsFieldOn::check(AIPlayer& aiPlayer)
 {
 	return aiPlayer.isFieldOn();
@@ -1615,7 +1675,14 @@ void TriggerChain::quant(AIPlayer& aiPlayer)
 
 void TriggerChain::checkEvent(AIPlayer& aiPlayer, const Event* event)
 {
-	for (auto& ti : activeTriggers_) {
+	static_assert(Event::ACTIVATE_SPOT < EVENT_TYPES_MAX, "Event::Type doesn't fit the subscription mask");
+
+	// Только триггерам, условия которых реагируют на этот тип событий
+	const ActiveTriggers& subscribers = eventSubscribers_[event->type()];
+	eventsReceived_++;
+	eventsDispatched_ += subscribers.size();
+	eventsSkipped_ += activeTriggers_.size() - subscribers.size();
+	for (auto& ti : subscribers) {
         ti->checkEvent(aiPlayer, event);
     }
 }
@@ -1624,12 +1691,14 @@ void TriggerChain::activateTrigger(Trigger* trigger)
 {
 	if (std::find(activeTriggers_.begin(), activeTriggers_.end(), trigger) == activeTriggers_.end()) {
         activeTriggers_.push_back(trigger);
+        subscribe(trigger);
         addLogRecord(*trigger, (std::string("Activate: ") + trigger->name()).c_str());
     }
 }
 
 void TriggerChain::deactivateTrigger(Trigger* trigger)
 {
+	unsubscribe(trigger);
 	auto it = activeTriggers_.erase(remove(activeTriggers_.begin(), activeTriggers_.end(), trigger), activeTriggers_.end());
     if (it != activeTriggers_.end()) {
         addLogRecord(*trigger, (std::string("Discard: ") + trigger->name()).c_str());
@@ -30,6 +30,7 @@ public:
 	};
 	Event(Type type) : type_(type) {}
 	Type type() const { return type_; }
+	static int mask(Type type) { return 1 << type; }
 	virtual ~Event(){}
 
 protected:
@@ -40,6 +40,8 @@ terTerraformGeneral::terTerraformGeneral(int id,int x,int y,terPlayer* player)
 	UnitPoint = NULL;
 	Status = TERRAFORM_STATUS_NONE;
 	CollisionCount = 0;
+	IndexedStatus = 0;
+	DigFillSerial = 0;
 }
 
 terTerraformGeneral::~terTerraformGeneral()
@@ -94,6 +96,7 @@ void terTerraformGeneral::Quant(terTerraformDispatcher* dispatcher,bool first)
 		{
 			dispatcher->TerraformsDigFill.push_front(this);
 			it_self=dispatcher->TerraformsDigFill.begin();
+			DigFillSerial=++dispatcher->DigFillSerial;
 		}else
 		{
 			dispatcher->TerraformsOther.push_front(this);
@@ -105,6 +108,7 @@ void terTerraformGeneral::Quant(terTerraformDispatcher* dispatcher,bool first)
 	}
 
 	ChangeStatus(dispatcher,last_status,Status);
+	dispatcher->UpdateWorkIndex(this);
 }
 
 void terTerraformGeneral::ChangeStatus(terTerraformDispatcher* dispatcher,int begin_status,int end_status)
@@ -656,6 +660,14 @@ terTerraformDispatcher::terTerraformDispatcher(terPlayer* player)
 	zero_complete = 0;
 	abyss_request = 0;
 	abyss_complete = 0;
+
+	WorkBucketsX = (vMap.H_SIZE >> TRUST_MAP_WORK_BUCKET_SHIFT) + 1;
+	WorkBucketsY = (vMap.V_SIZE >> TRUST_MAP_WORK_BUCKET_SHIFT) + 1;
+	for(int i = 0; i < 2; i++){
+		WorkIndexes[i].buckets.resize(WorkBucketsX*WorkBucketsY);
+		WorkIndexes[i].count = 0;
+	}
+	DigFillSerial = 0;
 }
 
 terTerraformDispatcher::~terTerraformDispatcher()
@@ -770,6 +782,7 @@ TerraformList::iterator terTerraformDispatcher::DeleteElement(TerraformList::ite
 {
 	TrustGrid.Remove(**ti);
 	(*ti)->Kill();
+	UpdateWorkIndex(*ti);
 
 	switch((*ti)->Type)
 	{
@@ -872,33 +885,88 @@ void terTerraformDispatcher::ScanTrustMap(int& request_digger,int& request_fille
 	}
 }
 
+terTerraformDispatcher::WorkBucket& terTerraformDispatcher::GetWorkBucket(WorkIndex& index,const terTerraformGeneral* p)
+{
+	int bx = clamp(p->PositionX >> TRUST_MAP_WORK_BUCKET_SHIFT, 0, WorkBucketsX - 1);
+	int by = clamp(p->PositionY >> TRUST_MAP_WORK_BUCKET_SHIFT, 0, WorkBucketsY - 1);
+	return index.buckets[by*WorkBucketsX + bx];
+}
+
+void terTerraformDispatcher::UpdateWorkIndex(terTerraformGeneral* p)
+{
+	int status = p->Alive() ? p->Status & (TERRAFORM_STATUS_DIG | TERRAFORM_STATUS_FILL) : 0;
+	if(status == p->IndexedStatus)
+		return;
+
+	for(int i = 0; i < 2; i++){
+		int bit = i ? TERRAFORM_STATUS_FILL : TERRAFORM_STATUS_DIG;
+		if((status & bit) == (p->IndexedStatus & bit))
+			continue;
+		WorkIndex& index = WorkIndexes[i];
+		WorkBucket& bucket = GetWorkBucket(index, p);
+		if(status & bit){
+			bucket.push_back(p);
+			index.count++;
+		}
+		else{
+			WorkBucket::iterator bi = std::find(bucket.begin(), bucket.end(), p);
+			xassert(bi != bucket.end());
+			*bi = bucket.back();
+			bucket.pop_back();
+			index.count--;
+		}
+	}
+	p->IndexedStatus = status;
+}
+
 terTerraformGeneral* terTerraformDispatcher::FindNear(int TerraformTypes, terTerraformStatus status, int x,int y, int id)
 {
-//	int size_df=TerraformsDigFill.size();
-//	int size_oter=TerraformsOther.size();
 	xassert(status==TERRAFORM_STATUS_DIG || status==TERRAFORM_STATUS_FILL);
 
+	QuantStats.searches++;
+	WorkIndex& index = WorkIndexes[status == TERRAFORM_STATUS_DIG ? 0 : 1];
+	if(!index.count)
+		return 0;
+
+	int bx = clamp(x >> TRUST_MAP_WORK_BUCKET_SHIFT, 0, WorkBucketsX - 1);
+	int by = clamp(y >> TRUST_MAP_WORK_BUCKET_SHIFT, 0, WorkBucketsY - 1);
+	int r_max = max(WorkBucketsX, WorkBucketsY);
+
 	terTerraformGeneral* p = NULL;
 	int md = 0;
-	TerraformList::iterator ti;
-	FOR_EACH(TerraformsDigFill, ti){
-		terTerraformGeneral& t = **ti;
-		if( (t.Type | TerraformTypes) && 
-			(id == -1 || t.ID == id) && 
-			!t.UnitPoint && (t.Status & status)
-		  )
-		{
-			int d = sqr(x - t.PositionX) + sqr(y - t.PositionY);			
-			if(d < md || !p){
-				md = d;
-				p = &t;
+	for(int r = 0; r <= r_max; r++){
+		// Все ячейки кольца r отстоят от точки не меньше чем на r - 1 ячейку
+		if(p && r > 0 && sqr((r - 1) << TRUST_MAP_WORK_BUCKET_SHIFT) > md)
+			break;
+
+		for(int yy = max(by - r, 0); yy <= min(by + r, WorkBucketsY - 1); yy++){
+			int step = (yy == by - r || yy == by + r) ? 1 : 2*r;
+			for(int xx = bx - r; xx <= bx + r; xx += step){
+				if(xx < 0 || xx >= WorkBucketsX)
+					continue;
+				WorkBucket& bucket = index.buckets[yy*WorkBucketsX + xx];
+				WorkBucket::iterator bi;
+				FOR_EACH(bucket, bi){
+					terTerraformGeneral& t = **bi;
+					QuantStats.search_visited++;
+					if( (t.Type | TerraformTypes) && 
+						(id == -1 || t.ID == id) && 
+						!t.UnitPoint
+					  )
+					{
+						// При равных расстояниях - первый в TerraformsDigFill, как при обходе списка
+						int d = sqr(x - t.PositionX) + sqr(y - t.PositionY);			
+						if(!p || d < md || (d == md && t.DigFillSerial > p->DigFillSerial)){
+							md = d;
+							p = &t;
+						}
+					}
+				}
 			}
 		}
 	}
-	if(p) 
-		return p;
 
-	return 0;
+	return p;
 }
 
 terTerraformGeneral* terTerraformDispatcher::FindNearDigger(int x,int y)
@@ -1609,6 +1677,19 @@ terTerraformAbyssBorder::terTerraformAbyssBorder(int id,int x,int y,terPlayer* p
 	RegionPoint = player->AbyssRegionPoint;
 }
 
+void terTerraformDispatcher::StatsQuant()
+{
+	LastQuantStats = QuantStats;
+	QuantStats.clear();
+
+#ifndef _FINAL_VERSION_
+	watch_i(LastQuantStats.update_scanned, Player->playerID());
+	watch_i(LastQuantStats.update_quants, Player->playerID());
+	watch_i(LastQuantStats.search_visited, Player->playerID());
+	watch_i(LastQuantStats.searches, Player->playerID());
+#endif
+}
+
 void terTerraformDispatcher::GetWorkAreaStats(int& zero_request,int& zero_complete,int& abyss_request,int& abyss_complete)
 {
 #ifdef _DEBUG
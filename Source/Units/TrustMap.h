@@ -4,6 +4,7 @@
 #include "Handle.h"
 #include "Grid2D.h"
 #include "Region.h"
+#include "MemoryPool.h"
 
 class terPlayer;
 struct terTerraformGeneral;
@@ -57,6 +58,8 @@ enum terTerraformType
 
 struct terTerraformGeneral : GridElementType, SharedObject
 {
+	SLAB_ALLOCATION_DECLARATION
+
 	terTerraformType Type;
 	TerraformList::iterator it_self;//Если Type==TERRAFORM_STATUS_NONE то неиницализирован.
 
@@ -67,6 +70,9 @@ struct terTerraformGeneral : GridElementType, SharedObject
 	int Status;
 	terUnitBase* UnitPoint;
 
+	int IndexedStatus; // под какими статусами лежит в корзинах поиска работы
+	unsigned int DigFillSerial; // порядок попадания в TerraformsDigFill, больше - ближе к началу
+
 	terPlayer* Player;
 
 	terTerraformGeneral(int id,int x,int y,terPlayer* player);
@@ -194,6 +200,20 @@ const int TRUST_MAP_GARBAGE_SIZE = 16;
 const int TRUST_MAP_GARBAGE_TEST_SIZE = 32;
 const int TRUST_MAP_GARBAGE_LEVEL = 128;
 
+const int TRUST_MAP_WORK_BUCKET_SHIFT = 7;
+
+// Сколько элементов просмотрено за квант
+struct terTrustMapStats
+{
+	int update_scanned; // обновление по измененным областям карты
+	int update_quants; // из них пересчитано
+	int search_visited; // поиск работы для бригадиров
+	int searches;
+
+	terTrustMapStats(){ clear(); }
+	void clear(){ update_scanned = update_quants = search_visited = searches = 0; }
+};
+
 class terTerraformDispatcher
 {
 public:
@@ -218,6 +238,12 @@ public:
 
 	terTrustGrid TrustGrid; // Сетка не содержит мертвых элементов
 	terPlayer* GetPlayer(){return Player;}
+	bool Empty() const { return TerraformsDigFill.empty() && TerraformsOther.empty(); }
+
+	terTrustMapStats& GetQuantStats(){ return QuantStats; }
+	const terTrustMapStats& GetLastQuantStats() const { return LastQuantStats; }
+	void StatsQuant();
+
 private:
 	int Count;
 	terPlayer* Player;
@@ -225,6 +251,23 @@ private:
 	TerraformList TerraformsDigFill,TerraformsOther;
 	friend terTerraformGeneral;
 
+	// Элементы TerraformsDigFill по статусам DIG и FILL, разложенные по
+	// крупным ячейкам: ближайшая работа ищется по кольцам ячеек вокруг точки
+	typedef std::vector<terTerraformGeneral*> WorkBucket;
+	struct WorkIndex
+	{
+		std::vector<WorkBucket> buckets;
+		int count;
+	};
+	WorkIndex WorkIndexes[2]; // DIG, FILL
+	int WorkBucketsX,WorkBucketsY;
+	unsigned int DigFillSerial;
+
+	terTrustMapStats QuantStats,LastQuantStats;
+
+	void UpdateWorkIndex(terTerraformGeneral* p);
+	WorkBucket& GetWorkBucket(WorkIndex& index,const terTerraformGeneral* p);
+
 	terTerraformGeneral* FindNear(int TerraformTypes, terTerraformStatus status, int x,int y, int id = -1);
 	TerraformList::iterator DeleteElement(TerraformList::iterator ti);
 
@@ -0,0 +1,131 @@
+#include "StdAfx.h"
+
+#include "Universe.h"
+#include "GenericUnit.h"
+#include "UnitQueryCache.h"
+
+UnitQueryCache::UnitQueryCache()
+{
+	sizeX_ = sizeY_ = 0;
+	quant_ = 0;
+	depth_ = 0;
+	queries_ = 0;
+	candidates_ = 0;
+}
+
+void UnitQueryCache::clear()
+{
+	players_.clear();
+	sizeX_ = sizeY_ = 0;
+}
+
+terUnitBase* UnitQueryCache::unitBase(terUnitGeneric* unit)
+{
+	return unit;
+}
+
+void UnitQueryCache::build(const PlayerVect& players, int quant, int map_size_x, int map_size_y)
+{
+	start_timer_auto(UnitQueryCacheBuild, STATISTICS_GROUP_LOGIC);
+	MTL();
+	xassert(!depth_);
+
+	quant_ = quant;
+	queries_ = 0;
+	candidates_ = 0;
+
+	sizeX_ = (map_size_x >> CELL_SHIFT) + 1;
+	sizeY_ = (map_size_y >> CELL_SHIFT) + 1;
+	int cells = sizeX_*sizeY_;
+
+	players_.resize(players.size());
+	for(int i = 0; i < players.size(); i++){
+		PlayerCell& pc = players_[i];
+		pc.player = players[i];
+		pc.entries.clear();
+		pc.maxRadius = 0;
+
+		const UnitList& units = players[i]->units();
+		UnitList::const_iterator ui;
+		FOR_EACH(units, ui){
+			terUnitGeneric* unit = dynamic_cast<terUnitGeneric*>(*ui);
+			if(!unit || !unit->inserted() || !unit->alive())
+				continue;
+
+			Entry e;
+			e.unit = unit;
+			e.position = unit->position2D();
+			e.radius = unit->radius();
+			int x = clamp(xm::round(e.position.x), 0, map_size_x - 1) >> CELL_SHIFT;
+			int y = clamp(xm::round(e.position.y), 0, map_size_y - 1) >> CELL_SHIFT;
+			e.cell = y*sizeX_ + x;
+			e.unitID = unit->unitID();
+			e.playerID = unit->playerID();
+			pc.entries.push_back(e);
+
+			if(pc.maxRadius < e.radius)
+				pc.maxRadius = e.radius;
+		}
+
+		// Сортировка по ячейкам, внутри ячейки - по ID для детерминированности
+		std::sort(pc.entries.begin(), pc.entries.end(), [](const Entry& e0, const Entry& e1) {
+			return std::tie(e0.cell, e0.unitID) < std::tie(e1.cell, e1.unitID);
+		});
+
+		pc.cellStart.assign(cells + 1, 0);
+		for(int j = 0; j < pc.entries.size(); j++)
+			pc.cellStart[pc.entries[j].cell + 1]++;
+		for(int c = 0; c < cells; c++)
+			pc.cellStart[c + 1] += pc.cellStart[c];
+	}
+}
+
+void UnitQueryCache::collect(const terUnitBase* owner, const Vect2f& center, float radius, CandidateList& out)
+{
+	MTL();
+	queries_++;
+	out.clear();
+
+	std::vector<PlayerCell>::const_iterator pi;
+	FOR_EACH(players_, pi){
+		const PlayerCell& pc = *pi;
+		if(pc.entries.empty())
+			continue;
+
+		// Внутри клана враги бывают только у мира, см. terUnitBase::isEnemy
+		if(owner && owner->Player->clan() == pc.player->clan() && !owner->Player->isWorld())
+			continue;
+
+		float r = radius + pc.maxRadius + POSITION_MARGIN;
+		int x0 = clamp(xm::round(center.x - r) >> CELL_SHIFT, 0, sizeX_ - 1);
+		int y0 = clamp(xm::round(center.y - r) >> CELL_SHIFT, 0, sizeY_ - 1);
+		int x1 = clamp(xm::round(center.x + r) >> CELL_SHIFT, 0, sizeX_ - 1);
+		int y1 = clamp(xm::round(center.y + r) >> CELL_SHIFT, 0, sizeY_ - 1);
+
+		for(int y = y0; y <= y1; y++){
+			for(int x = x0; x <= x1; x++){
+				int cell = y*sizeX_ + x;
+				for(int j = pc.cellStart[cell]; j < pc.cellStart[cell + 1]; j++){
+					const Entry& e = pc.entries[j];
+					float dist2 = center.distance2(e.position);
+					if(dist2 > sqr(radius + e.radius + POSITION_MARGIN))
+						continue;
+					Candidate c;
+					c.entry = &e;
+					c.dist2 = dist2;
+					out.push_back(c);
+				}
+			}
+		}
+	}
+
+	std::sort(out.begin(), out.end());
+	candidates_ += out.size();
+}
+
+int UnitQueryCache::staggeredPeriod(const terUnitBase* unit, int period) const
+{
+	unsigned int spread = period/2 + 1;
+	unsigned int hash = unit->unitID()*2654435761u + unit->playerID()*40503u + quant_;
+	return period - period/4 + (hash >> 8) % spread;
+}
@@ -0,0 +1,114 @@
+#ifndef __UNIT_QUERY_CACHE_H__
+#define __UNIT_QUERY_CACHE_H__
+
+#include <deque>
+
+class terPlayer;
+class terUnitBase;
+class terUnitGeneric;
+typedef std::vector<terPlayer*> PlayerVect;
+
+//////////////////////////////////////////////////////////////////
+//  Кэш для поиска целей.
+//  Строится один раз за квант: юниты каждого игрока раскладываются
+//  по крупным ячейкам, запросы "юниты в радиусе R" отвечаются без
+//  повторного сканирования UnitGrid.
+//  Порядок обхода детерминирован: по расстоянию, затем по (unitID, playerID).
+//////////////////////////////////////////////////////////////////
+class UnitQueryCache
+{
+public:
+	UnitQueryCache();
+
+	void build(const PlayerVect& players, int quant, int map_size_x, int map_size_y);
+	void clear();
+
+	// Все юниты в радиусе
+	template<class Op>
+	void scan(const Vect2f& center, float radius, Op& op) {
+		scanInternal(0, center, radius, op);
+	}
+
+	// Только юниты игроков, среди которых могут быть враги owner
+	template<class Op>
+	void scanEnemies(const terUnitBase* owner, const Vect2f& center, float radius, Op& op) {
+		scanInternal(owner, center, radius, op);
+	}
+
+	// Период перепоиска целей, разнесенный по юнитам, чтобы поиски
+	// одновременно созданных юнитов не приходились на один квант.
+	// Среднее значение равно period.
+	int staggeredPeriod(const terUnitBase* unit, int period) const;
+
+	int queries() const { return queries_; }
+	int candidates() const { return candidates_; }
+
+private:
+	enum {
+		CELL_SHIFT = 7,
+		// Запас на перемещение юнитов с момента построения кэша
+		POSITION_MARGIN = 32
+	};
+
+	struct Entry
+	{
+		terUnitGeneric* unit;
+		Vect2f position;
+		float radius;
+		int cell;
+		unsigned int unitID;
+		unsigned int playerID;
+	};
+
+	struct Candidate
+	{
+		const Entry* entry;
+		float dist2;
+
+		bool operator < (const Candidate& c) const {
+			if(dist2 != c.dist2)
+				return dist2 < c.dist2;
+			if(entry->unitID != c.entry->unitID)
+				return entry->unitID < c.entry->unitID;
+			return entry->playerID < c.entry->playerID;
+		}
+	};
+	typedef std::vector<Candidate> CandidateList;
+
+	struct PlayerCell
+	{
+		const terPlayer* player;
+		std::vector<Entry> entries;
+		std::vector<int> cellStart;
+		float maxRadius;
+	};
+
+	std::vector<PlayerCell> players_;
+	int sizeX_, sizeY_;
+	int quant_;
+
+	// Вложенные запросы из операторов получают собственный буфер
+	std::deque<CandidateList> buffers_;
+	int depth_;
+
+	int queries_;
+	int candidates_;
+
+	void collect(const terUnitBase* owner, const Vect2f& center, float radius, CandidateList& out);
+
+	template<class Op>
+	void scanInternal(const terUnitBase* owner, const Vect2f& center, float radius, Op& op) {
+		if(depth_ >= buffers_.size())
+			buffers_.resize(depth_ + 1);
+		CandidateList& list = buffers_[depth_++];
+		collect(owner, center, radius, list);
+		for(int i = 0; i < list.size(); i++)
+			op(unitBase(list[i].entry->unit));
+		list.clear();
+		depth_--;
+	}
+
+	static terUnitBase* unitBase(terUnitGeneric* unit);
+};
+
+#endif //__UNIT_QUERY_CACHE_H__
@@ -0,0 +1,229 @@
+#include "StdAfx.h"
+
+#include "Universe.h"
+#include "UnitRegistry.h"
+
+UnitRegistry::UnitRegistry()
+{
+	serial_ = 0;
+	byAttribute_.resize(UNIT_ATTRIBUTE_MAX);
+}
+
+void UnitRegistry::clear()
+{
+	entries_.clear();
+	byID_.clear();
+	for(int i = 0; i < byAttribute_.size(); i++)
+		byAttribute_[i].clear();
+	for(int i = 0; i < CLASS_BITS; i++)
+		byClass_[i].clear();
+	byLabel_.clear();
+}
+
+void UnitRegistry::insert(Bucket& bucket, const Slot& slot)
+{
+	// Обычно юнит новее всех в корзине
+	if(bucket.empty() || bucket.back().serial < slot.serial)
+		bucket.push_back(slot);
+	else
+		bucket.insert(std::lower_bound(bucket.begin(), bucket.end(), slot), slot);
+}
+
+void UnitRegistry::erase(Bucket& bucket, unsigned int serial)
+{
+	Slot key;
+	key.serial = serial;
+	Bucket::iterator i = std::lower_bound(bucket.begin(), bucket.end(), key);
+	if(i != bucket.end() && i->serial == serial)
+		bucket.erase(i);
+}
+
+void UnitRegistry::insertClass(int unitClass, const Slot& slot)
+{
+	for(int bit = 0; bit < CLASS_BITS; bit++)
+		if(unitClass & (1 << bit))
+			insert(byClass_[bit], slot);
+}
+
+void UnitRegistry::eraseClass(int unitClass, unsigned int serial)
+{
+	for(int bit = 0; bit < CLASS_BITS; bit++)
+		if(unitClass & (1 << bit))
+			erase(byClass_[bit], serial);
+}
+
+void UnitRegistry::insertLabel(const std::string& label, const Slot& slot)
+{
+	if(!label.empty())
+		insert(byLabel_[label], slot);
+}
+
+void UnitRegistry::eraseLabel(const std::string& label, unsigned int serial)
+{
+	if(label.empty())
+		return;
+	std::unordered_map<std::string, Bucket>::iterator i = byLabel_.find(label);
+	if(i == byLabel_.end())
+		return;
+	erase(i->second, serial);
+	if(i->second.empty())
+		byLabel_.erase(i);
+}
+
+void UnitRegistry::add(terUnitBase* unit, UnitList::iterator position)
+{
+	xassert(!entries_.count(unit));
+	Entry& entry = entries_[unit];
+	entry.serial = ++serial_;
+	entry.position = position;
+	entry.unitID = unit->unitID();
+	entry.attributeID = unit->attr()->ID;
+	entry.unitClass = unit->unitClass();
+	entry.label = unit->label();
+
+	Slot slot;
+	slot.serial = entry.serial;
+	slot.unit = unit;
+
+	byID_[entry.unitID] = unit;
+	if(entry.attributeID >= 0 && entry.attributeID < byAttribute_.size())
+		insert(byAttribute_[entry.attributeID], slot);
+	insertClass(entry.unitClass, slot);
+	insertLabel(entry.label, slot);
+}
+
+bool UnitRegistry::remove(terUnitBase* unit, UnitList::iterator& position)
+{
+	std::unordered_map<const terUnitBase*, Entry>::iterator i = entries_.find(unit);
+	if(i == entries_.end())
+		return false;
+
+	const Entry& entry = i->second;
+	std::unordered_map<unsigned int, terUnitBase*>::iterator id = byID_.find(entry.unitID);
+	if(id != byID_.end() && id->second == unit)
+		byID_.erase(id);
+	if(entry.attributeID >= 0 && entry.attributeID < byAttribute_.size())
+		erase(byAttribute_[entry.attributeID], entry.serial);
+	eraseClass(entry.unitClass, entry.serial);
+	eraseLabel(entry.label, entry.serial);
+
+	position = entry.position;
+	entries_.erase(i);
+	return true;
+}
+
+void UnitRegistry::update(terUnitBase* unit)
+{
+	std::unordered_map<const terUnitBase*, Entry>::iterator i = entries_.find(unit);
+	if(i == entries_.end())
+		return;
+
+	Entry& entry = i->second;
+	Slot slot;
+	slot.serial = entry.serial;
+	slot.unit = unit;
+
+	if(entry.unitID != unit->unitID()){
+		std::unordered_map<unsigned int, terUnitBase*>::iterator id = byID_.find(entry.unitID);
+		if(id != byID_.end() && id->second == unit)
+			byID_.erase(id);
+		entry.unitID = unit->unitID();
+		byID_[entry.unitID] = unit;
+	}
+
+	if(entry.attributeID != unit->attr()->ID){
+		if(entry.attributeID >= 0 && entry.attributeID < byAttribute_.size())
+			erase(byAttribute_[entry.attributeID], entry.serial);
+		entry.attributeID = unit->attr()->ID;
+		if(entry.attributeID >= 0 && entry.attributeID < byAttribute_.size())
+			insert(byAttribute_[entry.attributeID], slot);
+	}
+
+	if(entry.unitClass != unit->unitClass()){
+		eraseClass(entry.unitClass, entry.serial);
+		entry.unitClass = unit->unitClass();
+		insertClass(entry.unitClass, slot);
+	}
+
+	if(entry.label != unit->label()){
+		eraseLabel(entry.label, entry.serial);
+		entry.label = unit->label();
+		insertLabel(entry.label, slot);
+	}
+}
+
+terUnitBase* UnitRegistry::find(unsigned int unitID) const
+{
+	std::unordered_map<unsigned int, terUnitBase*>::const_iterator i = byID_.find(unitID);
+	return i != byID_.end() ? i->second : 0;
+}
+
+terUnitBase* UnitRegistry::find(terUnitAttributeID id) const
+{
+	if(id < 0 || id >= byAttribute_.size() || byAttribute_[id].empty())
+		return 0;
+	return byAttribute_[id].front().unit;
+}
+
+terUnitBase* UnitRegistry::findByLabel(const char* label) const
+{
+	std::unordered_map<std::string, Bucket>::const_iterator i = byLabel_.find(label);
+	if(i == byLabel_.end() || i->second.empty())
+		return 0;
+	return i->second.front().unit;
+}
+
+int UnitRegistry::count(terUnitAttributeID id) const
+{
+	if(id < 0 || id >= byAttribute_.size())
+		return 0;
+	return byAttribute_[id].size();
+}
+
+void UnitRegistry::findNearest(const Bucket& bucket, const Vect2f& position, float distanceMin, bool constructedOnly,
+	terUnitBase*& bestUnit, unsigned int& bestSerial, float& bestDist)
+{
+	float distanceMin2 = sqr(distanceMin);
+	Bucket::const_iterator i;
+	FOR_EACH(bucket, i){
+		terUnitBase* unit = i->unit;
+		float dist = position.distance2(unit->position2D());
+		if(dist < distanceMin2 || dist == distanceMin2 || dist > bestDist)
+			continue;
+		// Из нескольких корзин при равном расстоянии - первый в порядке Units
+		if(dist == bestDist && i->serial > bestSerial)
+			continue;
+		if(constructedOnly && !unit->isConstructed() && !unit->isUpgrading())
+			continue;
+		bestDist = dist;
+		bestSerial = i->serial;
+		bestUnit = unit;
+	}
+}
+
+terUnitBase* UnitRegistry::findNearest(terUnitAttributeID id, const Vect2f& position, float distanceMin) const
+{
+	terUnitBase* bestUnit = 0;
+	unsigned int bestSerial = 0;
+	float bestDist = FLT_INF;
+	if(id != UNIT_ATTRIBUTE_ANY){
+		if(id >= 0 && id < byAttribute_.size())
+			findNearest(byAttribute_[id], position, distanceMin, false, bestUnit, bestSerial, bestDist);
+	}
+	else{
+		for(int i = 0; i < UNIT_ATTRIBUTE_LEGIONARY_MAX; i++)
+			findNearest(byAttribute_[i], position, distanceMin, false, bestUnit, bestSerial, bestDist);
+	}
+	return bestUnit;
+}
+
+terUnitBase* UnitRegistry::findNearestByClass(int unitClass, const Vect2f& position, float distanceMin) const
+{
+	terUnitBase* bestUnit = 0;
+	unsigned int bestSerial = 0;
+	float bestDist = FLT_INF;
+	for(int bit = 0; bit < CLASS_BITS; bit++)
+		if(unitClass & (1 << bit))
+			findNearest(byClass_[bit], position, distanceMin, true, bestUnit, bestSerial, bestDist);
+	return bestUnit;
+}
@@ -0,0 +1,78 @@
+#ifndef __UNIT_REGISTRY_H__
+#define __UNIT_REGISTRY_H__
+
+#include <unordered_map>
+
+//////////////////////////////////////////////////////////////////
+//  Индекс юнитов игрока.
+//  Поиск по unitID, атрибуту, классу и метке без обхода всего
+//  списка Units. Ведется terPlayer в addUnit/removeUnit, изменения
+//  ID, класса и метки юнита передаются через update.
+//  Корзины упорядочены по порядку добавления, как и Units, поэтому
+//  при равных расстояниях находится тот же юнит, что и при обходе Units.
+//////////////////////////////////////////////////////////////////
+class UnitRegistry
+{
+public:
+	UnitRegistry();
+
+	void add(terUnitBase* unit, UnitList::iterator position);
+	// Возвращает позицию юнита в Units, false если юнит не был добавлен
+	bool remove(terUnitBase* unit, UnitList::iterator& position);
+	// Перечитывает ID, класс и метку юнита
+	void update(terUnitBase* unit);
+	void clear();
+
+	terUnitBase* find(unsigned int unitID) const;
+	// Первый в порядке Units
+	terUnitBase* find(terUnitAttributeID id) const;
+	terUnitBase* findByLabel(const char* label) const;
+	int count(terUnitAttributeID id) const;
+
+	terUnitBase* findNearest(terUnitAttributeID id, const Vect2f& position, float distanceMin) const;
+	// Только построенные или улучшаемые
+	terUnitBase* findNearestByClass(int unitClass, const Vect2f& position, float distanceMin) const;
+
+private:
+	enum { CLASS_BITS = 32 };
+
+	struct Slot
+	{
+		unsigned int serial;
+		terUnitBase* unit;
+
+		bool operator < (const Slot& s) const { return serial < s.serial; }
+	};
+	typedef std::vector<Slot> Bucket;
+
+	struct Entry
+	{
+		unsigned int serial;
+		UnitList::iterator position;
+		// Ключи, под которыми юнит лежит в индексах
+		unsigned int unitID;
+		int attributeID;
+		int unitClass;
+		std::string label;
+	};
+
+	std::unordered_map<const terUnitBase*, Entry> entries_;
+	std::unordered_map<unsigned int, terUnitBase*> byID_;
+	std::vector<Bucket> byAttribute_;
+	Bucket byClass_[CLASS_BITS];
+	std::unordered_map<std::string, Bucket> byLabel_;
+	unsigned int serial_;
+
+	static void insert(Bucket& bucket, const Slot& slot);
+	static void erase(Bucket& bucket, unsigned int serial);
+
+	void insertClass(int unitClass, const Slot& slot);
+	void eraseClass(int unitClass, unsigned int serial);
+	void insertLabel(const std::string& label, const Slot& slot);
+	void eraseLabel(const std::string& label, unsigned int serial);
+
+	static void findNearest(const Bucket& bucket, const Vect2f& position, float distanceMin, bool constructedOnly,
+		terUnitBase*& bestUnit, unsigned int& bestSerial, float& bestDist);
+};
+
+#endif //__UNIT_REGISTRY_H__
@@ -176,9 +176,10 @@ void terBuildingMilitary::MoveQuant()
 bool terBuildingMilitary::findTarget()
 {
 	terUnitGridTeamOffensiveOperator op(this);
-	universe()->UnitGrid.Scan(xm::round(position().x), xm::round(position().y), xm::round(attr()->sightRadius()), op);
+	if(universe()->influenceMap.enemiesAround(Player, position2D(), attr()->sightRadius()))
+		universe()->unitQuery.scanEnemies(this, position2D(), attr()->sightRadius(), op);
 
-	targetsScanTimer_.start(static_gun_targets_scan_period);
+	targetsScanTimer_.start(universe()->unitQuery.staggeredPeriod(this, static_gun_targets_scan_period));
 
 	if(op.offensivePoint()){
 		setAttackTarget(safe_cast<terUnitReal*>(op.offensivePoint()));
@@ -26,29 +26,48 @@ void BinaryOArchive::open(const char* fname, int version)
 	buffer_ < "BinX" < version;
 }
 
+bool BinaryOArchive::finalBuffer(XBuffer& output) const
+{
+	output.set(0);
+	if(!compress_){
+		output.write(buffer_.address(), buffer_.tell());
+		return true;
+	}
+	output < "BinZ";
+	return buffer_.compress(output) == 0;
+}
+
 bool BinaryOArchive::close()
 {
     if (fileName_.empty()) {
         return false;
     }
+	XBuffer packed(compress_ ? buffer_.tell()/2 + 64 : 0, true);
+	if(compress_ && !finalBuffer(packed))
+		return false;
+	const XBuffer& data = compress_ ? packed : buffer_;
+	// Деструктор не должен повторно сжимать и сравнивать
+	std::string fileName;
+	fileName.swap(fileName_);
 	XStream ff(0);
-	if(ff.open(fileName_.c_str(), XS_IN)){
-		if(ff.size() == buffer_.tell()){
+	if(ff.open(fileName.c_str(), XS_IN)){
+		if(ff.size() == data.tell()){
             XBuffer buf = XBuffer(ff.size());
             ff.read(buf.address(), ff.size());
-            if(!memcmp(buffer_.address(), buf.address(), ff.tell()))
+            if(!memcmp(data.address(), buf.address(), ff.tell()))
 				return true;
 		}
 	}
 	ff.close();
-	ff.open(fileName_.c_str(), XS_OUT);
-	ff.write(buffer_.address(), buffer_.tell());
+	ff.open(fileName.c_str(), XS_OUT);
+	ff.write(data.address(), data.tell());
 	return !ff.ioError();
 }
 
 //////////////////////////////////////////////
 BinaryIArchive::BinaryIArchive(const char* fname) :
-buffer_(10, 1)
+buffer_(10, 1),
+version_(0)
 {
 	if(fname && !open(fname))
 		ErrH.Abort("File not found: ", XERR_USER, 0, fname);
@@ -65,13 +84,42 @@ bool BinaryIArchive::open(const char* fname)
 	XStream ff(0);
 	if(!ff.open(convert_path_content(fname), XS_IN))
 		return false;
+
+	// Текстовые архивы с тем же расширением не дочитываем
+	char header[4];
+	if(ff.size() < sizeof(header) || ff.read(header, sizeof(header)) != sizeof(header) ||
+	  header[0] != 'B' || header[1] != 'i' || header[2] != 'n' || (header[3] != 'X' && header[3] != 'Z'))
+		return false;
+
 	buffer_.alloc(ff.size() + 1);
-	ff.read(buffer_.address(), ff.size());
+	memcpy(buffer_.address(), header, sizeof(header));
+	ff.read(buffer_.address() + sizeof(header), ff.size() - sizeof(header));
 	buffer_[(int)ff.size()] = 0;
-	if(buffer_[0] != 'B' || buffer_[1] != 'i' || buffer_[2] != 'n' || buffer_[3] != 'X'){
-		close();
+	return reset();
+}
+
+bool BinaryIArchive::reset()
+{
+	buffer_.set(0);
+	if(buffer_.length() < 8 || buffer_[0] != 'B' || buffer_[1] != 'i' || buffer_[2] != 'n')
 		return false;
+
+	if(buffer_[3] == 'Z'){
+		buffer_ += 4;
+		XBuffer data(16, true);
+		if(buffer_.uncompress(data) != 0){
+			close();
+			return false;
+		}
+		data < char(0);
+		// Без копирования содержимого
+		std::swap(data.buf, buffer_.buf);
+		std::swap(data.size, buffer_.size);
+		buffer_.set(0);
 	}
+
+	if(buffer_.length() < 8 || buffer_[3] != 'X')
+		return false;
 	(buffer_ += 4) > version_;
 	return true;
 }
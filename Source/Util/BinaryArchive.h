@@ -6,6 +6,9 @@
 
 	"BinX" + int(version)
 
+Сжатый архив (setCompression(true)) пишется как "BinZ" + XBuffer::compress
+от несжатого архива, BinaryIArchive распознает оба варианта.
+
 Версии необходимы для ручного контроля конвертации 
 старых данных. Для этого во все архивы введена функция
 laterThen(version) ("позже, чем"): true, если версия файла
@@ -106,6 +109,10 @@ public:
 	void open(const char* fname, int version = 0); 
 	bool close();  // true if there were changes, so file was updated
 
+	void setCompression(bool compress) { compress_ = compress; }
+	// Итоговое содержимое архива (сжатое, если включено сжатие), для передачи без файла
+	bool finalBuffer(XBuffer& output) const;
+
 	int type() const {
 		return ARCHIVE_BINARY;
 	}
@@ -163,6 +170,7 @@ public:
 private:
 	XBuffer buffer_;
 	std::string fileName_ = "";
+	bool compress_ = false;
 
 	///////////////////////////////////
 	void saveString(const char* value) {
@@ -311,6 +319,7 @@ public:
 	~BinaryIArchive();
 
 	bool open(const char* fname);  // true if file exists
+	bool reset(); // разбор заголовка после записи данных в buffer(), false если это не бинарный архив
 	void close();
 
 	int type() const {
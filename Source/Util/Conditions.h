@@ -67,6 +67,7 @@ struct ConditionCreateObject : Condition // Объект создан
 
 	bool check(AIPlayer& aiPlayer) override { return created_ >= counter; }
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
     VIRTUAL_SERIALIZE(ar) {
 		Condition::serialize_template(ar);
@@ -97,6 +98,7 @@ struct ConditionKillObject : Condition // Объект уничтожен
 
 	bool check(AIPlayer& aiPlayer) override { return killed_ >= counter; }
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
     VIRTUAL_SERIALIZE(ar) {
         Condition::serialize_template(ar);
@@ -148,6 +150,7 @@ struct ConditionCaptureBuilding : ConditionOneTime // Захват здания
 	}
 
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
 	VIRTUAL_SERIALIZE(ar) {
 		ConditionOneTime::serialize_template(ar);
@@ -176,6 +179,7 @@ struct ConditionTeleportation : ConditionOneTime // Произошла теле
 	}
 
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
     VIRTUAL_SERIALIZE(ar) {
         ConditionOneTime::serialize_template(ar);
@@ -299,6 +303,7 @@ struct ConditionUnitClassUnderAttack : ConditionOneTime // Объект атак
 	}
 
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
 	VIRTUAL_SERIALIZE(ar) {
 		ConditionOneTime::serialize_template(ar);
@@ -315,6 +320,7 @@ struct ConditionUnitClassIsGoingToBeAttacked : ConditionOneTime // Объект
 	BitVector<terUnitClassType> agressorUnitClass; 
 
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
 	VIRTUAL_SERIALIZE(ar) {
 		ConditionOneTime::serialize_template(ar);
@@ -486,6 +492,7 @@ struct ConditionPlayerState : Condition // Проверка состояния 
 
 	bool check(AIPlayer& aiPlayer) override { return active_; }
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
 	VIRTUAL_SERIALIZE(ar) {
 		Condition::serialize_template(ar);
@@ -536,6 +543,7 @@ struct ConditionKillObjectByLabel : ConditionOneTime // Объект по мет
 	{}
 
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
     VIRTUAL_SERIALIZE(ar) { 
 		ConditionOneTime::serialize_template(ar);
@@ -597,6 +605,7 @@ struct ConditionTimeMatched : ConditionOneTime // Осталось времен
 	}
 
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
 	VIRTUAL_SERIALIZE(ar) {
 		ConditionOneTime::serialize_template(ar);
@@ -607,6 +616,7 @@ struct ConditionTimeMatched : ConditionOneTime // Осталось времен
 struct ConditionMouseClick : ConditionOneTime // Клик мыши
 {
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
     VIRTUAL_SERIALIZE(ar) {
         ConditionOneTime::serialize_template(ar);
@@ -626,6 +636,7 @@ struct ConditionClickOnButton : Condition // Клик по кнопке
 
 	bool check(AIPlayer& aiPlayer) override { return counter_ >= counter; }
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
 	VIRTUAL_SERIALIZE(ar) {
 		Condition::serialize_template(ar);
@@ -702,6 +713,7 @@ struct ConditionActivateSpot : ConditionOneTime // Активировался с
 	}
 
 	void checkEvent(AIPlayer& aiPlayer, const Event* event) override;
+	int eventMask() const override;
 
 	VIRTUAL_SERIALIZE(ar) {
 		ConditionOneTime::serialize_template(ar);
@@ -265,6 +265,10 @@ void check_determinacy_quant(bool start)
 	static int time_to_exit = 0;
 	static bool second_pass = false;
 	static MeasurementTimer timer;
+	// Сверка сборок по CRC лога каждого кванта
+	static XStream quant_crc_stream;
+	static int quant_crc_mode = 0; // 1 - запись, 2 - сверка
+	static int quant_crc_number = 0;
 
 	if(!inited && start){
 		inited = 1;
@@ -275,6 +279,23 @@ void check_determinacy_quant(bool start)
 		else if(check_command_line("verify_log"))
 			log_mode = 2;
 
+		quant_crc_mode = 0;
+		quant_crc_number = 0;
+		quant_crc_stream.close();
+		if(!log_mode){
+			if(const char* path = check_command_line("save_quant_crc")){
+				quant_crc_mode = 1;
+				quant_crc_stream.open(path, XS_OUT);
+			}
+			else if(const char* path = check_command_line("verify_quant_crc")){
+				quant_crc_mode = 2;
+				quant_crc_stream.open(path, XS_IN);
+			}
+			// Лог только копится на квант, в "lst_" не пишется
+			if(quant_crc_mode)
+				log_mode = 3;
+		}
+
 		const char* str = check_command_line("time_to_exit:");
 		if(str)
 			time_to_exit = 1000*atoi(str);
@@ -300,6 +321,31 @@ void check_determinacy_quant(bool start)
 			ErrH.Exit();
 	}
 
+	if(quant_crc_mode && !start){
+		unsigned int crc = crc32((const unsigned char*)log_buffer.address(), log_buffer.tell(), startCRC32);
+		quant_crc_number++;
+		if(quant_crc_mode == 1)
+			quant_crc_stream.write(quant_crc_number).write(crc);
+		else if(quant_crc_stream.eof()){
+			fprintf(stderr, "verify_quant_crc: all %d recorded quants match\n", quant_crc_number - 1);
+			quant_crc_mode = 0;
+		}
+		else{
+			int number = 0;
+			unsigned int crc_recorded = 0;
+			quant_crc_stream.read(number).read(crc_recorded);
+			if(number != quant_crc_number || crc_recorded != crc){
+				fprintf(stderr, "verify_quant_crc: desync at quant %d\n", quant_crc_number);
+				ErrH.Exit();
+			}
+		}
+	}
+
+	if(log_mode == 3){
+		log_buffer.init();
+		return;
+	}
+
 	if(!log_mode)
 		return;
 
@@ -0,0 +1,212 @@
+#include <atomic>
+#include <SDL.h>
+#include "StdAfx.h"
+#include "MemoryPool.h"
+
+////////////////////////////////////////////
+//	SlabAllocator
+////////////////////////////////////////////
+namespace {
+
+const int slab_class_sizes[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768,
+	1024, 1536, 2048, 3072, 4096, 6144, SlabAllocator::SIZE_LIMIT
+};
+const int SLAB_CLASSES = sizeof(slab_class_sizes)/sizeof(slab_class_sizes[0]);
+
+struct SlabChunk {
+	SlabChunk* next;
+};
+
+// Общий пул класса, под спин-блокировкой
+struct SlabClass {
+	SDL_SpinLock lock;
+	SlabChunk* free;
+	int free_count;
+};
+
+SlabClass slab_classes[SLAB_CLASSES];
+
+std::atomic<int> slab_allocs(0);
+std::atomic<int> slab_frees(0);
+std::atomic<int> slab_count(0);
+std::atomic<int> slab_used(0);
+
+inline int slabClass(size_t size)
+{
+	int i = 0;
+	while(slab_class_sizes[i] < (int)size)
+		i++;
+	return i;
+}
+
+// Сколько кусков кэш потока держит у себя и сколько берет за раз
+inline int slabCacheMax(int cls)
+{
+	return max(8, 16*1024/slab_class_sizes[cls]);
+}
+
+// Список нарезанного слаба
+SlabChunk* slabCarve(int cls, int& count)
+{
+	int size = slab_class_sizes[cls];
+	char* slab = static_cast<char*>(::operator new(SlabAllocator::SLAB_BYTES));
+	slab_count++;
+	count = SlabAllocator::SLAB_BYTES/size;
+	SlabChunk* head = 0;
+	for(int i = count - 1; i >= 0; i--){
+		SlabChunk* chunk = reinterpret_cast<SlabChunk*>(slab + i*size);
+		chunk->next = head;
+		head = chunk;
+	}
+	return head;
+}
+
+// Без кэша потока: до его создания и после разрушения при выходе из потока
+void* slabGlobalAlloc(int cls)
+{
+	SlabClass& sc = slab_classes[cls];
+	SDL_AtomicLock(&sc.lock);
+	if(!sc.free)
+		sc.free = slabCarve(cls, sc.free_count);
+	SlabChunk* chunk = sc.free;
+	sc.free = chunk->next;
+	sc.free_count--;
+	SDL_AtomicUnlock(&sc.lock);
+	return chunk;
+}
+
+void slabGlobalFree(int cls, void* ptr)
+{
+	SlabClass& sc = slab_classes[cls];
+	SlabChunk* chunk = static_cast<SlabChunk*>(ptr);
+	SDL_AtomicLock(&sc.lock);
+	chunk->next = sc.free;
+	sc.free = chunk;
+	sc.free_count++;
+	SDL_AtomicUnlock(&sc.lock);
+}
+
+enum {
+	SLAB_CACHE_NONE,
+	SLAB_CACHE_ALIVE,
+	SLAB_CACHE_DESTROYED
+};
+thread_local int slab_thread_cache_state = SLAB_CACHE_NONE;
+
+struct SlabThreadCache {
+	SlabChunk* free[SLAB_CLASSES];
+	int free_count[SLAB_CLASSES];
+
+	SlabThreadCache()
+	{
+		for(int i = 0; i < SLAB_CLASSES; i++){
+			free[i] = 0;
+			free_count[i] = 0;
+		}
+		slab_thread_cache_state = SLAB_CACHE_ALIVE;
+	}
+
+	~SlabThreadCache()
+	{
+		for(int i = 0; i < SLAB_CLASSES; i++)
+			release(i, free_count[i]);
+		slab_thread_cache_state = SLAB_CACHE_DESTROYED;
+	}
+
+	void refill(int cls)
+	{
+		SlabClass& sc = slab_classes[cls];
+		int batch = slabCacheMax(cls)/2;
+		SDL_AtomicLock(&sc.lock);
+		while(sc.free && free_count[cls] < batch){
+			SlabChunk* chunk = sc.free;
+			sc.free = chunk->next;
+			sc.free_count--;
+			chunk->next = free[cls];
+			free[cls] = chunk;
+			free_count[cls]++;
+		}
+		SDL_AtomicUnlock(&sc.lock);
+
+		if(!free[cls])
+			free[cls] = slabCarve(cls, free_count[cls]);
+	}
+
+	// Отдает count кусков в общий пул
+	void release(int cls, int count)
+	{
+		if(!count)
+			return;
+		SlabChunk* head = free[cls];
+		SlabChunk* tail = head;
+		for(int i = 1; i < count; i++)
+			tail = tail->next;
+		free[cls] = tail->next;
+		free_count[cls] -= count;
+
+		SlabClass& sc = slab_classes[cls];
+		SDL_AtomicLock(&sc.lock);
+		tail->next = sc.free;
+		sc.free = head;
+		sc.free_count += count;
+		SDL_AtomicUnlock(&sc.lock);
+	}
+};
+
+thread_local SlabThreadCache slab_thread_cache;
+
+}
+
+void* SlabAllocator::alloc(size_t size)
+{
+	slab_allocs.fetch_add(1, std::memory_order_relaxed);
+	slab_used.fetch_add(1, std::memory_order_relaxed);
+	if(size > SIZE_LIMIT)
+		return ::operator new(size);
+
+	int cls = slabClass(size);
+	if(slab_thread_cache_state == SLAB_CACHE_DESTROYED)
+		return slabGlobalAlloc(cls);
+	SlabThreadCache& cache = slab_thread_cache;
+	if(!cache.free[cls])
+		cache.refill(cls);
+	SlabChunk* chunk = cache.free[cls];
+	cache.free[cls] = chunk->next;
+	cache.free_count[cls]--;
+	return chunk;
+}
+
+void SlabAllocator::free(void* ptr, size_t size)
+{
+	if(!ptr)
+		return;
+	slab_frees.fetch_add(1, std::memory_order_relaxed);
+	slab_used.fetch_sub(1, std::memory_order_relaxed);
+	if(size > SIZE_LIMIT){
+		::operator delete(ptr);
+		return;
+	}
+
+	int cls = slabClass(size);
+	if(slab_thread_cache_state == SLAB_CACHE_DESTROYED){
+		slabGlobalFree(cls, ptr);
+		return;
+	}
+	SlabThreadCache& cache = slab_thread_cache;
+	SlabChunk* chunk = static_cast<SlabChunk*>(ptr);
+	chunk->next = cache.free[cls];
+	cache.free[cls] = chunk;
+	if(++cache.free_count[cls] > slabCacheMax(cls))
+		cache.release(cls, cache.free_count[cls]/2);
+}
+
+SlabAllocator::Stats SlabAllocator::quantStats()
+{
+	Stats stats;
+	stats.allocs = slab_allocs.exchange(0, std::memory_order_relaxed);
+	stats.frees = slab_frees.exchange(0, std::memory_order_relaxed);
+	stats.slabs = slab_count.load(std::memory_order_relaxed);
+	stats.used = slab_used.load(std::memory_order_relaxed);
+	return stats;
+}
@@ -21,11 +21,11 @@ public:
 	void free(void* p) { heap.push_back(p); }
 
 	// Debug
-	size_t size() const { heap.size()*sizeof(T); }
+	size_t size() const { return heap.size()*sizeof(T); }
 	size_t blocks() const { return heap.size(); }
 
 private:
-	vector<void*> heap;
+	std::vector<void*> heap;
 };
 
 // В декларацию каждого класса
@@ -72,7 +72,7 @@ public:
 	size_t blocks() const;
 
 private:
-	typedef multimap<int, void*> MemoryMap;
+	typedef std::multimap<int, void*> MemoryMap;
 	MemoryMap memory_map;
 
 	// В начале каждого блока памяти находится заголовок с размером и верификатором.
@@ -119,8 +119,8 @@ inline void MemoryPool::clear()
 {
 	MemoryMap::iterator mi;
 	FOR_EACH(memory_map, mi) {
-		void* p = (Header*)mi->second - 1;
-		delete p;
+		char* p = (char*)((Header*)mi->second - 1);
+		delete[] p;
 	}
 	memory_map.clear();
 }
@@ -140,5 +140,49 @@ inline size_t MemoryPool::blocks() const
 }
 
 
+////////////////////////////////////////////
+//	Распределитель по классам размеров
+// Куски до SIZE_LIMIT байт нарезаются из слабов по SLAB_BYTES,
+// свободные куски лежат в списках своего класса размера.
+// У каждого потока свой кэш этих списков, поэтому alloc/free
+// обычно обходятся без блокировок, с общим пулом класса кэш
+// обменивается пачками. Куски больше SIZE_LIMIT - обычный new.
+// Заголовков нет, размер передается в free (sized delete,
+// у полиморфных классов нужен виртуальный деструктор).
+// Память слабов не возвращается системе до выхода.
+//
+// Использование:
+//
+// class Base {
+// public:
+//		SLAB_ALLOCATION_DECLARATION
+//		virtual ~Base();
+// };
+////////////////////////////////////////////
+
+class SlabAllocator {
+public:
+	enum {
+		SIZE_LIMIT = 8192,
+		SLAB_BYTES = 64*1024
+	};
+
+	static void* alloc(size_t size);
+	static void free(void* ptr, size_t size);
+
+	struct Stats {
+		int allocs; // с прошлого quantStats
+		int frees;
+		int slabs; // всего нарезано слабов
+		int used; // кусков выдано и не освобождено
+	};
+	// Счетчики за квант: allocs/frees обнуляются
+	static Stats quantStats();
+};
+
+#define SLAB_ALLOCATION_DECLARATION \
+	void* operator new(size_t size) { return SlabAllocator::alloc(size); } \
+	void operator delete(void* ptr, size_t size) { SlabAllocator::free(ptr, size); }
+
 
 #endif //__MEMORY_POOL_H__
\ No newline at end of file
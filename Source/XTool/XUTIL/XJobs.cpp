@@ -0,0 +1,178 @@
+
+/* ---------------------------- INCLUDE SECTION ----------------------------- */
+
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "xutl.h"
+#include "xjobs.h"
+#include "xerrhand.h"
+#include <SDL.h>
+
+//Maximum worker threads, more doesn't pay off for our job sizes
+static const int PARALLEL_THREADS_MAX = 8;
+
+struct ParallelBatch {
+    const std::function<void(int)>* fn;
+    int count;
+    std::atomic<int> next;
+    std::atomic<int> done;
+    //Workers which took this batch and may still access it
+    int users;
+};
+
+static SDL_mutex* parallel_mutex = nullptr;
+static SDL_cond* parallel_work_cond = nullptr;
+static SDL_cond* parallel_done_cond = nullptr;
+static std::vector<SDL_Thread*> parallel_workers;
+static std::vector<ParallelBatch*> parallel_batches;
+static bool parallel_quit = false;
+static bool parallel_inited = false;
+
+//Set in workers and while caller executes jobs, nested parallel_for run sequentially
+static thread_local bool parallel_inside_job = false;
+static thread_local int parallel_thread_id = 0;
+
+static void parallel_run_batch(ParallelBatch* batch) {
+    int i;
+    while ((i = batch->next.fetch_add(1)) < batch->count) {
+        (*batch->fn)(i);
+        batch->done.fetch_add(1);
+    }
+}
+
+static int parallel_worker(void* data) {
+    parallel_inside_job = true;
+    parallel_thread_id = static_cast<int>(reinterpret_cast<intptr_t>(data));
+    SDL_LockMutex(parallel_mutex);
+    while (!parallel_quit) {
+        ParallelBatch* batch = nullptr;
+        for (ParallelBatch* b : parallel_batches) {
+            if (b->next.load() < b->count) {
+                batch = b;
+                break;
+            }
+        }
+        if (!batch) {
+            SDL_CondWait(parallel_work_cond, parallel_mutex);
+            continue;
+        }
+
+        batch->users++;
+        SDL_UnlockMutex(parallel_mutex);
+        parallel_run_batch(batch);
+        SDL_LockMutex(parallel_mutex);
+        batch->users--;
+        SDL_CondBroadcast(parallel_done_cond);
+    }
+    SDL_UnlockMutex(parallel_mutex);
+    return 0;
+}
+
+void parallel_init(int threads) {
+    if (parallel_inited) {
+        return;
+    }
+    parallel_inited = true;
+
+    if (threads < 0) {
+        const char* str = check_command_line("jobs");
+        if (str) {
+            threads = std::atoi(str);
+        } else {
+#ifdef EMSCRIPTEN
+            threads = 1;
+#else
+            //Logic and graphics threads are busy already
+            threads = SDL_GetCPUCount() - 1;
+#endif
+        }
+    }
+    threads = std::max(1, std::min(threads, PARALLEL_THREADS_MAX));
+
+    parallel_mutex = SDL_CreateMutex();
+    parallel_work_cond = SDL_CreateCond();
+    parallel_done_cond = SDL_CreateCond();
+    parallel_quit = false;
+
+    for (int i = 1; i < threads; i++) {
+        SDL_Thread* thread = SDL_CreateThread(parallel_worker, "parallel_worker", reinterpret_cast<void*>(static_cast<intptr_t>(i)));
+        if (!thread) {
+            fprintf(stderr, "parallel_init: SDL_CreateThread failed: %s\n", SDL_GetError());
+            break;
+        }
+        parallel_workers.push_back(thread);
+    }
+}
+
+void parallel_finit() {
+    if (!parallel_inited) {
+        return;
+    }
+
+    SDL_LockMutex(parallel_mutex);
+    parallel_quit = true;
+    SDL_CondBroadcast(parallel_work_cond);
+    SDL_UnlockMutex(parallel_mutex);
+
+    for (SDL_Thread* thread : parallel_workers) {
+        SDL_WaitThread(thread, nullptr);
+    }
+    parallel_workers.clear();
+
+    SDL_DestroyCond(parallel_done_cond);
+    SDL_DestroyCond(parallel_work_cond);
+    SDL_DestroyMutex(parallel_mutex);
+    parallel_done_cond = parallel_work_cond = nullptr;
+    parallel_mutex = nullptr;
+    parallel_inited = false;
+}
+
+int parallel_threads() {
+    parallel_init();
+    return static_cast<int>(parallel_workers.size()) + 1;
+}
+
+int parallel_thread_index() {
+    return parallel_thread_id;
+}
+
+void parallel_for(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) {
+        return;
+    }
+    parallel_init();
+
+    if (count == 1 || parallel_inside_job || parallel_workers.empty()) {
+        for (int i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    ParallelBatch batch;
+    batch.fn = &fn;
+    batch.count = count;
+    batch.next = 0;
+    batch.done = 0;
+    batch.users = 0;
+
+    SDL_LockMutex(parallel_mutex);
+    parallel_batches.push_back(&batch);
+    SDL_CondBroadcast(parallel_work_cond);
+    SDL_UnlockMutex(parallel_mutex);
+
+    parallel_inside_job = true;
+    parallel_run_batch(&batch);
+    parallel_inside_job = false;
+
+    SDL_LockMutex(parallel_mutex);
+    while (batch.done.load() < count || batch.users) {
+        SDL_CondWait(parallel_done_cond, parallel_mutex);
+    }
+    parallel_batches.erase(std::find(parallel_batches.begin(), parallel_batches.end(), &batch));
+    SDL_UnlockMutex(parallel_mutex);
+}
@@ -17,6 +17,7 @@
 #include "xerrhand.h"
 #include "xutl.h"
 #include "xstream.h"
+#include <SDL.h>
 
 #include "files.h"
 
@@ -150,10 +151,13 @@ std::string convert_path_content(const std::string& path, bool parent_only) {
     return result;
 }
 
-filesystem_entry* get_content_entry(std::string path) {
+std::string convert_path_key(std::string path) {
     prepare_path(path, content_root_path_str);
-    path = string_to_lower(path.c_str());
-    return get_content_entry_internal(filesystem_entries, path).get();
+    return string_to_lower(path.c_str());
+}
+
+filesystem_entry* get_content_entry(std::string path) {
+    return get_content_entry_internal(filesystem_entries, convert_path_key(std::move(path))).get();
 }
 
 std::vector<filesystem_entry*> get_content_entries_recursive(std::string path) {
@@ -253,7 +257,8 @@ filesystem_entry* add_filesystem_entry_internal( // NOLINT(misc-no-recursion)
         std::string path_content,
         const std::string& destination_path,
         const std::string& source_path,
-        const filesystem_scan_options& options
+        const filesystem_scan_options& options,
+        int is_directory_hint = -1
 ) {
     //Remove ./ from res path since it can mess with some code dealing with extensions
     //Remove root since working directory is already there
@@ -278,7 +283,10 @@ filesystem_entry* add_filesystem_entry_internal( // NOLINT(misc-no-recursion)
         || startsWith(entry_key, "crashdata")
         || endsWith(entry_key, ".ini")) {
         
-        bool path_is_directory = std::filesystem::is_directory(std::filesystem::u8path(path_content));
+        //Listing from scan cache already knows the type, saves a stat call per entry
+        bool path_is_directory = is_directory_hint < 0
+                ? std::filesystem::is_directory(std::filesystem::u8path(path_content))
+                : is_directory_hint != 0;
 
         //Create absolute path too
         std::string entry_key_content = convert_path_native(path_content);
@@ -344,7 +352,7 @@ filesystem_entry* add_filesystem_entry_internal( // NOLINT(misc-no-recursion)
                 terminate_with_char(destination_path_copy, PATH_SEP);
                 terminate_with_char(source_path_copy, PATH_SEP);
             }
-            add_filesystem_entry_internal(paths, path_content, destination_path_copy, source_path_copy, options);
+            add_filesystem_entry_internal(paths, path_content, destination_path_copy, source_path_copy, options, 1);
         }
 
         return entry.get();
@@ -352,7 +360,76 @@ filesystem_entry* add_filesystem_entry_internal( // NOLINT(misc-no-recursion)
     return nullptr;
 }
 
-bool scan_resource_paths(std::string destination_path, std::string source_path, const filesystem_scan_options* options) {    
+///Entry of directory listing, stored in scan cache
+struct content_scan_item {
+    std::string path;
+    bool is_directory = false;
+    //Symlinked dirs are not scanned inside, as recursive_directory_iterator does
+    bool is_symlink = false;
+    //Last write time of directory, changes when entries are added or removed inside
+    int64_t mtime = 0;
+    //Index of parent directory in listing or -1 for scanned root
+    int parent = -1;
+};
+
+static int64_t get_directory_mtime(const std::string& path) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+    return ec ? -1 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+///Lists dir recursively in same order and with same paths as recursive_directory_iterator
+static void list_directory_recursive( // NOLINT(misc-no-recursion)
+        const std::string& dir_path,
+        int parent,
+        std::vector<content_scan_item>& items
+) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(
+            std::filesystem::u8path(dir_path),
+            std::filesystem::directory_options::skip_permission_denied,
+            ec
+    );
+    if (ec) {
+        return;
+    }
+    for (const auto& entry : it) {
+        bool is_directory = entry.is_directory(ec);
+        if (!is_directory && !entry.is_regular_file(ec)) {
+            continue;
+        }
+        content_scan_item item;
+        item.path = entry.path().u8string();
+        item.is_directory = is_directory;
+        item.is_symlink = entry.is_symlink(ec);
+        item.parent = parent;
+        if (is_directory) {
+            item.mtime = get_directory_mtime(item.path);
+        }
+        items.push_back(item);
+        if (is_directory && !item.is_symlink) {
+            list_directory_recursive(item.path, static_cast<int>(items.size()) - 1, items);
+        }
+    }
+}
+
+static bool scan_resource_paths_internal(
+        std::string destination_path,
+        std::string source_path,
+        const filesystem_scan_options* options,
+        const std::vector<content_scan_item>* listing
+);
+
+bool scan_resource_paths(std::string destination_path, std::string source_path, const filesystem_scan_options* options) {
+    return scan_resource_paths_internal(std::move(destination_path), std::move(source_path), options, nullptr);
+}
+
+static bool scan_resource_paths_internal(
+        std::string destination_path,
+        std::string source_path,
+        const filesystem_scan_options* options,
+        const std::vector<content_scan_item>* listing
+) {
     //Use destination as source path assuming its a call to refresh subdir resources in root
     if (source_path.empty()) {
         if (destination_path.empty()) {
@@ -430,9 +507,15 @@ bool scan_resource_paths(std::string destination_path, std::string source_path,
     }
 
     //Do recursive search on source path
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(source_dir, std::filesystem::directory_options::skip_permission_denied)) {
-        if (entry.is_regular_file() || entry.is_directory()) {
-            add_filesystem_entry_internal(paths, entry.path().u8string(), destination_path, source_path, scanOptions);
+    if (listing) {
+        for (const content_scan_item& item : *listing) {
+            add_filesystem_entry_internal(paths, item.path, destination_path, source_path, scanOptions, item.is_directory ? 1 : 0);
+        }
+    } else {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(source_dir, std::filesystem::directory_options::skip_permission_denied)) {
+            if (entry.is_regular_file() || entry.is_directory()) {
+                add_filesystem_entry_internal(paths, entry.path().u8string(), destination_path, source_path, scanOptions);
+            }
         }
     }
 
@@ -443,6 +526,254 @@ bool scan_resource_paths(std::string destination_path, std::string source_path,
     return true;
 }
 
+static const uint32_t SCAN_CACHE_MAGIC = 0x43534350; //PCSC
+static const uint32_t SCAN_CACHE_VERSION = 1;
+
+template<typename T>
+static bool scan_cache_get(const std::vector<char>& buf, size_t& pos, T& value) {
+    if (buf.size() < pos + sizeof(T)) return false;
+    memcpy(&value, &buf[pos], sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+static bool scan_cache_get(const std::vector<char>& buf, size_t& pos, std::string& value) {
+    uint32_t len;
+    if (!scan_cache_get(buf, pos, len) || buf.size() < pos + len) return false;
+    value.assign(&buf[pos], len);
+    pos += len;
+    return true;
+}
+
+template<typename T>
+static void scan_cache_put(std::string& buf, const T& value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void scan_cache_put(std::string& buf, const std::string& value) {
+    scan_cache_put(buf, static_cast<uint32_t>(value.size()));
+    buf += value;
+}
+
+static bool load_scan_cache(
+        const std::string& cache_path,
+        const std::string& root,
+        int64_t& root_mtime,
+        std::vector<content_scan_item>& items
+) {
+    std::vector<char> buf;
+    XStream f(0);
+    if (!f.open(cache_path, XS_IN)) {
+        return false;
+    }
+    buf.resize(f.size());
+    if (!buf.empty()) {
+        f.read(buf.data(), buf.size());
+    }
+    f.close();
+
+    size_t pos = 0;
+    uint32_t magic, version, count;
+    std::string cache_root;
+    if (!scan_cache_get(buf, pos, magic) || magic != SCAN_CACHE_MAGIC
+     || !scan_cache_get(buf, pos, version) || version != SCAN_CACHE_VERSION
+     || !scan_cache_get(buf, pos, cache_root) || cache_root != root
+     || !scan_cache_get(buf, pos, root_mtime)
+     || !scan_cache_get(buf, pos, count)) {
+        return false;
+    }
+
+    items.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        content_scan_item& item = items[i];
+        uint8_t flags;
+        if (!scan_cache_get(buf, pos, flags)
+         || !scan_cache_get(buf, pos, item.mtime)
+         || !scan_cache_get(buf, pos, item.parent)
+         || !scan_cache_get(buf, pos, item.path)
+         || item.parent < -1 || static_cast<int>(i) <= item.parent) {
+            items.clear();
+            return false;
+        }
+        item.is_directory = flags & 1;
+        item.is_symlink = flags & 2;
+    }
+    return true;
+}
+
+struct scan_cache_write_job {
+    std::string cache_path;
+    std::string data;
+};
+
+static int save_scan_cache_thread(void* data) {
+    scan_cache_write_job* job = static_cast<scan_cache_write_job*>(data);
+    //Write to temporary file first, so interrupted write doesn't leave broken cache
+    std::string tmp_path = job->cache_path + ".tmp";
+    XStream f(0);
+    bool ok = f.open(tmp_path, XS_OUT);
+    if (ok) {
+        f.write(job->data.data(), job->data.size());
+        f.close();
+        std::error_code ec;
+        std::filesystem::rename(std::filesystem::u8path(tmp_path), std::filesystem::u8path(job->cache_path), ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        fprintf(stderr, "Couldn't write content scan cache %s\n", job->cache_path.c_str());
+    }
+    delete job;
+    return 0;
+}
+
+static void save_scan_cache(
+        const std::string& cache_path,
+        const std::string& root,
+        int64_t root_mtime,
+        const std::vector<content_scan_item>& items
+) {
+    scan_cache_write_job* job = new scan_cache_write_job();
+    job->cache_path = cache_path;
+    std::string& buf = job->data;
+    scan_cache_put(buf, SCAN_CACHE_MAGIC);
+    scan_cache_put(buf, SCAN_CACHE_VERSION);
+    scan_cache_put(buf, root);
+    scan_cache_put(buf, root_mtime);
+    scan_cache_put(buf, static_cast<uint32_t>(items.size()));
+    for (const content_scan_item& item : items) {
+        uint8_t flags = (item.is_directory ? 1 : 0) | (item.is_symlink ? 2 : 0);
+        scan_cache_put(buf, flags);
+        scan_cache_put(buf, item.mtime);
+        scan_cache_put(buf, item.parent);
+        scan_cache_put(buf, item.path);
+    }
+
+    //Nobody waits for the cache, write it while game continues starting
+    SDL_Thread* thread = SDL_CreateThread(save_scan_cache_thread, "scan_cache", job);
+    if (thread) {
+        SDL_DetachThread(thread);
+    } else {
+        save_scan_cache_thread(job);
+    }
+}
+
+///Builds listing of dir from cache, only dirs which last write time changed are listed again.
+///Returns current last write time of dir
+static int64_t update_listing_from_cache( // NOLINT(misc-no-recursion)
+        const std::vector<content_scan_item>& cache,
+        const std::vector<std::vector<int>>& cache_children,
+        int cache_index,
+        int64_t cache_mtime,
+        const std::string& dir_path,
+        int parent,
+        std::vector<content_scan_item>& items,
+        int& changed_dirs
+) {
+    int64_t mtime = get_directory_mtime(dir_path);
+    const std::vector<int>& children = cache_children[cache_index + 1];
+    if (mtime == cache_mtime && mtime != -1) {
+        for (int child : children) {
+            const content_scan_item& cached = cache[child];
+            items.push_back(cached);
+            items.back().parent = parent;
+            if (cached.is_directory && !cached.is_symlink) {
+                int index = static_cast<int>(items.size()) - 1;
+                items[index].mtime = update_listing_from_cache(
+                        cache, cache_children, child, cached.mtime, cached.path, index, items, changed_dirs
+                );
+            }
+        }
+        return mtime;
+    }
+
+    //Entries were added or removed here, list this dir again but keep cached subdirs as they are checked separately
+    changed_dirs++;
+    std::unordered_map<std::string, int> cached_dirs;
+    for (int child : children) {
+        if (cache[child].is_directory) {
+            cached_dirs[cache[child].path] = child;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::directory_iterator it(
+            std::filesystem::u8path(dir_path),
+            std::filesystem::directory_options::skip_permission_denied,
+            ec
+    );
+    if (ec) {
+        return mtime;
+    }
+    for (const auto& entry : it) {
+        bool is_directory = entry.is_directory(ec);
+        if (!is_directory && !entry.is_regular_file(ec)) {
+            continue;
+        }
+        content_scan_item item;
+        item.path = entry.path().u8string();
+        item.is_directory = is_directory;
+        item.is_symlink = entry.is_symlink(ec);
+        item.parent = parent;
+        items.push_back(item);
+        int index = static_cast<int>(items.size()) - 1;
+        if (!is_directory) {
+            continue;
+        }
+        auto cached = cached_dirs.find(item.path);
+        if (cached != cached_dirs.end() && !item.is_symlink) {
+            items[index].mtime = update_listing_from_cache(
+                    cache, cache_children, cached->second, cache[cached->second].mtime, item.path, index, items, changed_dirs
+            );
+        } else {
+            items[index].mtime = get_directory_mtime(item.path);
+            if (!item.is_symlink) {
+                list_directory_recursive(item.path, index, items);
+            }
+        }
+    }
+    return mtime;
+}
+
+bool scan_resource_paths_cached(const std::string& cache_path) {
+    uint64_t time_start = clock_us();
+    std::error_code ec;
+    std::string root = std::filesystem::current_path(ec).u8string();
+
+    std::vector<content_scan_item> cache;
+    int64_t cache_root_mtime = 0;
+    bool cache_loaded = !cache_path.empty() && !ec && load_scan_cache(cache_path, root, cache_root_mtime, cache);
+
+    std::vector<content_scan_item> listing;
+    int64_t root_mtime;
+    int changed_dirs = 0;
+    if (cache_loaded) {
+        std::vector<std::vector<int>> cache_children(cache.size() + 1);
+        for (int i = 0; i < cache.size(); ++i) {
+            cache_children[cache[i].parent + 1].push_back(i);
+        }
+        listing.reserve(cache.size());
+        root_mtime = update_listing_from_cache(
+                cache, cache_children, -1, cache_root_mtime, curdir_path, -1, listing, changed_dirs
+        );
+    } else {
+        root_mtime = get_directory_mtime(curdir_path);
+        list_directory_recursive(curdir_path, -1, listing);
+    }
+    uint64_t time_listing = clock_us();
+
+    bool result = scan_resource_paths_internal(curdir_path, "", nullptr, &listing);
+    uint64_t time_end = clock_us();
+
+    printf("Content scan: %s, %" PRIsize " entries, %d dirs changed, listing %.1f ms, entries %.1f ms\n",
+           cache_loaded ? "from cache" : "full", listing.size(), changed_dirs,
+           (time_listing - time_start) * 1e-3, (time_end - time_listing) * 1e-3);
+
+    if (result && !cache_path.empty() && (!cache_loaded || changed_dirs)) {
+        save_scan_cache(cache_path, root, root_mtime, listing);
+    }
+    return result;
+}
+
 int file_open(const char* path, int oflags, int sflags) {
     //File may not exist, so we need to convert only parent path
     bool parent_only = oflags & _O_CREAT;
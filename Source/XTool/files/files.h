@@ -94,6 +94,10 @@ std::string convert_path_posix(const std::string& path);
 //Do a conversion from path key to filesystem entry path_content
 std::string convert_path_content(const std::string& path, bool parent_only = false);
 
+//Converts path into key used for filesystem entries: native separators, lowercase and relative to content root,
+//can be used to index other resources by path so different spellings of same path map to same key
+std::string convert_path_key(std::string path);
+
 //Obtain filesystem entry from path key
 filesystem_entry* get_content_entry(std::string path);
 
@@ -123,6 +127,11 @@ const std::string& get_content_root_path_str();
 //Removes the source path in each scanned path before saving to internal resource path list to destination path
 bool scan_resource_paths(std::string destination_path = "", std::string source_path = "", const filesystem_scan_options* options = nullptr);
 
+//Same as scan_resource_paths("./") for content root, but keeps listing of content dirs in cache_path file.
+//Only dirs which last write time changed since cache was written are listed again,
+//updated cache is written in background. Empty cache_path does a full scan
+bool scan_resource_paths_cached(const std::string& cache_path);
+
 //Usual POSIX open but with path conversion
 int file_open(const char* path, int oflags, int sflags = 0);
 
@@ -0,0 +1,28 @@
+#ifndef __XJOBS_H
+#define __XJOBS_H
+
+#include <functional>
+
+//Simple pool of worker threads for data parallel jobs.
+//Jobs must not depend on the order of execution, results have to be
+//written into per index slots so the outcome is the same for any threads count.
+
+///Starts worker threads, count is threads total including caller,
+///-1 means "jobs=N" command line switch or CPU count
+void parallel_init(int threads = -1);
+
+///Stops and joins worker threads
+void parallel_finit();
+
+///How many threads can execute jobs at the same time, including caller
+int parallel_threads();
+
+///Index of current thread in [0, parallel_threads()), 0 for caller and threads outside of pool,
+///can be used to keep per thread counters inside of jobs
+int parallel_thread_index();
+
+///Calls fn(i) for each i in [0, count) and returns when all calls are done,
+///caller thread executes jobs too. Calls made from inside of a job run sequentially
+void parallel_for(int count, const std::function<void(int)>& fn);
+
+#endif